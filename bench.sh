@@ -0,0 +1,50 @@
+#!/bin/bash
+# Benchmarks of tiling, of the leaf file writes and of segmentation on synthetic data (same seed, same data).
+# Results go to bench_results/<commit>_<benchmark>.json; with a baseline commit, a throughput loss
+# over the tolerance makes the script fail.
+#
+#   ./bench.sh [points] [baseline commit]
+SCRIPT_DIR=$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )
+
+N_POINTS=${1:-1000000}
+BASELINE=$2
+TOLERANCE=10
+
+mkdir -p ${SCRIPT_DIR}/build
+cd ${SCRIPT_DIR}/build
+cmake -DBUILD_BENCHMARKS=ON ../src/ || exit 1
+cmake --build . --parallel 16 || exit 1
+
+RESULTS=${SCRIPT_DIR}/bench_results
+WORK_DIR=${SCRIPT_DIR}/bench_work
+COMMIT=$(git -C ${SCRIPT_DIR} rev-parse --short HEAD)
+
+mkdir -p ${RESULTS}
+rm -rf ${WORK_DIR}
+mkdir -p ${WORK_DIR}
+
+FAILED=0
+
+run_bench()
+{
+	NAME=$1
+	shift
+
+	COMPARE=""
+	if [ -n "${BASELINE}" ]; then
+		COMPARE="--baseline ${RESULTS}/${BASELINE}_${NAME}.json --tolerance ${TOLERANCE}"
+	fi
+
+	echo "=============================="
+	echo "BENCHMARK: ${NAME} ..."
+	"$@" --json ${RESULTS}/${COMMIT}_${NAME}.json ${COMPARE} || FAILED=1
+	echo "=============================="
+}
+
+run_bench tiling ${SCRIPT_DIR}/build/bsp/bench_tiling -n ${N_POINTS} -w ${WORK_DIR}
+run_bench file_manager ${SCRIPT_DIR}/build/bsp/bench_file_manager -w ${WORK_DIR}
+run_bench ransac ${SCRIPT_DIR}/build/ransac/bench_ransac -n 200000
+
+rm -rf ${WORK_DIR}
+
+exit ${FAILED}
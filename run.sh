@@ -12,6 +12,9 @@ cd ${SCRIPT_DIR}/build/bsp
 cd ${SCRIPT_DIR}/build/ransac
 
 FILES="${SCRIPT_DIR}/output/*.xyz"
+METRICS=${SCRIPT_DIR}/output/ransac_metrics.jsonl
+rm -f ${METRICS}
+
 for f in $FILES
 do
 	echo "=============================="
@@ -19,7 +22,9 @@ do
 	OUT_DIR="${f%.*}"
 	mkdir -p ${OUT_DIR}
 	# take action on each file. $f store current file name
-	./ransac -i $f -P -C -S -o ${OUT_DIR}
+	./ransac -i $f -P -C -S -o ${OUT_DIR} -m ${METRICS}
 	echo "=============================="
 done
 
+# per tile timings and results, slowest tiles first
+./ransac_summary -i ${METRICS}
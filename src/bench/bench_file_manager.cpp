@@ -0,0 +1,334 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+#include "bench_report.h"
+#include "bsp.h"
+#include "file_manager.h"
+#include "urban_scene.h"
+#include "tclap/CmdLine.h"
+
+// Microbenchmark of the writes of the fill to the leaf files: the same points, in different orders, classified
+// (current cell first, as the fill does) and written through the FileManager, for bsp of different leaf counts.
+// Orders are those of the inputs: coherent (tile by tile, z-order), scan-line (rows across the whole extent) and
+// shuffled. With more leaves than open files, they differ in the evictions and the (re)openings of the leaf files.
+
+static const double BENCH_EXTENT          = 1000;     // m, side of the square of the points
+static const double BENCH_HEIGHT          = 20;
+static const int    BENCH_SAMPLES_PER_LEAF = 64;      // of the sample the bsp is created from
+static const int    BENCH_SCAN_LINES       = 4096;
+
+struct BenchPoint
+{
+    double x, y, z;
+};
+
+// write system calls of the process so far (Linux only, 0 elsewhere)
+static uint64_t write_syscalls ()
+{
+    std::ifstream io ("/proc/self/io");
+    std::string key;
+    uint64_t value;
+
+    while (io >> key >> value)
+        if (key.compare("syscw:") == 0)
+            return value;
+
+    return 0;
+}
+
+static std::vector<int> parse_list (const std::string &list)
+{
+    std::vector<int> values;
+    std::stringstream ss (list);
+    std::string item;
+
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            values.push_back(std::atoi(item.c_str()));
+
+    return values;
+}
+
+static std::vector<std::string> parse_names (const std::string &list)
+{
+    std::vector<std::string> names;
+    std::stringstream ss (list);
+    std::string item;
+
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            names.push_back(item);
+
+    return names;
+}
+
+// interleaved bits of the 16 bit cell coordinates of the point
+static uint64_t morton_code (const BenchPoint &p)
+{
+    const uint32_t cx = std::min(65535.0, p.x / BENCH_EXTENT * 65536);
+    const uint32_t cy = std::min(65535.0, p.y / BENCH_EXTENT * 65536);
+
+    uint64_t code = 0;
+
+    for (int b = 0; b < 16; b++)
+        code |= ((uint64_t) ((cx >> b) & 1) << (2 * b)) | ((uint64_t) ((cy >> b) & 1) << (2 * b + 1));
+
+    return code;
+}
+
+static bool order_points (const std::string &order, const uint64_t seed, std::vector<BenchPoint> &points)
+{
+    if (order.compare("coherent") == 0)
+    {
+        std::sort(points.begin(), points.end(), [](const BenchPoint &a, const BenchPoint &b) { return morton_code(a) < morton_code(b); });
+    }
+    else
+    if (order.compare("scanline") == 0)
+    {
+        const double line = BENCH_EXTENT / BENCH_SCAN_LINES;
+
+        std::sort(points.begin(), points.end(), [=](const BenchPoint &a, const BenchPoint &b)
+        {
+            const int la = a.y / line, lb = b.y / line;
+            return (la != lb) ? la < lb : a.x < b.x;
+        });
+    }
+    else
+    if (order.compare("shuffled") == 0)
+    {
+        SceneRandom random (seed + 1);
+
+        for (size_t i = points.size() - 1; i > 0; i--)
+            std::swap(points[i], points[random.next() % (i + 1)]);
+    }
+    else
+    {
+        std::cerr << "[ERROR] Unknown order " << order << " (coherent, scanline, shuffled)" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// bsp of about n_leaves leaves on the square, from a uniform sample
+static BinarySpacePartition *create_bsp (const int n_leaves, const std::string &work_directory, const uint64_t seed)
+{
+    const std::string sample_filename = work_directory + "V_downsample";
+
+    std::ofstream sample (sample_filename.c_str(), std::ios::out | std::ios::binary);
+
+    if (!sample.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << sample_filename << std::endl;
+        exit(1);
+    }
+
+    SceneRandom random (seed);
+
+    const int n_samples = n_leaves * BENCH_SAMPLES_PER_LEAF;
+
+    for (int i = 0; i < n_samples; i++)
+    {
+        const double p[3] = { random.uniform(0, BENCH_EXTENT), random.uniform(0, BENCH_EXTENT), random.uniform(0, BENCH_HEIGHT) };
+        sample.write(reinterpret_cast<const char *>(p), sizeof p);
+    }
+
+    sample.close();
+
+    BspCell root (Vtx(0, 0, 0), Vtx(BENCH_EXTENT, BENCH_EXTENT, BENCH_HEIGHT));
+    root.is_bsp_root = true;
+    root.n_inner_vertices = n_samples;
+    root.filename_inner_v = sample_filename;
+
+    BinarySpacePartition *bsp = new BinarySpacePartition(root);
+
+    // cells of about BENCH_SAMPLES_PER_LEAF samples are not split, those of twice as many are
+    bsp->create(BENCH_SAMPLES_PER_LEAF * 3 / 2, work_directory);
+
+    return bsp;
+}
+
+int main(int argc, char **argv)
+{
+    TCLAP::CmdLine cmd("Usage: bench_file_manager --work <directory> [--points <n>] [--leaves <n,n,...>] [--orders <order,...>]", ' ', "0.9");
+
+    TCLAP::ValueArg<std::string> workArg("w","work","work directory (leaf files)",true,"","string");
+    cmd.add( workArg );
+
+    TCLAP::ValueArg<std::string> pointsArg("n","points","points written in each run (default: 500000)",false,"","int");
+    cmd.add( pointsArg );
+
+    TCLAP::ValueArg<std::string> leavesArg("l","leaves","leaf counts of the bsp (default: 16,64,256,1024)",false,"","string");
+    cmd.add( leavesArg );
+
+    TCLAP::ValueArg<std::string> ordersArg("","orders","orders of the points (default: coherent,scanline,shuffled)",false,"","string");
+    cmd.add( ordersArg );
+
+    TCLAP::ValueArg<std::string> resolutionArg("r","resolution","quantization step of the leaf files (default: 0, raw coordinates)",false,"","double");
+    cmd.add( resolutionArg );
+
+    TCLAP::ValueArg<std::string> seedArg("","seed","seed of the points (default: 1)",false,"","int");
+    cmd.add( seedArg );
+
+    TCLAP::ValueArg<std::string> jsonArg("","json","save the results to this JSON file",false,"","string");
+    cmd.add( jsonArg );
+
+    TCLAP::ValueArg<std::string> baselineArg("","baseline","results of a previous run (--json) to compare with: exit code 1 on regressions",false,"","string");
+    cmd.add( baselineArg );
+
+    TCLAP::ValueArg<std::string> toleranceArg("","tolerance","throughput loss tolerated against the baseline, in percent (default: 10)",false,"","double");
+    cmd.add( toleranceArg );
+
+    cmd.parse( argc, argv );
+
+    std::string work_directory = workArg.getValue();
+
+    if (work_directory.back() != '/')
+        work_directory += "/";      // cell files are named by appending to it
+
+    const unsigned long long n_points = pointsArg.isSet() ? std::strtoull(pointsArg.getValue().c_str(), nullptr, 10) : 500000;
+    const std::string leaves_list = leavesArg.isSet() ? leavesArg.getValue() : "16,64,256,1024";
+    const std::string orders_list = ordersArg.isSet() ? ordersArg.getValue() : "coherent,scanline,shuffled";
+    const double resolution = resolutionArg.isSet() ? std::atof(resolutionArg.getValue().c_str()) : 0;
+    const unsigned long long seed = seedArg.isSet() ? std::strtoull(seedArg.getValue().c_str(), nullptr, 10) : 1;
+    const double tolerance = toleranceArg.isSet() ? std::atof(toleranceArg.getValue().c_str()) / 100 : 0.1;
+
+    const std::vector<int> leaf_counts = parse_list(leaves_list);
+    const std::vector<std::string> orders = parse_names(orders_list);
+
+    if (n_points == 0 || leaf_counts.empty() || orders.empty())
+    {
+        std::cerr << "[ERROR] No points, leaf counts or orders" << std::endl;
+        return 1;
+    }
+
+    BenchReport report;
+    report.benchmark = "file_manager";
+
+    report.add_parameter("points", std::to_string(n_points));
+    report.add_parameter("leaves", leaves_list);
+    report.add_parameter("orders", orders_list);
+    report.add_parameter("resolution", std::to_string(resolution));
+    report.add_parameter("seed", std::to_string(seed));
+    report.add_parameter("max_open_file", std::to_string(FileManager().max_open_file));
+
+    // the same points in every run, only their order changes
+    std::vector<BenchPoint> points (n_points);
+
+    SceneRandom random (seed);
+
+    for (BenchPoint &p : points)
+    {
+        p.x = random.uniform(0, BENCH_EXTENT);
+        p.y = random.uniform(0, BENCH_EXTENT);
+        p.z = random.uniform(0, BENCH_HEIGHT);
+    }
+
+    std::stringstream table;
+
+    table << std::left << std::setw(20) << "run" << std::right << std::setw(8) << "leaves" << std::setw(14) << "points/s"
+          << std::setw(10) << "hits %" << std::setw(10) << "opens" << std::setw(11) << "evictions" << std::setw(12) << "write calls" << std::endl;
+
+    for (const std::string &order : orders)
+    {
+        if (!order_points(order, seed, points))
+            return 1;
+
+        for (const int n_leaves : leaf_counts)
+        {
+            std::unique_ptr<BinarySpacePartition> bsp (create_bsp(n_leaves, work_directory, seed));
+
+            bsp->set_resolution(resolution);
+
+            const uint64_t first_syscalls = write_syscalls();
+
+            stxxl::uint64 hits = 0;
+            FileManagerCounters counters;
+
+            BenchTimer timer (report, order + "_" + std::to_string(n_leaves));
+
+            {
+                FileManager file_manager (bsp.get(), nullptr, false);
+
+                BspCell *cell = bsp->get_leaf(0);
+
+                // the classification loop of the fill
+                for (stxxl::uint64 vid = 0; vid < points.size(); vid++)
+                {
+                    const BenchPoint &p = points[vid];
+
+                    if (cell->hasPoint(p.x, p.y, p.z))
+                        hits++;
+                    else
+                        cell = bsp->locate_leaf(p.x, p.y, p.z);
+
+                    file_manager.write_vertex(cell->leaf_ID, vid, p.x, p.y, p.z);
+                }
+
+                file_manager.close_all();
+
+                counters = file_manager.counters;
+            }
+
+            timer.stage.points = points.size();
+            timer.stage.bytes  = counters.bytes_written;
+            timer.stop();
+
+            const uint64_t syscalls = write_syscalls() - first_syscalls;
+
+            table << std::left << std::setw(20) << timer.stage.name << std::right << std::setw(8) << bsp->get_n_leaves()
+                  << std::setw(14) << std::fixed << std::setprecision(0) << timer.stage.points_per_second()
+                  << std::setw(10) << std::setprecision(1) << 100.0 * hits / points.size()
+                  << std::setw(10) << counters.files_opened << std::setw(11) << counters.evictions << std::setw(12) << syscalls << std::endl;
+
+            for (unsigned int l = 0; l < bsp->get_n_leaves(); l++)
+                remove(bsp->get_leaf(l)->filename_inner_v.c_str());
+        }
+    }
+
+    std::cout << std::endl << table.str() << std::endl;
+
+    report.print();
+
+    if (jsonArg.isSet() && !report.save_json(jsonArg.getValue()))
+        return 1;
+
+    if (baselineArg.isSet() && !report.compare(baselineArg.getValue(), tolerance))
+        return 1;
+
+    return 0;
+}
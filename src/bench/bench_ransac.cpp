@@ -0,0 +1,252 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "bench_report.h"
+#include "pc_reader.h"
+#include "urban_scene.h"
+
+#include <PointCloud.h>
+#include <RansacShapeDetector.h>
+#include <PlanePrimitiveShapeConstructor.h>
+#include <CylinderPrimitiveShapeConstructor.h>
+#include <SpherePrimitiveShapeConstructor.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+#include <tclap/CmdLine.h>
+
+// Benchmark of the per tile shape detection (normals and RANSAC, with the defaults of ransac) on a synthetic urban
+// block, whose primitives are known, or on given tiles.
+
+static void detect (const MiscLib::Vector<Point> &points, BenchReport &report, size_t &n_shapes, size_t shapes_by_type[3])
+{
+    PointCloud pc;
+
+    Vec3f bbmin, bbmax;
+
+    bbmin.setValue(0,0,0);
+    bbmax.setValue(-FLT_MAX,-FLT_MAX,-FLT_MAX);
+
+    for (uint i=0; i<points.size(); i++)
+    {
+        Point point = points.at(i);
+
+        pc.push_back(point);
+
+        for (int c=0; c<3; c++)
+            bbmax[c] = std::max(bbmax[c], point.pos[c]);
+    }
+
+    pc.setBBox(bbmin, bbmax);
+
+    BenchTimer normals (report, "normals");
+
+    pc.calcNormals(3);
+
+    normals.stage.points = pc.size();
+    normals.stop();
+
+    RansacShapeDetector::Options ransacOptions;
+    ransacOptions.m_epsilon = 0.05f / 3.0;
+    ransacOptions.m_bitmapEpsilon = 0.1f;
+    ransacOptions.m_normalThresh = .99f;
+    ransacOptions.m_minSupport = 0.005 * points.size();
+    ransacOptions.m_probability = .01f;
+
+    RansacShapeDetector detector(ransacOptions);
+
+    detector.Add(new PlanePrimitiveShapeConstructor());
+    detector.Add(new CylinderPrimitiveShapeConstructor());
+    detector.Add(new SpherePrimitiveShapeConstructor());
+
+    MiscLib::Vector< std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > > shapes;
+
+    BenchTimer detection (report, "detection");
+
+    detector.Detect(pc, 0, pc.size(), &shapes);
+
+    detection.stage.points = pc.size();
+    detection.stop();
+
+    n_shapes = shapes.size();
+
+    for (uint i=0; i<shapes.size(); i++)
+    {
+        std::string desc;
+        shapes[i].first->Description(&desc);
+
+        if (desc.compare("Plane") == 0)    shapes_by_type[SCENE_PLANE]++;
+        if (desc.compare("Cylinder") == 0) shapes_by_type[SCENE_CYLINDER]++;
+        if (desc.compare("Sphere") == 0)   shapes_by_type[SCENE_SPHERE]++;
+    }
+}
+
+// stages of the same name over all the tiles, merged
+static void merge_stages (BenchReport &report)
+{
+    std::vector<BenchStage> merged;
+
+    for (const BenchStage &s : report.stages)
+    {
+        auto m = std::find_if(merged.begin(), merged.end(), [&](const BenchStage &o) { return o.name == s.name; });
+
+        if (m == merged.end())
+            merged.push_back(s);
+        else
+        {
+            m->seconds += s.seconds;
+            m->points  += s.points;
+            m->bytes   += s.bytes;
+        }
+    }
+
+    report.stages = merged;
+}
+
+int main(int argc, char **argv)
+{
+    TCLAP::CmdLine cmd("Usage: bench_ransac [--points <n> | --input <tile> ...]", ' ', "0.9");
+
+    TCLAP::ValueArg<std::string> pointsArg("n","points","synthetic urban block of this many points (default: 200000)",false,"","int");
+    cmd.add( pointsArg );
+
+    TCLAP::MultiArg<std::string> inputArg("i","input","tile (.xyz) instead of the synthetic block (repeat it for more tiles)",false,"string");
+    cmd.add( inputArg );
+
+    TCLAP::ValueArg<std::string> seedArg("","seed","seed of the synthetic block (default: 1)",false,"","int");
+    cmd.add( seedArg );
+
+    TCLAP::ValueArg<std::string> jsonArg("","json","save the results to this JSON file",false,"","string");
+    cmd.add( jsonArg );
+
+    TCLAP::ValueArg<std::string> baselineArg("","baseline","results of a previous run (--json) to compare with: exit code 1 on regressions",false,"","string");
+    cmd.add( baselineArg );
+
+    TCLAP::ValueArg<std::string> toleranceArg("","tolerance","throughput loss tolerated against the baseline, in percent (default: 10)",false,"","double");
+    cmd.add( toleranceArg );
+
+    cmd.parse( argc, argv );
+
+    const unsigned long long n_points = pointsArg.isSet() ? std::strtoull(pointsArg.getValue().c_str(), nullptr, 10) : 200000;
+    const unsigned long long seed = seedArg.isSet() ? std::strtoull(seedArg.getValue().c_str(), nullptr, 10) : 1;
+    const double tolerance = toleranceArg.isSet() ? std::atof(toleranceArg.getValue().c_str()) / 100 : 0.1;
+
+    BenchReport report;
+    report.benchmark = "ransac";
+
+    size_t n_shapes = 0;
+    size_t shapes_by_type[3] = {0, 0, 0};
+
+    if (inputArg.getValue().empty())
+    {
+        report.add_parameter("points", std::to_string(n_points));
+        report.add_parameter("seed", std::to_string(seed));
+
+        // a single block: its density gives n_points
+        UrbanScene scene (n_points, seed, 0.01, n_points / (UrbanScene::BLOCK_SIZE * UrbanScene::BLOCK_SIZE));
+
+        MiscLib::Vector<Point> points;
+        double x, y, z, min[3] = {DBL_MAX, DBL_MAX, DBL_MAX};
+
+        while (scene.next(x, y, z))
+        {
+            points.push_back(Point(Vec3f(x, y, z)));
+
+            min[0] = std::min(min[0], x); min[1] = std::min(min[1], y); min[2] = std::min(min[2], z);
+        }
+
+        for (uint i=0; i<points.size(); i++)
+        {
+            points[i].pos = Vec3f(points[i].pos[0] - min[0], points[i].pos[1] - min[1], points[i].pos[2] - min[2]);
+            points[i].index = i;
+        }
+
+        detect(points, report, n_shapes, shapes_by_type);
+
+        size_t truth[3] = {0, 0, 0};
+
+        for (const ScenePrimitive &p : scene.get_block_primitives(0))
+            truth[p.type]++;
+
+        std::cout << "[BENCH] Shapes: " << n_shapes << " detected (" << shapes_by_type[SCENE_PLANE] << " planes, " << shapes_by_type[SCENE_CYLINDER]
+                  << " cylinders, " << shapes_by_type[SCENE_SPHERE] << " spheres), in the block " << truth[SCENE_PLANE] << " planes, "
+                  << truth[SCENE_CYLINDER] << " cylinders, " << truth[SCENE_SPHERE] << " spheres" << std::endl;
+    }
+    else
+    {
+        report.add_parameter("tiles", std::to_string(inputArg.getValue().size()));
+
+        for (const std::string &tile : inputArg.getValue())
+        {
+            MiscLib::Vector<Point> points;
+            std::vector<PointFeatures> features;
+            unsigned int feature_mask = 0;
+            double minx, miny, minz, maxx, maxy, maxz;
+
+            BenchTimer load (report, "load");
+
+            if (!read_input_pc(tile, points, features, feature_mask, minx, miny, minz, maxx, maxy, maxz))
+                return 1;
+
+            load.stage.points = points.size();
+            load.stop();
+
+            const size_t first_stage = report.stages.size();
+
+            size_t tile_shapes = 0;
+
+            detect(points, report, tile_shapes, shapes_by_type);
+
+            n_shapes += tile_shapes;
+
+            double seconds = 0;
+
+            for (size_t s = first_stage; s < report.stages.size(); s++)
+                seconds += report.stages.at(s).seconds;
+
+            std::cout << "[BENCH] " << tile << ": " << points.size() << " points, " << tile_shapes << " shapes, " << seconds << " s" << std::endl;
+        }
+
+        merge_stages(report);
+
+        std::cout << "[BENCH] Shapes: " << n_shapes << " detected (" << shapes_by_type[SCENE_PLANE] << " planes, " << shapes_by_type[SCENE_CYLINDER]
+                  << " cylinders, " << shapes_by_type[SCENE_SPHERE] << " spheres)" << std::endl;
+    }
+
+    report.print();
+
+    if (jsonArg.isSet() && !report.save_json(jsonArg.getValue()))
+        return 1;
+
+    if (baselineArg.isSet() && !report.compare(baselineArg.getValue(), tolerance))
+        return 1;
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "bench_report.h"
+#include "peak_rss.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+BenchTimer::BenchTimer (BenchReport &report, const std::string &name)
+{
+    this->report = &report;
+    this->start  = std::chrono::steady_clock::now();
+
+    stage.name = name;
+}
+
+void BenchTimer::stop ()
+{
+    stage.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    report->stages.push_back(stage);
+}
+
+void BenchReport::print () const
+{
+    std::cout << std::endl << "[BENCH] " << benchmark;
+
+    for (const auto &p : parameters)
+        std::cout << " " << p.first << "=" << p.second;
+
+    std::cout << std::endl;
+
+    std::cout << std::left << std::setw(14) << "stage" << std::right
+              << std::setw(12) << "seconds" << std::setw(14) << "points" << std::setw(14) << "points/s" << std::setw(12) << "MB/s" << std::endl;
+
+    for (const BenchStage &s : stages)
+    {
+        std::cout << std::left << std::setw(14) << s.name << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(12) << s.seconds
+                  << std::setw(14) << s.points
+                  << std::setprecision(0) << std::setw(14) << s.points_per_second()
+                  << std::setprecision(1) << std::setw(12) << ((s.seconds > 0) ? s.bytes / s.seconds / (1024 * 1024) : 0) << std::endl;
+    }
+
+    std::cout << std::defaultfloat << "peak RSS: " << get_peak_rss() / (1024 * 1024) << " MB" << std::endl;
+}
+
+bool BenchReport::save_json (const std::string &filename) const
+{
+    std::ofstream os (filename.c_str(), std::ios::out);
+
+    if (!os.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << filename << std::endl;
+        return false;
+    }
+
+    os << std::setprecision(15);
+
+    os << "{" << std::endl;
+    os << "  \"benchmark\": \"" << benchmark << "\"," << std::endl;
+    os << "  \"parameters\": {";
+
+    for (unsigned int p = 0; p < parameters.size(); p++)
+        os << ((p > 0) ? ", " : " ") << "\"" << parameters.at(p).first << "\": \"" << parameters.at(p).second << "\"";
+
+    os << " }," << std::endl;
+    os << "  \"peak_rss_bytes\": " << get_peak_rss() << "," << std::endl;
+    os << "  \"stages\": [" << std::endl;
+
+    for (unsigned int s = 0; s < stages.size(); s++)
+    {
+        const BenchStage &stage = stages.at(s);
+
+        os << "    { \"name\": \"" << stage.name << "\", \"seconds\": " << stage.seconds << ", \"points\": " << stage.points
+           << ", \"bytes\": " << stage.bytes << ", \"points_per_second\": " << stage.points_per_second() << " }"
+           << ((s + 1 < stages.size()) ? "," : "") << std::endl;
+    }
+
+    os << "  ]" << std::endl;
+    os << "}" << std::endl;
+
+    os.close();
+
+    if (os.fail())
+    {
+        std::cerr << "[ERROR] Writing file " << filename << std::endl;
+        return false;
+    }
+
+    std::cout << "[OUTPUT] Benchmark results saved: " << filename << std::endl;
+
+    return true;
+}
+
+// value of "key": "..." or "key": number in a line of save_json
+static bool json_field (const std::string &line, const std::string &key, std::string &value)
+{
+    size_t pos = line.find("\"" + key + "\": ");
+
+    if (pos == std::string::npos)
+        return false;
+
+    pos += key.size() + 4;
+
+    if (line[pos] == '"')
+        value = line.substr(pos + 1, line.find('"', pos + 1) - pos - 1);
+    else
+        value = line.substr(pos, line.find_first_of(",}", pos) - pos);
+
+    return true;
+}
+
+bool BenchReport::compare (const std::string &baseline_filename, const double tolerance) const
+{
+    std::ifstream is (baseline_filename.c_str());
+
+    if (!is.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << baseline_filename << std::endl;
+        return false;
+    }
+
+    bool passed = true;
+    std::string line, value, seconds;
+
+    while (std::getline(is, line))
+    {
+        // runs with other parameters are not comparable
+        for (const auto &p : parameters)
+        {
+            if (line.find("\"parameters\"") != std::string::npos && json_field(line, p.first, value) && value != p.second)
+            {
+                std::cerr << "[ERROR] Baseline with " << p.first << "=" << value << " instead of " << p.second << ": not comparable" << std::endl;
+                return false;
+            }
+        }
+
+        std::string name;
+
+        if (!json_field(line, "name", name) || !json_field(line, "points_per_second", value) || !json_field(line, "seconds", seconds))
+            continue;
+
+        const double baseline = std::atof(value.c_str());
+
+        for (const BenchStage &s : stages)
+        {
+            if (s.name != name || baseline <= 0)
+                continue;
+
+            const double change = s.points_per_second() / baseline - 1;
+            const bool gated = s.gated && s.seconds >= BENCH_MIN_GATED_SECONDS && std::atof(seconds.c_str()) >= BENCH_MIN_GATED_SECONDS;
+            const bool regression = gated && change < -tolerance;
+
+            std::cout << (regression ? "[REGRESSION] " : "[COMPARE] ") << name << ": " << std::fixed << std::setprecision(0)
+                      << s.points_per_second() << " vs " << baseline << " points/s (" << std::showpos << std::setprecision(1) << 100 * change
+                      << std::noshowpos << "%)" << (gated ? "" : " not gated") << std::defaultfloat << std::endl;
+
+            passed = passed && !regression;
+        }
+    }
+
+    return passed;
+}
@@ -0,0 +1,99 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Results of a benchmark run: the parameters (runs are comparable only if they match) and, by stage, time,
+// points and bytes. Saved as JSON, one stage per line, and compared with the results of a previous commit.
+
+#define BENCH_MIN_GATED_SECONDS 0.1
+
+struct BenchStage
+{
+    std::string name;
+
+    double seconds = 0;
+
+    uint64_t points = 0;
+    uint64_t bytes  = 0;    // read and written
+
+    bool gated = true;      // compared with the baseline (not e.g. the generation of the input)
+
+    double points_per_second () const { return (seconds > 0) ? points / seconds : 0; }
+};
+
+struct BenchReport
+{
+    std::string benchmark;
+
+    std::vector<std::pair<std::string, std::string>> parameters;
+
+    std::vector<BenchStage> stages;
+
+    void add_parameter (const std::string &name, const std::string &value) { parameters.push_back(std::make_pair(name, value)); }
+
+    void print () const;
+
+    bool save_json (const std::string &filename) const;
+
+    // Stages whose throughput is more than tolerance (fraction) below the baseline: [REGRESSION] lines.
+    // False if any, or if the baseline cannot be read. Stages shorter than BENCH_MIN_GATED_SECONDS are too noisy to gate.
+    bool compare (const std::string &baseline_filename, const double tolerance) const;
+};
+
+// Times a stage into the report, from construction to stop
+class BenchTimer
+{
+private:
+
+    BenchReport *report;
+
+    std::chrono::steady_clock::time_point start;
+
+public:
+
+    BenchStage stage;
+
+    BenchTimer (BenchReport &report, const std::string &name);
+
+    void stop ();
+};
+
+#ifndef OOC3DTileLib_STATIC
+#include "bench_report.cpp"
+#endif
+
+#endif // BENCH_REPORT_H
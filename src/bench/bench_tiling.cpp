@@ -0,0 +1,299 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <numeric>
+
+#include "bench_report.h"
+#include "dirent.h"
+#include "pc_bsp.h"
+#include "task_pool.h"
+#include "tiling_stats.h"
+#include "urban_scene.h"
+#include "write_xyz.h"
+#include "tclap/CmdLine.h"
+
+// Benchmark of the tiling stages, one at a time, on the synthetic urban cloud (or on given XYZ/LAS files):
+// ingest, bsp construction, point location, fill and tile writing. Defaults are single threaded, so that runs on
+// the same machine are comparable across commits (--baseline).
+
+using namespace OOC3DTileLib;
+
+static const stxxl::uint64 BENCH_LOCATE_POINTS = 1000000;     // queries of the point location stage,
+static const int           BENCH_LOCATE_PASSES = 10;          // located this many times (long enough to be timed)
+
+int main(int argc, char **argv)
+{
+    TCLAP::CmdLine cmd("Usage: bench_tiling [--points <n> | --file <filename> | --dir <directory>] --work <directory>", ' ', "0.9");
+
+    TCLAP::ValueArg<std::string> pointsArg("n","points","synthetic urban cloud of this many points (default: 1000000)",false,"","int");
+    cmd.add( pointsArg );
+
+    TCLAP::ValueArg<std::string> fileArg("f","file","input file, instead of the synthetic cloud",false,"","string");
+    cmd.add( fileArg );
+
+    TCLAP::ValueArg<std::string> dirArg("d","dir","directory of input files (.xyz, .las), instead of the synthetic cloud",false,"","string");
+    cmd.add( dirArg );
+
+    TCLAP::ValueArg<std::string> workArg("w","work","work directory (input, intermediate files and tiles)",true,"","string");
+    cmd.add( workArg );
+
+    TCLAP::ValueArg<std::string> maxvArg("v","verts","max number of vertex for tile (default: 100000)",false,"","int");
+    cmd.add( maxvArg );
+
+    TCLAP::ValueArg<std::string> threadsArg("t","threads","number of threads (default: 1)",false,"","int");
+    cmd.add( threadsArg );
+
+    TCLAP::ValueArg<std::string> resolutionArg("r","resolution","quantization step of the intermediate files (default: 0, raw coordinates)",false,"","double");
+    cmd.add( resolutionArg );
+
+    TCLAP::ValueArg<std::string> seedArg("","seed","seed of the synthetic cloud (default: 1)",false,"","int");
+    cmd.add( seedArg );
+
+    TCLAP::ValueArg<std::string> jsonArg("","json","save the results to this JSON file",false,"","string");
+    cmd.add( jsonArg );
+
+    TCLAP::ValueArg<std::string> baselineArg("","baseline","results of a previous run (--json) to compare with: exit code 1 on regressions",false,"","string");
+    cmd.add( baselineArg );
+
+    TCLAP::ValueArg<std::string> toleranceArg("","tolerance","throughput loss tolerated against the baseline, in percent (default: 10)",false,"","double");
+    cmd.add( toleranceArg );
+
+    cmd.parse( argc, argv );
+
+    std::string work_directory = workArg.getValue();
+
+    if (work_directory.back() != '/')
+        work_directory += "/";      // cell files are named by appending to it
+
+    const int max_verts = maxvArg.isSet() ? std::atoi(maxvArg.getValue().c_str()) : 100000;
+    const unsigned int n_threads = threadsArg.isSet() ? std::atoi(threadsArg.getValue().c_str()) : 1;
+    const double resolution = resolutionArg.isSet() ? std::atof(resolutionArg.getValue().c_str()) : 0;
+    const unsigned long long n_points = pointsArg.isSet() ? std::strtoull(pointsArg.getValue().c_str(), nullptr, 10) : 1000000;
+    const unsigned long long seed = seedArg.isSet() ? std::strtoull(seedArg.getValue().c_str(), nullptr, 10) : 1;
+    const double tolerance = toleranceArg.isSet() ? std::atof(toleranceArg.getValue().c_str()) / 100 : 0.1;
+
+    BenchReport report;
+    report.benchmark = "tiling";
+
+    std::vector<std::string> input_filenames;
+
+    if (fileArg.isSet())
+        input_filenames.push_back(fileArg.getValue());
+
+    if (dirArg.isSet())
+    {
+        DIR *dir = opendir(dirArg.getValue().c_str());
+        struct dirent *ent;
+
+        if (dir == NULL)
+        {
+            perror ("");
+            return 1;
+        }
+
+        while ((ent = readdir(dir)) != NULL)
+        {
+            const std::string path = dirArg.getValue() + "/" + ent->d_name;
+            const size_t ext_pos = path.find_last_of(".");
+            const std::string ext = (ext_pos != std::string::npos) ? path.substr(ext_pos) : "";
+
+            if (ext.compare(".xyz") == 0 || ext.compare(".las") == 0)
+                input_filenames.push_back(path);
+        }
+
+        closedir(dir);
+
+        std::sort(input_filenames.begin(), input_filenames.end());
+    }
+
+    if (input_filenames.empty())
+    {
+        report.add_parameter("points", std::to_string(n_points));
+        report.add_parameter("seed", std::to_string(seed));
+    }
+    else
+        report.add_parameter("input", fileArg.isSet() ? fileArg.getValue() : dirArg.getValue());
+
+    report.add_parameter("verts", std::to_string(max_verts));
+    report.add_parameter("threads", std::to_string(n_threads));
+    report.add_parameter("resolution", std::to_string(resolution));
+
+    // Input: the synthetic cloud (not part of the tiling throughput, reported anyway)
+    if (input_filenames.empty())
+    {
+        BenchTimer generate (report, "generate");
+
+        const std::string filename = work_directory + "urban_0.xyz";
+
+        FILE *file = std::fopen(filename.c_str(), "w");
+
+        if (file == nullptr)
+        {
+            std::cerr << "[ERROR] Opening file " << filename << std::endl;
+            return 1;
+        }
+
+        UrbanScene scene (n_points, seed);
+        double x, y, z;
+
+        while (scene.next(x, y, z))
+            std::fprintf(file, "%.3f %.3f %.3f\n", x, y, z);
+
+        std::fclose(file);
+
+        input_filenames.push_back(filename);
+
+        generate.stage.gated  = false;
+        generate.stage.points = n_points;
+        generate.stage.bytes  = get_file_size(filename);
+        generate.stop();
+    }
+
+    stxxl::uint64 input_bytes = 0;
+
+    for (const std::string &f : input_filenames)
+        input_bytes += get_file_size(f);
+
+    const std::string downsample_filename = work_directory + "V_downsample";
+    const std::string binary_filename     = work_directory + "V_binary";
+
+    stxxl::uint64 n_vertices = 0;
+    int n_sample_vertices = 0;
+    Vtx bb_min, bb_max;
+    std::vector<stxxl::uint64> infile2lastv;
+
+    // Ingest: bounding box, sample and binary copy
+    {
+        BenchTimer ingest (report, "ingest");
+
+        if (is_las_file(input_filenames.at(0)))
+            get_bounding_box_and_downsample_and_binary_LAS(input_filenames, downsample_filename, binary_filename, 1000,
+                                                           n_vertices, n_sample_vertices, bb_min, bb_max, infile2lastv, resolution);
+        else
+            get_bounding_box_and_downsample_and_binary_XYZ(input_filenames, downsample_filename, binary_filename, 1000,
+                                                           n_vertices, n_sample_vertices, bb_min, bb_max, resolution);
+
+        ingest.stage.points = n_vertices;
+        ingest.stage.bytes  = input_bytes + get_file_size(binary_filename);
+        ingest.stop();
+    }
+
+    BspCell root (bb_min, bb_max);
+    root.is_bsp_root = true;
+    root.n_inner_vertices = n_sample_vertices;
+    root.filename_inner_v = downsample_filename;
+
+    BinarySpacePartition bsp (root);
+    bsp.set_resolution(resolution);
+
+    // Construction, from the sample
+    {
+        BenchTimer create (report, "create");
+
+        bsp.create(max_verts / 1000, work_directory, n_threads);
+
+        create.stage.points = n_sample_vertices;
+        create.stop();
+    }
+
+    // Point location: the first points of the input, in their order
+    {
+        std::vector<Vtx> queries;
+
+        std::unique_ptr<PointStream> points (open_point_stream(input_filenames.at(0)));
+        Vtx v;
+
+        while (points && queries.size() < BENCH_LOCATE_POINTS && points->read_point(v.x, v.y, v.z))
+            queries.push_back(v);
+
+        BenchTimer locate (report, "locate");
+
+        stxxl::uint64 checksum = 0;
+
+        for (int pass = 0; pass < BENCH_LOCATE_PASSES; pass++)
+            for (const Vtx &q : queries)
+                checksum += bsp.locate_leaf(q.x, q.y, q.z)->leaf_ID;
+
+        locate.stage.points = queries.size() * BENCH_LOCATE_PASSES;
+        locate.stop();
+
+        std::cout << "[BENCH] Located " << queries.size() << " points (checksum " << checksum << ")" << std::endl;
+    }
+
+    // Fill, from the binary copy
+    {
+        BenchTimer fill (report, "fill");
+
+        bsp.fill(binary_filename, input_filenames.size(), false);
+
+        fill.stage.points = n_vertices;
+        fill.stage.bytes  = get_file_size(binary_filename) + bsp.get_fill_counters().bytes_written;
+        fill.stop();
+    }
+
+    // Tiles
+    {
+        std::vector<int> cells (bsp.get_n_cells());
+        std::iota(cells.begin(), cells.end(), 0);
+
+        stxxl::uint64 leaf_bytes = 0;
+
+        for (const int c : cells)
+            leaf_bytes += get_file_size(bsp.get_cell(c)->filename_inner_v);
+
+        BenchTimer write (report, "write");
+
+        write_bsp_XYZ(bsp, work_directory, cells, n_threads);
+
+        stxxl::uint64 tile_bytes = 0;
+
+        for (const int c : cells)
+            tile_bytes += get_file_size(bsp.get_cell(c)->filename_mesh) + get_file_size(bsp.get_cell(c)->filename_local2global);
+
+        write.stage.points = n_vertices;
+        write.stage.bytes  = leaf_bytes + tile_bytes;
+        write.stop();
+    }
+
+    std::cout << "[BENCH] " << bsp.get_n_leaves() << " tiles" << std::endl;
+
+    report.print();
+
+    if (jsonArg.isSet() && !report.save_json(jsonArg.getValue()))
+        return 1;
+
+    if (baselineArg.isSet() && !report.compare(baselineArg.getValue(), tolerance))
+        return 1;
+
+    return 0;
+}
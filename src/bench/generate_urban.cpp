@@ -0,0 +1,111 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "urban_scene.h"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "tclap/CmdLine.h"
+
+// Writes the synthetic urban point cloud of the benchmarks as XYZ files (the input of bsp)
+
+int main(int argc, char **argv)
+{
+    TCLAP::CmdLine cmd("Usage: generate_urban --points <n> --out <directory> [--files <n>] [--seed <s>]", ' ', "0.9");
+
+    TCLAP::ValueArg<std::string> pointsArg("n","points","number of points (e.g. 1000000 ... 1000000000)",true,"","int");
+    cmd.add( pointsArg );
+
+    TCLAP::ValueArg<std::string> outArg("o","out","output directory (urban_<i>.xyz files)",true,"","string");
+    cmd.add( outArg );
+
+    TCLAP::ValueArg<std::string> filesArg("","files","number of files, each with a contiguous part of the cloud (default: 1)",false,"","int");
+    cmd.add( filesArg );
+
+    TCLAP::ValueArg<std::string> seedArg("","seed","seed of the scene (default: 1)",false,"","int");
+    cmd.add( seedArg );
+
+    TCLAP::ValueArg<std::string> noiseArg("","noise","standard deviation of the noise in meters (default: 0.01)",false,"","double");
+    cmd.add( noiseArg );
+
+    TCLAP::ValueArg<std::string> densityArg("","density","average points per square meter of the scene footprint (default: 100)",false,"","double");
+    cmd.add( densityArg );
+
+    cmd.parse( argc, argv );
+
+    const unsigned long long n_points = std::strtoull(pointsArg.getValue().c_str(), nullptr, 10);
+    const unsigned int n_files = filesArg.isSet() ? std::atoi(filesArg.getValue().c_str()) : 1;
+    const unsigned long long seed = seedArg.isSet() ? std::strtoull(seedArg.getValue().c_str(), nullptr, 10) : 1;
+    const double noise = noiseArg.isSet() ? std::atof(noiseArg.getValue().c_str()) : 0.01;
+    const double density = densityArg.isSet() ? std::atof(densityArg.getValue().c_str()) : 100;
+
+    if (n_points == 0 || n_files == 0 || density <= 0)
+    {
+        std::cerr << "The number of points and of files, and the density, MUST be positive" << std::endl;
+        return 1;
+    }
+
+    UrbanScene scene (n_points, seed, noise, density);
+
+    std::cout << "[GENERATE] " << n_points << " points, " << scene.get_n_blocks() << " blocks, "
+              << scene.get_extent() << " x " << scene.get_extent() << " m" << std::endl;
+
+    double x, y, z;
+
+    for (unsigned int f = 0; f < n_files; f++)
+    {
+        const std::string filename = outArg.getValue() + "/urban_" + std::to_string(f) + ".xyz";
+
+        FILE *file = std::fopen(filename.c_str(), "w");
+
+        if (file == nullptr)
+        {
+            std::cerr << "[ERROR] Opening file " << filename << std::endl;
+            return 1;
+        }
+
+        const unsigned long long first = n_points * f / n_files;
+        const unsigned long long last  = n_points * (f + 1) / n_files;
+
+        for (unsigned long long p = first; p < last && scene.next(x, y, z); p++)
+            std::fprintf(file, "%.3f %.3f %.3f\n", x, y, z);
+
+        if (std::fclose(file) != 0)
+        {
+            std::cerr << "[ERROR] Writing file " << filename << std::endl;
+            return 1;
+        }
+
+        std::cout << "[OUTPUT] " << filename << " (" << last - first << " points)" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,307 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "urban_scene.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const double SCENE_PI = 3.14159265358979323846;
+
+uint64_t SceneRandom::next ()
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+double SceneRandom::uniform ()
+{
+    return (next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double SceneRandom::gaussian ()
+{
+    if (has_spare)
+    {
+        has_spare = false;
+        return spare;
+    }
+
+    // Box-Muller
+    const double u1 = 1.0 - uniform();      // (0, 1]
+    const double u2 = uniform();
+
+    const double r = std::sqrt(-2.0 * std::log(u1));
+
+    spare = r * std::sin(2 * SCENE_PI * u2);
+    has_spare = true;
+
+    return r * std::cos(2 * SCENE_PI * u2);
+}
+
+static uint64_t block_seed (const uint64_t seed, const unsigned int b, const uint64_t stream)
+{
+    SceneRandom random (seed * 0x100000001B3ULL + b * 2 + stream);
+    return random.next();
+}
+
+static ScenePrimitive make_plane (const double ox, const double oy, const double oz,
+                                  const double ux, const double uy, const double uz,
+                                  const double vx, const double vy, const double vz, const double factor)
+{
+    ScenePrimitive p;
+
+    p.type = SCENE_PLANE;
+    p.origin[0] = ox; p.origin[1] = oy; p.origin[2] = oz;
+    p.u[0] = ux; p.u[1] = uy; p.u[2] = uz;
+    p.v[0] = vx; p.v[1] = vy; p.v[2] = vz;
+
+    // area: |u x v|
+    const double nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+
+    p.weight = std::sqrt(nx * nx + ny * ny + nz * nz) * factor;
+
+    return p;
+}
+
+static ScenePrimitive make_cylinder (const double x, const double y, const double z, const double radius, const double height, const double factor)
+{
+    ScenePrimitive p;
+
+    p.type = SCENE_CYLINDER;
+    p.center[0] = x; p.center[1] = y; p.center[2] = z;
+    p.radius = radius;
+    p.height = height;
+    p.weight = 2 * SCENE_PI * radius * height * factor;
+
+    return p;
+}
+
+static ScenePrimitive make_sphere (const double x, const double y, const double z, const double radius, const double factor)
+{
+    ScenePrimitive p;
+
+    p.type = SCENE_SPHERE;
+    p.center[0] = x; p.center[1] = y; p.center[2] = z;
+    p.radius = radius;
+    p.weight = 4 * SCENE_PI * radius * radius * factor;
+
+    return p;
+}
+
+void UrbanScene::make_block (const unsigned int b, std::vector<ScenePrimitive> &block_primitives) const
+{
+    SceneRandom layout (block_seed(seed, b, 0));
+
+    block_primitives.clear();
+
+    const double x0 = (b % blocks_per_side) * BLOCK_SIZE;
+    const double y0 = (b / blocks_per_side) * BLOCK_SIZE;
+
+    // ground, slightly sloped: the streets and the yard of the block
+    const double sx = layout.uniform(-0.02, 0.02), sy = layout.uniform(-0.02, 0.02);
+    const double ground_z = (x0 * sx + y0 * sy) * 0.1;
+
+    block_primitives.push_back(make_plane(x0, y0, ground_z, BLOCK_SIZE, 0, BLOCK_SIZE * sx, 0, BLOCK_SIZE, BLOCK_SIZE * sy, 1.0));
+
+    // building: four facades and a flat or gabled roof, each scanned at its own density
+    const double w = layout.uniform(10, 26), d = layout.uniform(10, 26), h = layout.uniform(6, 30);
+    const double bx = x0 + layout.uniform(5, BLOCK_SIZE - 5 - w);
+    const double by = y0 + layout.uniform(5, BLOCK_SIZE - 5 - d);
+
+    block_primitives.push_back(make_plane(bx,     by,     ground_z, w, 0, 0, 0, 0, h, layout.uniform(0.3, 1.5)));
+    block_primitives.push_back(make_plane(bx,     by + d, ground_z, w, 0, 0, 0, 0, h, layout.uniform(0.3, 1.5)));
+    block_primitives.push_back(make_plane(bx,     by,     ground_z, 0, d, 0, 0, 0, h, layout.uniform(0.3, 1.5)));
+    block_primitives.push_back(make_plane(bx + w, by,     ground_z, 0, d, 0, 0, 0, h, layout.uniform(0.3, 1.5)));
+
+    const double roof_factor = layout.uniform(0.5, 2.0);
+
+    if (layout.uniform() < 0.5)
+        block_primitives.push_back(make_plane(bx, by, ground_z + h, w, 0, 0, 0, d, 0, roof_factor));
+    else
+    {
+        const double ridge = layout.uniform(2, 6);
+
+        block_primitives.push_back(make_plane(bx, by,     ground_z + h, w, 0, 0, 0,  d / 2, ridge, roof_factor));
+        block_primitives.push_back(make_plane(bx, by + d, ground_z + h, w, 0, 0, 0, -d / 2, ridge, roof_factor));
+    }
+
+    // street poles, at two corners of the block
+    block_primitives.push_back(make_cylinder(x0 + 1.5, y0 + 1.5, ground_z, 0.15, 6, layout.uniform(0.5, 1.5)));
+    block_primitives.push_back(make_cylinder(x0 + BLOCK_SIZE - 1.5, y0 + 1.5, ground_z, 0.15, 6, layout.uniform(0.5, 1.5)));
+
+    // trees along the street: trunk and crown
+    const int n_trees = static_cast<int>(layout.uniform(0, 4));
+
+    for (int t = 0; t < n_trees; t++)
+    {
+        const double tx = x0 + layout.uniform(3, BLOCK_SIZE - 3);
+        const double ty = y0 + 2.5;
+        const double trunk = layout.uniform(2, 4);
+        const double crown = layout.uniform(1.5, 3);
+        const double factor = layout.uniform(0.5, 1.5);
+
+        block_primitives.push_back(make_cylinder(tx, ty, ground_z, layout.uniform(0.2, 0.4), trunk, factor));
+        block_primitives.push_back(make_sphere(tx, ty, ground_z + trunk + 0.8 * crown, crown, factor));
+    }
+}
+
+UrbanScene::UrbanScene (const uint64_t n_points, const uint64_t seed, const double noise, const double density)
+{
+    this->n_points = n_points;
+    this->seed     = seed;
+    this->noise    = noise;
+    this->density  = density;
+
+    const double area = static_cast<double>(n_points) / density;
+
+    blocks_per_side = std::max(1u, static_cast<unsigned int>(std::sqrt(area) / BLOCK_SIZE + 0.5));
+
+    block_cumulated_weights.push_back(0);
+
+    std::vector<ScenePrimitive> block_primitives;
+
+    for (unsigned int b = 0; b < get_n_blocks(); b++)
+    {
+        make_block(b, block_primitives);
+
+        double weight = 0;
+
+        for (const ScenePrimitive &p : block_primitives)
+            weight += p.weight;
+
+        block_cumulated_weights.push_back(block_cumulated_weights.back() + weight);
+    }
+
+    restart();
+}
+
+uint64_t UrbanScene::points_until_block (const unsigned int b) const
+{
+    return static_cast<uint64_t>(std::llround(n_points * (block_cumulated_weights.at(b) / block_cumulated_weights.back())));
+}
+
+void UrbanScene::start_block (const unsigned int b)
+{
+    block = b;
+
+    make_block(b, primitives);
+
+    cumulated_weights.clear();
+
+    double weight = 0;
+
+    for (const ScenePrimitive &p : primitives)
+    {
+        weight += p.weight;
+        cumulated_weights.push_back(weight);
+    }
+
+    random = SceneRandom(block_seed(seed, b, 1));
+
+    block_end = points_until_block(b + 1);
+}
+
+void UrbanScene::restart ()
+{
+    generated = 0;
+
+    start_block(0);
+}
+
+std::vector<ScenePrimitive> UrbanScene::get_block_primitives (const unsigned int b) const
+{
+    std::vector<ScenePrimitive> block_primitives;
+
+    make_block(b, block_primitives);
+
+    return block_primitives;
+}
+
+bool UrbanScene::next (double &x, double &y, double &z, int *type)
+{
+    if (generated == n_points)
+        return false;
+
+    while (generated == block_end)
+        start_block(block + 1);
+
+    // primitive, by weight
+    const double w = random.uniform() * cumulated_weights.back();
+    const size_t i = std::min(static_cast<size_t>(std::upper_bound(cumulated_weights.begin(), cumulated_weights.end(), w) - cumulated_weights.begin()),
+                              primitives.size() - 1);
+
+    const ScenePrimitive &p = primitives.at(i);
+
+    const double e = noise * random.gaussian();
+
+    if (p.type == SCENE_PLANE)
+    {
+        const double s = random.uniform(), t = random.uniform();
+
+        double n[3] = { p.u[1] * p.v[2] - p.u[2] * p.v[1], p.u[2] * p.v[0] - p.u[0] * p.v[2], p.u[0] * p.v[1] - p.u[1] * p.v[0] };
+        const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+        x = p.origin[0] + s * p.u[0] + t * p.v[0] + e * n[0] / length;
+        y = p.origin[1] + s * p.u[1] + t * p.v[1] + e * n[1] / length;
+        z = p.origin[2] + s * p.u[2] + t * p.v[2] + e * n[2] / length;
+    }
+    else
+    if (p.type == SCENE_CYLINDER)
+    {
+        const double angle = random.uniform(0, 2 * SCENE_PI);
+        const double r = p.radius + e;
+
+        x = p.center[0] + r * std::cos(angle);
+        y = p.center[1] + r * std::sin(angle);
+        z = p.center[2] + random.uniform(0, p.height);
+    }
+    else
+    {
+        const double cos_theta = random.uniform(-1, 1);
+        const double sin_theta = std::sqrt(1 - cos_theta * cos_theta);
+        const double angle = random.uniform(0, 2 * SCENE_PI);
+        const double r = p.radius + e;
+
+        x = p.center[0] + r * sin_theta * std::cos(angle);
+        y = p.center[1] + r * sin_theta * std::sin(angle);
+        z = p.center[2] + r * cos_theta;
+    }
+
+    if (type != nullptr)
+        *type = p.type;
+
+    generated++;
+
+    return true;
+}
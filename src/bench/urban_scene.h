@@ -0,0 +1,143 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#ifndef URBAN_SCENE_H
+#define URBAN_SCENE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Synthetic urban point cloud for benchmarks: a grid of blocks, each with a ground plane, a building (facades and
+// roof planes), street poles (cylinders) and trees (trunk cylinder and spherical crown). Points get gaussian noise and
+// a density that varies by primitive (distance from the scanner). The block size is fixed and the number of blocks
+// grows with the requested points, so the density (and the tiles) stay alike from 1M to 1B points.
+//
+// Points are streamed block by block (spatially coherent, as a survey is), in constant memory, and are a function
+// of the seed only: the same parameters give the same cloud on every run and commit.
+
+enum ScenePrimitiveType
+{
+    SCENE_PLANE    = 0,
+    SCENE_CYLINDER = 1,     // vertical axis
+    SCENE_SPHERE   = 2
+};
+
+struct ScenePrimitive
+{
+    int type = SCENE_PLANE;
+
+    // plane: origin + s u + t v, s and t in [0, 1]
+    double origin[3] = {0, 0, 0};
+    double u[3] = {0, 0, 0};
+    double v[3] = {0, 0, 0};
+
+    // cylinder (base center, vertical) and sphere (center)
+    double center[3] = {0, 0, 0};
+    double radius = 0;
+    double height = 0;
+
+    double weight = 0;      // share of the points of its block: area times density factor
+};
+
+// Deterministic generator (splitmix64): the same stream on every platform
+class SceneRandom
+{
+private:
+
+    uint64_t state;
+
+    bool has_spare = false;
+    double spare = 0;
+
+public:
+
+    SceneRandom (const uint64_t seed = 1) : state(seed) {}
+
+    uint64_t next ();
+
+    double uniform ();                                  // [0, 1)
+    double uniform (const double a, const double b) { return a + (b - a) * uniform(); }
+    double gaussian ();                                 // mean 0, standard deviation 1
+};
+
+class UrbanScene
+{
+private:
+
+    uint64_t n_points;
+    uint64_t seed;
+
+    double noise;           // standard deviation of the noise (m)
+    double density;         // points per square meter, on average
+
+    unsigned int blocks_per_side;
+
+    std::vector<double> block_cumulated_weights;    // of the blocks before each block (and of all, last)
+
+    // current block and its primitives
+    unsigned int block = 0;
+    std::vector<ScenePrimitive> primitives;
+    std::vector<double> cumulated_weights;
+
+    uint64_t generated = 0;
+    uint64_t block_end = 0;     // points generated once the current block is complete
+
+    SceneRandom random;
+
+    void make_block (const unsigned int b, std::vector<ScenePrimitive> &block_primitives) const;
+
+    void start_block (const unsigned int b);
+
+    uint64_t points_until_block (const unsigned int b) const;      // points of the blocks before b
+
+public:
+
+    static constexpr double BLOCK_SIZE = 40.0;      // meters
+
+    UrbanScene (const uint64_t n_points, const uint64_t seed = 1, const double noise = 0.01, const double density = 100);
+
+    // Next point (and the type of its primitive); false once n_points have been generated
+    bool next (double &x, double &y, double &z, int *type = nullptr);
+
+    void restart ();
+
+    uint64_t get_n_points () const { return n_points; }
+    unsigned int get_n_blocks () const { return blocks_per_side * blocks_per_side; }
+    double get_extent () const { return blocks_per_side * BLOCK_SIZE; }
+
+    // Primitives of a block (e.g. the ground truth of a benchmark tile)
+    std::vector<ScenePrimitive> get_block_primitives (const unsigned int b) const;
+};
+
+#ifndef OOC3DTileLib_STATIC
+#include "urban_scene.cpp"
+#endif
+
+#endif // URBAN_SCENE_H
@@ -29,7 +29,9 @@
 #include <iostream>
 
 #include "dirent.h"
+#include "pc_distributed.h"
 #include "pc_tiling.h"
+#include "point_attributes.h"
 #include "tclap/CmdLine.h"
 
 using namespace std;
@@ -42,7 +44,7 @@ int main(int argc, char **argv)
     TCLAP::ValueArg<std::string> dirArg("d","dir","input directory",false,"","string");
     cmd.add( dirArg );
 
-    TCLAP::ValueArg<std::string> extArg("e","ext","output extension [xyz (default) |las]",false,"","string");
+    TCLAP::ValueArg<std::string> extArg("e","ext","output extension [xyz (default) |las |laz |ply]",false,"","string");
     cmd.add( extArg );
 
     TCLAP::ValueArg<std::string> fileArg("f","file","filename",false,"","string");
@@ -51,12 +53,78 @@ int main(int argc, char **argv)
     TCLAP::ValueArg<std::string> outArg("o","out","output directory",true,"","string");
     cmd.add( outArg );
 
-    TCLAP::ValueArg<std::string> maxvArg("v","verts","max number of vertex for tile",true,"","int");
+    TCLAP::ValueArg<std::string> maxvArg("v","verts","max number of vertex for tile",false,"","int");
     cmd.add( maxvArg );
 
+    TCLAP::ValueArg<std::string> threadsArg("t","threads","number of threads (default: all cores)",false,"","int");
+    cmd.add( threadsArg );
+
+    TCLAP::ValueArg<std::string> writeThreadsArg("","write-threads","number of tiles written concurrently (default: the number of threads)",false,"","int");
+    cmd.add( writeThreadsArg );
+
+    TCLAP::SwitchArg incrementalArg("i","incremental","update the tiling in the output directory, re-tiling only new or changed input files",false);
+    cmd.add( incrementalArg );
+
+    TCLAP::SwitchArg twoPassArg("p","two-pass","sample the input files first, then classify the points reading them again (no intermediate binary copy of the input)",false);
+    cmd.add( twoPassArg );
+
+    TCLAP::ValueArg<std::string> resolutionArg("r","resolution","quantize the intermediate files to this step, e.g. 0.001 (default: 0, raw coordinates)",false,"","double");
+    cmd.add( resolutionArg );
+
+    TCLAP::SwitchArg noAttributesArg("","no-attributes","write the coordinates only (default: the point attributes of the input, e.g. LAS intensity and color, are kept)",false);
+    cmd.add( noAttributesArg );
+
+    TCLAP::ValueArg<std::string> xyzColumnsArg("","xyz-columns","columns of the XYZ input files [xyz (default) |xyzi |xyzrgb |xyzirgb] (i: intensity, rgb: color; further columns are ignored)",false,"","string");
+    cmd.add( xyzColumnsArg );
+
+    TCLAP::SwitchArg lodArg("","lod","also write a level of detail: a sample of every inner bsp cell (lod_<id> files) and tileset.json (point clouds)",false);
+    cmd.add( lodArg );
+
+    TCLAP::ValueArg<std::string> lodPointsArg("","lod-points","points of each LOD sample (default: a quarter of --verts)",false,"","int");
+    cmd.add( lodPointsArg );
+
+    TCLAP::MultiArg<std::string> tmpArg("","tmp","scratch directory for the intermediate files (repeat it to stripe them over several disks; default: the output directory)",false,"string");
+    cmd.add( tmpArg );
+
+    TCLAP::SwitchArg checkpointArg("c","checkpoint","save checkpoints in the output directory and resume an interrupted run from the last one",false);
+    cmd.add( checkpointArg );
+
+    TCLAP::ValueArg<std::string> checkpointEveryArg("","checkpoint-every","number of points classified between two checkpoints (default: 100000000)",false,"","int");
+    cmd.add( checkpointEveryArg );
+
+    TCLAP::ValueArg<std::string> statsArg("","stats","write the time, throughput and I/O of each stage to this JSON file",false,"","string");
+    cmd.add( statsArg );
+
+    TCLAP::ValueArg<std::string> workersArg("","workers","distributed tiling: number of worker processes, each one sampling, classifying and writing a share of the input (point clouds)",false,"","int");
+    cmd.add( workersArg );
+
+    TCLAP::SwitchArg remoteWorkersArg("","remote-workers","do not start the workers: run them by hand (e.g. one per node) with --worker, sharing the output directory",false);
+    cmd.add( remoteWorkersArg );
+
+    TCLAP::ValueArg<std::string> workerArg("","worker","run as worker <i> of the distributed tiling in the output directory",false,"","int");
+    cmd.add( workerArg );
+
+    TCLAP::SwitchArg quietArg("q","quiet","no progress lines (default: every 10% of the loops of ingest, fill and tile writing, with an ETA)",false);
+    cmd.add( quietArg );
+
     // Parse the args.
     cmd.parse( argc, argv );
 
+    const ProgressCallback progress = quietArg.isSet() ? ProgressCallback() : console_progress;
+
+    if (workerArg.isSet())
+    {
+        const unsigned int n_threads = threadsArg.isSet() ? std::atoi(threadsArg.getValue().c_str()) : TaskPool::default_n_threads();
+
+        return OOC3DTileLib::TilingAlgorithms::run_tiling_worker(outArg.getValue(), std::atoi(workerArg.getValue().c_str()), n_threads, progress) ? 0 : 1;
+    }
+
+    if (!maxvArg.isSet())
+    {
+        std::cerr << "The max number of vertices for tile (--verts) MUST be provided" << std::endl;
+        return 1;
+    }
+
     if (!fileArg.isSet() && !dirArg.isSet())
     {
         std::cerr << "At least one inbetween input file and input directory MUST be provided" << std::endl;
@@ -88,7 +156,9 @@ int main(int argc, char **argv)
                     std::string ext = (ext_pos >= 0) ? path.substr(ext_pos) : "";
 
                     if (ext.compare(".las") == 0 ||
-                        ext.compare(".xyz") == 0)
+                        ext.compare(".laz") == 0 ||
+                        ext.compare(".xyz") == 0 ||
+                        OOC3DTileLib::is_mesh_file(path))
                     {
                         filenames.push_back(path);
                         std::cout << " --- " << ent->d_name << std::endl;
@@ -113,14 +183,74 @@ int main(int argc, char **argv)
         out_ext = extArg.getValue();
     else out_ext = "xyz";
 
-    if (out_ext.compare("xyz") != 0 && out_ext.compare("las") != 0 )
+    if (out_ext.compare("xyz") != 0 && out_ext.compare("las") != 0 && out_ext.compare("laz") != 0 && out_ext.compare("ply") != 0)
     {
         std::cerr << "Unsupported output file format: " << out_ext << std::endl;
         return 1;
     }
 
+#ifndef USE_LASZIP
+    if (out_ext.compare("laz") == 0)
+    {
+        std::cerr << "LAZ output needs libLAS with LASzip: build with -DUSE_LASZIP=ON" << std::endl;
+        return 1;
+    }
+#endif
+
+    OOC3DTileLib::TilingAlgorithms::TilingOptions options;
+
+    if (threadsArg.isSet())
+        options.n_threads = std::atoi(threadsArg.getValue().c_str());
+    else options.n_threads = TaskPool::default_n_threads();
+
+    if (writeThreadsArg.isSet())
+        options.n_write_threads = std::atoi(writeThreadsArg.getValue().c_str());
+
+    options.incremental = incrementalArg.isSet();
+
+    options.two_pass = twoPassArg.isSet();
+
+    if (resolutionArg.isSet())
+        options.resolution = std::atof(resolutionArg.getValue().c_str());
+
+    if (options.resolution < 0)
+    {
+        std::cerr << "The resolution cannot be negative" << std::endl;
+        return 1;
+    }
+
+    options.attributes = !noAttributesArg.isSet();
+
+    if (xyzColumnsArg.isSet() && !xyz_attribute_mask(xyzColumnsArg.getValue(), options.xyz_attributes))
+    {
+        std::cerr << "Unsupported XYZ columns: " << xyzColumnsArg.getValue() << std::endl;
+        return 1;
+    }
+
+    options.lod = lodArg.isSet() || lodPointsArg.isSet();
+
+    if (lodPointsArg.isSet())
+        options.lod_points = std::atoll(lodPointsArg.getValue().c_str());
+
+    options.scratch_directories = tmpArg.getValue();
+
+    options.checkpoint = checkpointArg.isSet() || checkpointEveryArg.isSet();
+
+    if (checkpointEveryArg.isSet())
+        options.checkpoint_interval = std::atoll(checkpointEveryArg.getValue().c_str());
+
+    options.stats_filename = statsArg.getValue();
+
+    if (workersArg.isSet())
+        options.n_workers = std::atoi(workersArg.getValue().c_str());
+
+    options.spawn_workers = !remoteWorkersArg.isSet();
+    options.worker_executable = argv[0];
+
+    options.progress = progress;
+
     std::vector<std::string> out_filenames;
 
-    OOC3DTileLib::TilingAlgorithms::create_pointcloud_tiling(filenames, output_directory, out_ext, max_verts, out_filenames);
+    OOC3DTileLib::TilingAlgorithms::create_pointcloud_tiling(filenames, output_directory, out_ext, max_verts, options, out_filenames);
     return 0;
 }
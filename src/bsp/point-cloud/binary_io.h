@@ -0,0 +1,85 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+// Raw (native endianness) helpers shared by the on-disk formats of the tiling (index, state, manifest).
+
+template <typename T>
+inline void write_value (std::ostream &os, const T &value)
+{
+    os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+inline bool read_value (std::istream &is, T &value)
+{
+    is.read(reinterpret_cast<char *>(&value), sizeof(T));
+
+    return !is.fail();
+}
+
+inline bool host_is_little_endian ()
+{
+    const uint16_t one = 1;
+
+    return *reinterpret_cast<const uint8_t *>(&one) == 1;
+}
+
+inline void write_string (std::ostream &os, const std::string &s)
+{
+    uint32_t length = s.size();
+
+    write_value(os, length);
+    os.write(s.data(), length);
+}
+
+inline bool read_string (std::istream &is, std::string &s)
+{
+    uint32_t length = 0;
+
+    if (!read_value(is, length))
+        return false;
+
+    s.resize(length);
+
+    if (length > 0)
+        is.read(&s[0], length);
+
+    return !is.fail();
+}
+
+#endif // BINARY_IO_H
@@ -27,44 +27,118 @@
 *                                                                               *
 *********************************************************************************/
 #include "bsp.h"
+#include "binary_io.h"
 #include "file_manager.h"
 
-void BinarySpacePartition::create(const int max_vtx_per_cell, const std::string out_directory)
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <queue>
+
+// Orders the leaf frontier as a max-heap on the number of inner (sampled) vertices.
+// Ties are broken in favour of the oldest leaf (lowest ID), so that the sequence of
+// splits matches the one obtained by scanning the leaves in insertion order.
+struct LeafFrontierCompare
+{
+    bool operator() (const BspCell *a, const BspCell *b) const
+    {
+        if (a->n_inner_vertices != b->n_inner_vertices)
+            return a->n_inner_vertices < b->n_inner_vertices;
+
+        return a->ID > b->ID;
+    }
+};
+
+// Uniform in [0, 1) and a function of the vertex id only (splitmix64): the same points are sampled when a fill is resumed
+static inline double lod_hash (stxxl::uint64 id)
+{
+    id += 0x9E3779B97F4A7C15ULL;
+    id = (id ^ (id >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    id = (id ^ (id >> 27)) * 0x94D049BB133111EBULL;
+    id =  id ^ (id >> 31);
+
+    return (id >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void BinarySpacePartition::create(const int max_vtx_per_cell, const std::string out_directory, const unsigned int n_threads)
 {
     std::cout << std::endl << "[BSP] Creating based on vertex downsample ..." << std::endl;
 
-    BspCell *cell = &root;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-    int index = 0;
+    // the frontier holds the current leaves, the largest one on top
+    std::priority_queue<BspCell *, std::vector<BspCell *>, LeafFrontierCompare> frontier (leaves.begin(), leaves.end());
 
-    while (cell->n_inner_vertices > max_vtx_per_cell )
+    if (n_threads > 1)
     {
-        //std::cout << " - [CELL] " << cell.ID << ": " << cell.n_inner_vertices << " > " << max_vtx_per_cell << std::endl;
+        std::cout << "[BSP] Splitting subtrees on " << n_threads << " threads ..." << std::endl;
+
+        // left and right subtrees are independent: split them concurrently,
+        // with provisional IDs used only to name the sample files
+        std::atomic<int> provisional_id (counter);
+
+        {
+            TaskPool pool (n_threads);
+
+            for (unsigned int i = 0; i < leaves.size(); i++)
+            {
+                BspCell *cell = leaves.at(i);
+                pool.submit([=, &provisional_id, &pool]() { split_subtree(cell, max_vtx_per_cell, out_directory, provisional_id, pool); });
+            }
+
+            pool.wait();
+        }
+
+        // number the cells exactly as the sequential loop below would do:
+        // a cell is split if and only if it holds more than max_vtx_per_cell samples
+        while (!frontier.empty() && frontier.top()->left != nullptr)
+        {
+            BspCell *cell = frontier.top();
+            frontier.pop();
+
+            cell->left->ID = counter + 1;
+            cell->right->ID = counter + 2;
 
-        // subdivide the largest grid cell
-        // create children and compute their inner points
-        split_cell(*cell, out_directory);
+            frontier.push(cell->left);
+            frontier.push(cell->right);
 
-        // delete cell from graph
-        leaves.erase(leaves.begin() + index);
+            counter += 2;
+        }
+    }
+    else
+    {
+        while (!frontier.empty() && frontier.top()->n_inner_vertices > max_vtx_per_cell)
+        {
+            // get the cell that should be subdivided
+            BspCell *cell = frontier.top();
+            frontier.pop();
 
-        //std::cout << " --- [LEFT] " << cell.left->n_inner_vertices << std::endl;
-        //std::cout << " --- [RIGHT] " << cell.right->n_inner_vertices << std::endl;
+            // subdivide the largest grid cell
+            // create children and compute their inner points
+            split_cell(*cell, out_directory);
 
-        // add left child
-        leaves.push_back(cell->left);
+            // add children
+            frontier.push(cell->left);
+            frontier.push(cell->right);
 
-        // add right child
-        leaves.push_back(cell->right);
+            // update counter
+            counter += 2;
+        }
+    }
 
-        // update counter
-        counter += 2;
+    leaves.clear();
+    leaves.reserve(frontier.size());
 
-        // get the next cell that should be subdivided
-        index = get_largest_leaf_by_inner_vertices();
-        cell  = leaves.at(index);
+    while (!frontier.empty())
+    {
+        leaves.push_back(frontier.top());
+        frontier.pop();
     }
 
+    // restore the creation order of the leaves (IDs are assigned incrementally at split time)
+    std::sort(leaves.begin(), leaves.end(), [](const BspCell *a, const BspCell *b) { return a->ID < b->ID; });
+
     for (int i = 0; i < leaves.size(); i++)
     {
         BspCell *cell = leaves.at(i);
@@ -73,12 +147,117 @@ void BinarySpacePartition::create(const int max_vtx_per_cell, const std::string
         cell->n_inner_vertices = 0;
 
         remove(cell->filename_inner_v.c_str());
+
+        set_cell_filenames(*cell, get_scratch_directory(i, out_directory));     // also an unsplit root (it only had the sample file)
     }
 
-    std::cout << "[BSP] Created. Number of leaves: " << leaves.size() << std::endl << std::endl;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[BSP] Created. Number of leaves: " << leaves.size() << " (" << elapsed << " s)" << std::endl << std::endl;
+}
+
+void BinarySpacePartition::split_subtree (BspCell *cell, const int max_vtx_per_cell, const std::string out_directory,
+                                          std::atomic<int> &provisional_id, TaskPool &pool)
+{
+    while (cell->n_inner_vertices > max_vtx_per_cell)
+    {
+        int id = provisional_id.fetch_add(2);
+
+        split_cell(*cell, id + 1, id + 2, out_directory, "S_cell_");
+
+        // hand the right subtree over to the pool, keep on splitting the left one
+        BspCell *right = cell->right;
+        pool.submit([=, &provisional_id, &pool]() { split_subtree(right, max_vtx_per_cell, out_directory, provisional_id, pool); });
+
+        cell = cell->left;
+    }
+}
+
+void BinarySpacePartition::set_cell_filenames (BspCell &cell, const std::string directory) const
+{
+    cell.filename_inner_v     = directory + "V_cell_"  + std::to_string(cell.ID);
+    cell.filename_inner_t     = directory + "T_cell_"  + std::to_string(cell.ID);
+    cell.filename_boundary_v  = directory + "BV_cell_" + std::to_string(cell.ID);
+}
+
+std::string BinarySpacePartition::get_cell_name (const unsigned int i) const
+{
+    if (i < leaves.size())
+        return "cell_" + std::to_string(i);
+
+    return "lod_" + std::to_string(lod_nodes.at(i - leaves.size())->ID);
+}
+
+void BinarySpacePartition::set_lod (const stxxl::uint64 points_per_cell, const double points_per_sample, const std::string out_directory)
+{
+    lod_nodes.clear();
+
+    std::vector<BspCell *> stack (1, &root);
+
+    while (!stack.empty())
+    {
+        BspCell *cell = stack.back();
+        stack.pop_back();
+
+        if (cell->left == NULL)
+            continue;
+
+        // a parent has the samples of both children: probabilities decrease towards the root
+        const double n_points = cell->n_inner_vertices * points_per_sample;
+
+        cell->lod_probability = (n_points > points_per_cell) ? points_per_cell / n_points : 1;
+        cell->lod_position    = leaves.size() + lod_nodes.size();
+
+        cell->n_inner_vertices = 0;
+        cell->statistics = PointStatistics();
+
+        set_cell_filenames(*cell, get_scratch_directory(cell->lod_position, out_directory));
+
+        lod_nodes.push_back(cell);
+
+        stack.push_back(cell->right);
+        stack.push_back(cell->left);
+    }
+
+    std::cout << "[BSP] Level of detail: " << lod_nodes.size() << " inner cells, about " << points_per_cell << " points each" << std::endl;
+}
+
+void BinarySpacePartition::set_leaf_filenames (const std::string out_directory)
+{
+    for (unsigned int l = 0; l < leaves.size(); l++)
+        set_cell_filenames(*leaves.at(l), get_scratch_directory(l, out_directory));
+}
+
+void BinarySpacePartition::set_scratch_directories (const std::vector<std::string> &directories)
+{
+    scratch_directories.clear();
+
+    // cell filenames are appended to the directory
+    for (unsigned int d = 0; d < directories.size(); d++)
+    {
+        std::string directory = directories.at(d);
+
+        if (!directory.empty() && directory.back() != '/' && directory.back() != '\\')
+            directory += "/";
+
+        scratch_directories.push_back(directory);
+    }
+}
+
+std::string BinarySpacePartition::get_scratch_directory (const int i, const std::string out_directory) const
+{
+    if (scratch_directories.empty())
+        return out_directory;
+
+    return scratch_directories.at(i % scratch_directories.size());
 }
 
 void BinarySpacePartition::split_cell (BspCell &cell, const std::string out_directory)
+{
+    split_cell(cell, counter + 1, counter + 2, out_directory, "V_cell_");
+}
+
+void BinarySpacePartition::split_cell (BspCell &cell, const int left_id, const int right_id, const std::string out_directory, const std::string sample_prefix)
 {
     Plane plane = cell.getSubdivisionPlane();
 
@@ -90,18 +269,18 @@ void BinarySpacePartition::split_cell (BspCell &cell, const std::string out_dire
     cell.right->parent = &cell;
 
     // set children ids
-    cell.left->ID = counter + 1;
-    cell.right->ID = counter + 2;
+    cell.left->ID = left_id;
+    cell.right->ID = right_id;
 
-    cell.left->filename_inner_v     = out_directory + "V_cell_"  + std::to_string(cell.left->ID);
-    cell.left->filename_inner_t     = out_directory + "T_cell_"  + std::to_string(cell.left->ID);
-    cell.left->filename_boundary_v  = out_directory + "BV_cell_" + std::to_string(cell.left->ID);
-
-    cell.right->filename_inner_v     = out_directory + "V_cell_"  + std::to_string(cell.right->ID);
-    cell.right->filename_inner_t     = out_directory + "T_cell_"  + std::to_string(cell.right->ID);
-    cell.right->filename_boundary_v  = out_directory + "BV_cell_" + std::to_string(cell.right->ID);
+    const std::string left_directory  = get_scratch_directory(left_id, out_directory);
+    const std::string right_directory = get_scratch_directory(right_id, out_directory);
 
+    set_cell_filenames(*cell.left, left_directory);
+    set_cell_filenames(*cell.right, right_directory);
 
+    // the inner vertices file holds the sample while the bsp is being created
+    cell.left->filename_inner_v  = left_directory + sample_prefix + std::to_string(cell.left->ID);
+    cell.right->filename_inner_v = right_directory + sample_prefix + std::to_string(cell.right->ID);
 
     // open children inner vertices file (write mode)
     std::ofstream left_fp (cell.left->filename_inner_v.c_str(), std::ios::out | std::ios::binary);
@@ -170,198 +349,505 @@ void BinarySpacePartition::split_cell (BspCell &cell, const std::string out_dire
 void BinarySpacePartition::fill (const std::string input_binary_filename,
                                 const unsigned int n_input_files,
                                 bool with_polys)
+{
+    fill(input_binary_filename, std::vector<std::string>(), n_input_files, with_polys, nullptr, nullptr, 0);
+}
+
+void BinarySpacePartition::fill (const std::string input_binary_filename,
+                                 const unsigned int n_input_files,
+                                 const FillProgress *resume,
+                                 const std::function<void(const FillProgress &)> &checkpoint,
+                                 const stxxl::uint64 checkpoint_interval)
+{
+    fill(input_binary_filename, std::vector<std::string>(), n_input_files, false, resume, checkpoint, checkpoint_interval);
+}
+
+void BinarySpacePartition::fill (const std::vector<std::string> &input_filenames,
+                                 const FillProgress *resume,
+                                 const std::function<void(const FillProgress &)> &checkpoint,
+                                 const stxxl::uint64 checkpoint_interval)
+{
+    fill("", input_filenames, input_filenames.size(), false, resume, checkpoint, checkpoint_interval);
+}
+
+void BinarySpacePartition::fill_share (const std::vector<std::string> &input_filenames, const stxxl::uint64 first_vertex)
+{
+    fill("", input_filenames, input_filenames.size(), false, nullptr, nullptr, 0, first_vertex);
+}
+
+void BinarySpacePartition::restore_fill (const FillProgress &progress)
+{
+    for (unsigned int l = 0; l < get_n_cells() && l < progress.leaf_n_vertices.size(); l++)
+        get_cell(l)->n_inner_vertices = progress.leaf_n_vertices.at(l);
+
+    for (unsigned int l = 0; l < get_n_cells() && l < progress.leaf_statistics.size(); l++)
+        get_cell(l)->statistics = progress.leaf_statistics.at(l);
+
+    file_n_vertices = progress.file_n_vertices;
+    file_leaves     = progress.file_leaves;
+}
+
+void BinarySpacePartition::fill (const std::string input_binary_filename,
+                                 const std::vector<std::string> &input_filenames,
+                                 const unsigned int n_input_files,
+                                 bool with_polys,
+                                 const FillProgress *resume,
+                                 const std::function<void(const FillProgress &)> &checkpoint,
+                                 const stxxl::uint64 checkpoint_interval,
+                                 const stxxl::uint64 first_vertex)
 {
     if (leaves.size() == 0)
         return;
 
-    FileManager file_manager (this);
+    FileManager file_manager (this, (resume != nullptr) ? &resume->leaf_bytes : nullptr, with_polys);
 
-    assert (file_manager.vOuts.size() == leaves.size());
-    assert (file_manager.tOuts.size() == leaves.size());
-    assert (file_manager.bvOuts.size() == leaves.size());
+    assert (file_manager.vOuts.size() == get_n_cells());
+    assert (file_manager.tOuts.size() == (with_polys ? leaves.size() : 0));
+    assert (file_manager.bvOuts.size() == (with_polys ? leaves.size() : 0));
+
+    if (with_polys)
+        mesh.reset(new MeshBookkeeping());
+    else
+        mesh.reset();
 
     BspCell *cell = leaves.at(0);
 
-    std::ifstream binary_mesh (input_binary_filename.c_str(), std::ios::in | std::ios::binary);
+    const bool from_binary = !input_binary_filename.empty();
 
-    if (!binary_mesh.is_open())
+    std::ifstream binary_mesh;
+
+    if (from_binary)
     {
-        std::cout << "[ERROR] Opening binary file" << input_binary_filename << std::endl;
-        exit(1);
+        binary_mesh.open (input_binary_filename.c_str(), std::ios::in | std::ios::binary);
+
+        if (!binary_mesh.is_open())
+        {
+            std::cout << "[ERROR] Opening binary file" << input_binary_filename << std::endl;
+            exit(1);
+        }
     }
 
-    stxxl::uint64 counter = 0;
+    stxxl::uint64 counter = first_vertex;
+
+    int curr_cell_pos = cell->leaf_ID;
+    int curr_cell_id = cell->ID;
+
+    file_n_vertices.clear();
+    file_leaves.clear();
+
+    unsigned int first_file = 0;
+
+    if (resume != nullptr)
+    {
+        std::cout << "[VERTEX CLASSIFICATION] Resuming from vertex " << resume->counter << std::endl;
+
+        restore_fill(*resume);
 
-    for (unsigned int f=0; f < n_input_files; f++)
+        counter = resume->counter;
+        first_file = resume->file;
+    }
+
+    for (unsigned int f = first_file; f < n_input_files; f++)
     {
         stxxl::uint64 n_vertices, n_triangles;
+        stxxl::uint64 first_vid = 0;
 
-        binary_mesh.read (reinterpret_cast<char *>(&n_vertices),sizeof(n_vertices));
-        binary_mesh.read (reinterpret_cast<char *>(&n_triangles),sizeof(n_triangles));
+        std::vector<bool> touched_leaves (leaves.size(), false);    // leaves receiving vertices of the current file
 
-        double x, y, z;
+        std::unique_ptr<PointStream> points;
 
-        int curr_cell_pos = 0;
-        int curr_cell_id = 0;
+        if (!from_binary)
+        {
+            std::cout << "[OPENING] Point Cloud file " << input_filenames.at(f) << std::endl;
+
+            points.reset(open_point_stream(input_filenames.at(f), attribute_mask));
+
+            if (!points)
+            {
+                std::cerr << "[ERROR] Opening file " << input_filenames.at(f) << std::endl;
+                exit(1);
+            }
+        }
+
+        if (resume != nullptr && f == resume->file)
+        {
+            n_vertices  = resume->file_n_vertices_total;
+            n_triangles = resume->file_n_triangles_total;
+            first_vid   = resume->file_vertex;
+
+            for (unsigned int l = 0; l < resume->current_file_leaves.size(); l++)
+                touched_leaves[resume->current_file_leaves.at(l)] = true;
+        }
+        else
+        if (from_binary)
+        {
+            binary_mesh.read (reinterpret_cast<char *>(&n_vertices),sizeof(n_vertices));
+            binary_mesh.read (reinterpret_cast<char *>(&n_triangles),sizeof(n_triangles));
+        }
+        else
+        {
+            n_vertices  = points->get_n_points();
+            n_triangles = 0;
+        }
+
+        if (from_binary)
+            points.reset(new BinaryPointStream(binary_mesh, n_vertices, resolution, attribute_mask));
+
+        if (resume != nullptr && f == resume->file && !points->seek(resume->binary_offset))
+        {
+            std::cerr << "[ERROR] Resuming input file " << f << " from position " << resume->binary_offset << std::endl;
+            exit(1);
+        }
+
+        double x, y, z;
+        PointAttributes attributes;
 
         std::cout << "[VERTEX CLASSIFICATION] Running ..." << std::endl;
 
-        stxxl::uint64 perc_v = (stxxl::uint64)(n_vertices / 10);
+        ProgressReporter reporter (progress, "fill", "Reading Vertices", n_vertices, f, n_input_files, first_vid);
 
         // vertex classification
-        for (stxxl::uint64 vid = 0; vid < n_vertices; vid++)
+        for (stxxl::uint64 vid = first_vid; vid < n_vertices; vid++)
         {
-            if (perc_v > 0 && ((vid%perc_v) == 0))
-                std::cout << " --- --- Reading Vertices .. " << vid << " \\ " << n_vertices << " ( " << (vid / perc_v) * 10 << "% )" << std::endl;
+            if (checkpoint && !with_polys && checkpoint_interval > 0 && vid > first_vid && (counter % checkpoint_interval) == 0)
+            {
+                file_manager.close_all();   // flush every leaf file
+
+                FillProgress progress;
 
-            if (vid == n_vertices - 1)
-                std::cout << " --- --- Reading Vertices .. " << vid + 1 << " \\ " << n_vertices << " -- COMPLETED" << std::endl;
+                progress.binary_offset          = points->tell();
+                progress.file                   = f;
+                progress.file_vertex            = vid;
+                progress.file_n_vertices_total  = n_vertices;
+                progress.file_n_triangles_total = n_triangles;
+                progress.counter                = counter;
+                progress.leaf_bytes             = file_manager.vOuts_bytes;
+                progress.file_n_vertices        = file_n_vertices;
+                progress.file_leaves            = file_leaves;
+
+                for (unsigned int l = 0; l < get_n_cells(); l++)
+                {
+                    progress.leaf_n_vertices.push_back(get_cell(l)->n_inner_vertices);
+                    progress.leaf_statistics.push_back(get_cell(l)->statistics);
+                }
+
+                for (unsigned int l = 0; l < leaves.size(); l++)
+                    if (touched_leaves[l])
+                        progress.current_file_leaves.push_back(l);
+
+                checkpoint(progress);
+            }
+
+            reporter.update(vid);
 
             // read point
-            binary_mesh.read (reinterpret_cast<char *>(&x),sizeof(x));
-            binary_mesh.read (reinterpret_cast<char *>(&y),sizeof(y));
-            binary_mesh.read (reinterpret_cast<char *>(&z),sizeof(z));
+            if (!points->read_point(x, y, z, (attribute_mask != 0) ? &attributes : nullptr))
+            {
+                std::cerr << "[ERROR] Reading vertex " << vid << " of input file " << f << std::endl;
+                exit(1);
+            }
 
             // search for the corresponding cell
             if (!cell->hasPoint(x, y, z))
             {
-                cell = &root;
-
-                while (cell->left != NULL)
-                {
-                    if (cell->left->hasPoint(x, y, z))
-                        cell = cell->left;
-                    else cell = cell->right;
-                }
+                cell = locate_leaf(x, y, z);
 
                 curr_cell_pos = cell->leaf_ID;
                 curr_cell_id = cell->ID;
             }
 
-            file_manager.write_vertex(curr_cell_pos, counter, x, y, z);     // write inner vertex into the inner vertex file of the current cell
+            file_manager.write_vertex(curr_cell_pos, counter, x, y, z, &attributes);     // write inner vertex into the inner vertex file of the current cell
+
+            // statistics (e.g. the bounding box of the tile) of the point as written, quantized to the resolution
+            const double qx = quantize_coordinate(x, resolution);
+            const double qy = quantize_coordinate(y, resolution);
+            const double qz = quantize_coordinate(z, resolution);
+
+            // and into the LOD samples of its ancestors, from the leaf up while the point is sampled
+            if (!lod_nodes.empty())
+            {
+                const double h = lod_hash(counter);
+
+                for (BspCell *node = cell->parent; node != nullptr && h < node->lod_probability; node = node->parent)
+                {
+                    file_manager.write_vertex(node->lod_position, counter, x, y, z, &attributes);
+
+                    node->n_inner_vertices++;
+                    node->statistics.add(qx, qy, qz, attributes, attribute_mask);
+                }
+            }
+
+            touched_leaves[curr_cell_pos] = true;
 
             counter++;
             cell->n_inner_vertices++;
+            cell->statistics.add(qx, qy, qz, attributes, attribute_mask);
 
             if (with_polys)
             {
-                vtx2cell.push_back(curr_cell_pos);              // mapping vertex --> bsp_cell
-                vtx2boundary.push_back(UNKNOWN_BOUNDARY_INFO);  // no information about "is it on the boundary of current cell?"
-
-                Point point;
-                point.x = x;
-                point.y = y;
-                point.z = z;
+                VertexCell vertex;          // mapping vertex --> bsp_cell (sequential, on disk)
+                vertex.cell = curr_cell_pos;
+                vertex.x = x;
+                vertex.y = y;
+                vertex.z = z;
 
-                input_coords.push_back(point);
+                mesh->vertices.push_back(vertex);
             }
         }
 
+        reporter.complete();
+
         std::cout << "[VERTEX CLASSIFICATION] Completed." << std::endl << std::endl;
 
+        file_n_vertices.push_back(n_vertices);
+        file_leaves.push_back(std::vector<int>());
+
+        for (unsigned int l = 0; l < touched_leaves.size(); l++)
+            if (touched_leaves[l])
+                file_leaves.back().push_back(l);
+
 
         if (with_polys)
-        {
-            std::cout << "[TRIANGLE CLASSIFICATION] Running ..." << std::endl;
+            classify_triangles(binary_mesh, n_triangles, file_manager);
+    }
 
-            stxxl::uint64 perc_t = (stxxl::uint64)(n_triangles / 10);
+    if (with_polys)
+        find_constrained_vertices();
 
-            stxxl::uint64 v1 = UINT64_MAX, v2 = UINT64_MAX, v3 = UINT64_MAX;
+    file_manager.close_all();
 
-            // triangle classification
-            for (stxxl::uint64 i = 0; i < n_triangles; i++)
-            {
-                if (perc_t > 0 && ((i%perc_t) == 0))
-                    std::cout << " --- --- Reading Triangles .. " << i << " \\ " << n_triangles << " ( " << (i / perc_t) * 10 << "% )" << std::endl;
+    fill_counters = file_manager.counters;
+}
+
+BspCell *BinarySpacePartition::locate_leaf (const double x, const double y, const double z)
+{
+    BspCell *cell = &root;
+
+    while (cell->left != NULL)
+    {
+        if (cell->left->hasPoint(x, y, z))
+            cell = cell->left;
+        else cell = cell->right;
+    }
 
-                if (i == n_triangles - 1)
-                    std::cout << " --- --- Reading Triangles .. " << i + 1 << " \\ " << n_triangles << " -- COMPLETED" << std::endl;
+    return cell;
+}
+
+void BinarySpacePartition::find_leaves (const Vtx &bb_min, const Vtx &bb_max, std::vector<int> &leaf_positions) const
+{
+    std::vector<const BspCell *> stack (1, &root);
 
-                binary_mesh.read (reinterpret_cast<char *>(&v1),sizeof(v1));
-                binary_mesh.read (reinterpret_cast<char *>(&v2),sizeof(v2));
-                binary_mesh.read (reinterpret_cast<char *>(&v3),sizeof(v3));
+    while (!stack.empty())
+    {
+        const BspCell *cell = stack.back();
+        stack.pop_back();
 
-                assert (v1 != v2);assert (v1 != v3);assert (v3 != v2);
+        if (cell->bbox_min.x > bb_max.x || cell->bbox_max.x < bb_min.x ||
+            cell->bbox_min.y > bb_max.y || cell->bbox_max.y < bb_min.y ||
+            cell->bbox_min.z > bb_max.z || cell->bbox_max.z < bb_min.z)
+            continue;
 
-                std::pair<int, int> selected;
-                std::pair<int, int> neighbor1, neighbor2;
+        if (cell->left == NULL)
+        {
+            leaf_positions.push_back(cell->leaf_ID);
+            continue;
+        }
 
-                classify_triangle(v1, v2, v3, selected, neighbor1, neighbor2);   // decide the triangle clasfficication (the cell where it lies)
+        stack.push_back(cell->right);
+        stack.push_back(cell->left);
+    }
+}
 
-                assert (v1 != v2);assert (v1 != v3);assert (v3 != v2);
+static const char     BSP_INDEX_MAGIC[8] = {'B', 'S', 'P', 'I', 'N', 'D', 'E', 'X'};
+static const uint32_t BSP_INDEX_VERSION  = 1;
 
-                file_manager.write_triangle(selected.first, v1, v2, v3);     // write inner triangle into the inner triangle file of the current cell
+bool BinarySpacePartition::save_index (const std::string filename) const
+{
+    std::ofstream os (filename.c_str(), std::ios::out | std::ios::binary);
 
-                leaves.at(selected.first)->n_inner_triangles++;     // update the triangle counter of the selected cell
+    if (!os.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << filename << std::endl;
+        return false;
+    }
 
-                std::vector<std::pair<int,int>> neighbor_info;
+    os.write(BSP_INDEX_MAGIC, sizeof(BSP_INDEX_MAGIC));
+    write_value(os, BSP_INDEX_VERSION);
 
-                if (neighbor1.first != -1)     // the triangle partially lies outside the selected cell
-                {
-                    neighbor_info.push_back(neighbor1);
+    write_value(os, static_cast<int32_t>(counter));
+    write_value(os, static_cast<uint32_t>(leaves.size()));
+    write_value(os, resolution);
 
-                    if (neighbor2.first != -1)
-                        neighbor_info.push_back(neighbor2);
-                }
+    write_index_node(os, root);
 
-                for (int i=0; i < neighbor_info.size(); i++)
-                {
-                    // add external boundary vertex to boundary vertex file
-                    file_manager.write_boundary_vertex(selected.first, neighbor_info.at(i).second);
-
-                    // update neighbor info in the bsp
-                    if (vtx2boundary.at(neighbor_info.at(i).second) == UNKNOWN_BOUNDARY_INFO)
-                    {
-                        vtx2boundary.at(neighbor_info.at(i).second) = selected.first;
-                    }
-                    else if (vtx2boundary.at(neighbor_info.at(i).second) >= 0 && vtx2boundary.at(neighbor_info.at(i).second) != selected.first)
-                    {
-                        ConstrainedVertex constrained_vertex;
-                        constrained_vertex.vid = neighbor_info.at(i).second;
-                        constrained_vertex.cells.insert(vtx2boundary.at(neighbor_info.at(i).second));
-                        constrained_vertex.cells.insert(selected.first);
-
-                        constrained_vertices[neighbor_info.at(i).second] = (constrained_vertex);
-
-                        vtx2boundary.at(neighbor_info.at(i).second) = CONSTRAINED_BOUNDARY_VERTEX; // constrained: it is shared among more than 2
-                    }
-                    else if (vtx2boundary.at(neighbor_info.at(i).second) == CONSTRAINED_BOUNDARY_VERTEX)
-                    {
-                        constrained_vertices.find(neighbor_info.at(i).second)->second.cells.insert(selected.first);
-                    }
-
-                    cell->neighbor_bsp_cells.insert(neighbor_info.at(i).first);
-                    leaves.at(neighbor_info.at(i).first)->neighbor_bsp_cells.insert(selected.first);
-                }
-            }
+    os.close();
 
-            std::cout << "[TRIANGLE CLASSIFICATION] Completed.. " << std::endl << std::endl;
-        }
+    if (os.fail())
+    {
+        std::cerr << "[ERROR] Writing file " << filename << std::endl;
+        return false;
     }
 
-    file_manager.close_all();
+    std::cout << "[BSP] Index saved: " << filename << std::endl;
 
+    return true;
 }
 
-const int BinarySpacePartition::get_largest_leaf_by_inner_vertices() const
+void BinarySpacePartition::write_index_node (std::ostream &os, const BspCell &cell) const
 {
-    int n_cells = leaves.size();
+    write_value(os, static_cast<int32_t>(cell.ID));
+    write_value(os, static_cast<uint8_t>(cell.left != NULL));
+
+    write_value(os, cell.bbox_min.x); write_value(os, cell.bbox_min.y); write_value(os, cell.bbox_min.z);
+    write_value(os, cell.bbox_max.x); write_value(os, cell.bbox_max.y); write_value(os, cell.bbox_max.z);
+
+    if (cell.left != NULL)
+    {
+        // split plane: axis and position (the left child starts where the right one ends)
+        Plane plane = cell.getSubdivisionPlane();
+
+        double position = (plane.axis == 0) ? plane.min.x : (plane.axis == 1) ? plane.min.y : plane.min.z;
+
+        write_value(os, static_cast<uint8_t>(plane.axis));
+        write_value(os, position);
+
+        // samples of create or, once filled, LOD sample
+        write_value(os, static_cast<uint64_t>(cell.n_inner_vertices));
+        write_statistics(os, cell.statistics);
+        write_string(os, cell.filename_mesh);
+
+        write_index_node(os, *cell.left);
+        write_index_node(os, *cell.right);
+    }
+    else
+    {
+        write_value(os, static_cast<int32_t>(cell.leaf_ID));
+        write_value(os, static_cast<uint64_t>(cell.n_inner_vertices));
+        write_value(os, static_cast<uint64_t>(cell.n_inner_triangles));
+        write_statistics(os, cell.statistics);
 
-    stxxl::uint64 n_points = 0;
-    int index = -1;
+        write_string(os, cell.filename_mesh);
+        write_string(os, cell.filename_local2global);
+    }
+}
+
+bool BinarySpacePartition::load_index (const std::string filename)
+{
+    std::ifstream is (filename.c_str(), std::ios::in | std::ios::binary);
 
-    for (int i=0; i < n_cells; i++)
+    if (!is.is_open())
     {
-        stxxl::uint64 n = leaves.at(i)->n_inner_vertices;
+        std::cerr << "[ERROR] Opening file " << filename << std::endl;
+        return false;
+    }
+
+    char magic[8];
+    uint32_t version = 0;
+    int32_t n_splits = 0;
+    uint32_t n_leaves = 0;
+
+    is.read(magic, sizeof(magic));
 
-        if (n > n_points)
+    if (is.fail() || std::memcmp(magic, BSP_INDEX_MAGIC, sizeof(magic)) != 0 ||
+        !read_value(is, version) || version != BSP_INDEX_VERSION)
+    {
+        std::cerr << "[ERROR] " << filename << " is not a BSP index (or has an unsupported version)" << std::endl;
+        return false;
+    }
+
+    read_value(is, n_splits);
+    read_value(is, n_leaves);
+    read_value(is, resolution);
+
+    root = BspCell();
+    root.is_bsp_root = true;
+
+    leaves.clear();
+    leaves.resize(n_leaves, nullptr);
+    lod_nodes.clear();
+
+    if (!read_index_node(is, root))
+    {
+        std::cerr << "[ERROR] Reading file " << filename << std::endl;
+        return false;
+    }
+
+    for (unsigned int l = 0; l < leaves.size(); l++)
+    {
+        if (leaves.at(l) == nullptr)
         {
-            n_points = n;
-            index = i;
+            std::cerr << "[ERROR] Missing leaf " << l << " in " << filename << std::endl;
+            return false;
         }
     }
 
-    return index;
+    counter = n_splits;
+
+    std::cout << "[BSP] Index loaded: " << filename << ". Number of leaves: " << leaves.size() << std::endl;
+
+    return true;
+}
+
+bool BinarySpacePartition::read_index_node (std::istream &is, BspCell &cell)
+{
+    int32_t id = 0;
+    uint8_t has_children = 0;
+
+    if (!read_value(is, id) || !read_value(is, has_children))
+        return false;
+
+    cell.ID = id;
+
+    read_value(is, cell.bbox_min.x); read_value(is, cell.bbox_min.y); read_value(is, cell.bbox_min.z);
+    read_value(is, cell.bbox_max.x); read_value(is, cell.bbox_max.y); read_value(is, cell.bbox_max.z);
+
+    if (has_children)
+    {
+        uint8_t axis = 0;
+        double position = 0;
+
+        // the split plane is informative: children carry their exact bboxes
+        read_value(is, axis);
+        read_value(is, position);
+
+        uint64_t n_v = 0;
+
+        read_value(is, n_v);
+        read_statistics(is, cell.statistics);
+        read_string(is, cell.filename_mesh);
+
+        cell.n_inner_vertices = n_v;
+
+        cell.left  = new BspCell ();
+        cell.right = new BspCell ();
+
+        cell.left->parent = &cell;
+        cell.right->parent = &cell;
+
+        return read_index_node(is, *cell.left) && read_index_node(is, *cell.right);
+    }
+
+    int32_t leaf_id = 0;
+    uint64_t n_v = 0, n_t = 0;
+
+    read_value(is, leaf_id);
+    read_value(is, n_v);
+    read_value(is, n_t);
+
+    read_statistics(is, cell.statistics);
+
+    read_string(is, cell.filename_mesh);
+
+    if (!read_string(is, cell.filename_local2global) || leaf_id < 0 || leaf_id >= (int32_t) leaves.size())
+        return false;
+
+    cell.leaf_ID = leaf_id;
+    cell.n_inner_vertices = n_v;
+    cell.n_inner_triangles = n_t;
+
+    leaves.at(leaf_id) = &cell;
+
+    return true;
 }
 
 const BspCell & BinarySpacePartition::get_minimum_cell (const BspCell &a, const BspCell &b) const
@@ -372,16 +858,152 @@ const BspCell & BinarySpacePartition::get_minimum_cell (const BspCell &a, const
     return b;
 }
 
-void BinarySpacePartition::classify_triangle (const stxxl::uint64 v1, const stxxl::uint64 v2, const stxxl::uint64 v3,
-                                                std::pair<int, int> &selected_cell_vtx, std::pair<int, int> &neighbor_cell_vtx_1, std::pair<int, int> &neighbor_cell_vtx_2)
+void BinarySpacePartition::classify_triangles (std::istream &binary_mesh, const stxxl::uint64 n_triangles, FileManager &file_manager)
+{
+    std::cout << "[TRIANGLE CLASSIFICATION] Running ..." << std::endl;
+
+    ProgressReporter reading (progress, "triangles", "Reading Triangles", n_triangles);
+
+    // corners of the triangles, sorted by vertex id
+    stxxl::vector<TriangleCorner> corners;
+
+    stxxl::uint64 v[3];
+
+    for (stxxl::uint64 tid = 0; tid < n_triangles; tid++)
+    {
+        reading.update(tid);
+
+        binary_mesh.read (reinterpret_cast<char *>(v),sizeof(v));
+
+        assert (v[0] != v[1]);assert (v[0] != v[2]);assert (v[2] != v[1]);
+
+        for (int k = 0; k < 3; k++)
+        {
+            TriangleCorner corner;
+            corner.vid = v[k];
+            corner.tid = tid;
+            corner.corner = k;
+
+            corners.push_back(corner);
+        }
+    }
+
+    reading.complete();
+
+    stxxl::sort(corners.begin(), corners.end(), TriangleCornerByVertex(), MESH_SORT_MEMORY);
+
+    // join with the vertex cells: a single forward scan of both
+    stxxl::vector<ClassifiedCorner> classified;
+
+    stxxl::vector<VertexCell>::const_iterator vertex = mesh->vertices.begin();
+    stxxl::uint64 vertex_id = 0;
+
+    for (stxxl::vector<TriangleCorner>::const_iterator corner = corners.begin(); corner != corners.end(); ++corner)
+    {
+        if (corner->vid >= mesh->vertices.size())
+        {
+            std::cerr << "[ERROR] Triangle " << corner->tid << " refers to the missing vertex " << corner->vid << std::endl;
+            exit(1);
+        }
+
+        vertex += corner->vid - vertex_id;
+        vertex_id = corner->vid;
+
+        ClassifiedCorner classified_corner;
+        classified_corner.tid    = corner->tid;
+        classified_corner.corner = corner->corner;
+        classified_corner.vid    = corner->vid;
+        classified_corner.vertex = *vertex;
+
+        classified.push_back(classified_corner);
+    }
+
+    corners.clear();
+
+    stxxl::sort(classified.begin(), classified.end(), ClassifiedCornerByTriangle(), MESH_SORT_MEMORY);
+
+    // triangle classification, in input order
+    stxxl::vector<ClassifiedCorner>::const_iterator corner = classified.begin();
+
+    ProgressReporter classifying (progress, "triangles", "Classifying Triangles", n_triangles);
+
+    for (stxxl::uint64 tid = 0; tid < n_triangles; tid++)
+    {
+        classifying.update(tid);
+
+        ClassifiedCorner c[3];
+
+        for (int k = 0; k < 3; k++, ++corner)
+            c[k] = *corner;
+
+        assert (c[0].tid == tid && c[1].tid == tid && c[2].tid == tid);
+
+        std::pair<int, stxxl::uint64> selected;
+        std::pair<int, stxxl::uint64> neighbor[2];
+
+        // decide the triangle clasfficication (the cell where it lies)
+        classify_triangle(c[0].vid, c[1].vid, c[2].vid, c[0].vertex.cell, c[1].vertex.cell, c[2].vertex.cell,
+                          selected, neighbor[0], neighbor[1]);
+
+        file_manager.write_triangle(selected.first, c[0].vid, c[1].vid, c[2].vid);     // write inner triangle into the inner triangle file of the selected cell
+
+        leaves.at(selected.first)->n_inner_triangles++;     // update the triangle counter of the selected cell
+
+        // the corners lying outside the selected cell become its boundary vertices
+        for (int n = 0; n < 2 && neighbor[n].first != -1; n++)
+        {
+            const VertexCell &outer = (neighbor[n].second == c[0].vid) ? c[0].vertex : (neighbor[n].second == c[1].vid) ? c[1].vertex : c[2].vertex;
+
+            file_manager.write_boundary_vertex(selected.first, neighbor[n].second, outer.x, outer.y, outer.z);
+
+            BoundaryVertex boundary_vertex;
+            boundary_vertex.vid  = neighbor[n].second;
+            boundary_vertex.cell = selected.first;
+
+            mesh->boundary_vertices.push_back(boundary_vertex);
+
+            leaves.at(selected.first)->neighbor_bsp_cells.insert(neighbor[n].first);
+            leaves.at(neighbor[n].first)->neighbor_bsp_cells.insert(selected.first);
+        }
+    }
+
+    classifying.complete();
+
+    std::cout << "[TRIANGLE CLASSIFICATION] Completed.. " << std::endl << std::endl;
+}
+
+void BinarySpacePartition::find_constrained_vertices ()
 {
-    neighbor_cell_vtx_1.first = neighbor_cell_vtx_1.second = -1;
-    neighbor_cell_vtx_2.first = neighbor_cell_vtx_2.second = -1;
+    // vertices added to the boundary of more than one cell, grouped by a sort
+    stxxl::sort(mesh->boundary_vertices.begin(), mesh->boundary_vertices.end(), BoundaryVertexByVertex(), MESH_SORT_MEMORY);
+
+    mesh->constrained_vertices.clear();
+
+    stxxl::vector<BoundaryVertex>::const_iterator it = mesh->boundary_vertices.begin();
 
-    // get the cell of three vertices
-    int cell_pos_v1 = vtx2cell.at(v1);
-    int cell_pos_v2 = vtx2cell.at(v2);
-    int cell_pos_v3 = vtx2cell.at(v3);
+    while (it != mesh->boundary_vertices.end())
+    {
+        ConstrainedVertex constrained_vertex;
+        constrained_vertex.vid = it->vid;
+
+        for (; it != mesh->boundary_vertices.end() && it->vid == constrained_vertex.vid; ++it)
+            constrained_vertex.cells.insert(it->cell);
+
+        if (constrained_vertex.cells.size() > 1)
+            mesh->constrained_vertices[constrained_vertex.vid] = constrained_vertex;
+    }
+
+    mesh->boundary_vertices.clear();
+}
+
+void BinarySpacePartition::classify_triangle (const stxxl::uint64 v1, const stxxl::uint64 v2, const stxxl::uint64 v3,
+                                              const int cell_pos_v1, const int cell_pos_v2, const int cell_pos_v3,
+                                              std::pair<int, stxxl::uint64> &selected_cell_vtx,
+                                              std::pair<int, stxxl::uint64> &neighbor_cell_vtx_1, std::pair<int, stxxl::uint64> &neighbor_cell_vtx_2)
+{
+    neighbor_cell_vtx_1.first = -1;
+    neighbor_cell_vtx_2.first = -1;
+    neighbor_cell_vtx_1.second = neighbor_cell_vtx_2.second = UINT64_MAX;
 
     if (cell_pos_v1 == cell_pos_v2)
     {
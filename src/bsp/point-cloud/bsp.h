@@ -31,7 +31,15 @@
 #define BSP_H
 
 #include "bsp_cell.h"
-
+#include "point_stream.h"
+#include "task_pool.h"
+#include "tiling_progress.h"
+
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -51,6 +59,102 @@ struct ConstrainedVertex
 
 };
 
+// Records of the (out of core) triangle classification. The sort comparators provide the sentinels STXXL needs.
+
+struct VertexCell               // indexed by vertex id
+{
+    int    cell;
+    double x, y, z;
+};
+
+struct TriangleCorner
+{
+    stxxl::uint64 vid;
+    stxxl::uint64 tid;
+    int           corner;
+};
+
+struct ClassifiedCorner
+{
+    stxxl::uint64 tid;
+    int           corner;
+    stxxl::uint64 vid;
+    VertexCell    vertex;
+};
+
+struct BoundaryVertex           // vertex added to the boundary vertices of a cell
+{
+    stxxl::uint64 vid;
+    int           cell;
+};
+
+struct TriangleCornerByVertex
+{
+    bool operator() (const TriangleCorner &a, const TriangleCorner &b) const { return a.vid < b.vid || (a.vid == b.vid && a.tid < b.tid); }
+
+    TriangleCorner min_value () const { TriangleCorner c; c.vid = c.tid = 0; c.corner = 0; return c; }
+    TriangleCorner max_value () const { TriangleCorner c; c.vid = c.tid = UINT64_MAX; c.corner = 0; return c; }
+};
+
+struct ClassifiedCornerByTriangle
+{
+    bool operator() (const ClassifiedCorner &a, const ClassifiedCorner &b) const { return a.tid < b.tid || (a.tid == b.tid && a.corner < b.corner); }
+
+    ClassifiedCorner min_value () const { ClassifiedCorner c = ClassifiedCorner(); c.tid = 0; c.corner = INT_MIN; return c; }
+    ClassifiedCorner max_value () const { ClassifiedCorner c = ClassifiedCorner(); c.tid = UINT64_MAX; c.corner = INT_MAX; return c; }
+};
+
+struct BoundaryVertexByVertex
+{
+    bool operator() (const BoundaryVertex &a, const BoundaryVertex &b) const { return a.vid < b.vid || (a.vid == b.vid && a.cell < b.cell); }
+
+    BoundaryVertex min_value () const { BoundaryVertex v; v.vid = 0; v.cell = INT_MIN; return v; }
+    BoundaryVertex max_value () const { BoundaryVertex v; v.vid = UINT64_MAX; v.cell = INT_MAX; return v; }
+};
+
+#define MESH_SORT_MEMORY (256 * 1024 * 1024)    // bytes of RAM of each external sort
+
+// Per vertex bookkeeping of the mesh fill, on disk (STXXL) and accessed sequentially only: memory stays bounded.
+// Point clouds never allocate it.
+struct MeshBookkeeping
+{
+    stxxl::vector<VertexCell> vertices;             // cell and coordinates of each vertex (in id order)
+
+    stxxl::vector<BoundaryVertex> boundary_vertices;
+
+    std::map<stxxl::uint64, ConstrainedVertex> constrained_vertices;    // boundary vertices of more than one cell
+};
+
+// Consistent point of a (point cloud) fill, from which the fill can be resumed.
+struct FillProgress
+{
+    stxxl::uint64 binary_offset = 0;        // position of the next vertex record in the binary input (PointStream::tell)
+    unsigned int  file          = 0;        // input file being classified
+    stxxl::uint64 file_vertex   = 0;        // vertices of that file already classified
+    stxxl::uint64 file_n_vertices_total  = 0;
+    stxxl::uint64 file_n_triangles_total = 0;
+    stxxl::uint64 counter       = 0;        // vertices classified so far (i.e. next global vertex id)
+
+    std::vector<stxxl::uint64> leaf_bytes;          // flushed length of each inner vertex file (leaves, then LOD cells)
+    std::vector<stxxl::uint64> leaf_n_vertices;
+    std::vector<PointStatistics> leaf_statistics;
+
+    std::vector<stxxl::uint64>    file_n_vertices;  // completed files
+    std::vector<std::vector<int>> file_leaves;
+    std::vector<int>              current_file_leaves;
+};
+
+// I/O of the cell files during a fill (see FileManager).
+struct FileManagerCounters
+{
+    stxxl::uint64 points_written = 0;       // vertex records (a vertex sampled for LOD is written more than once)
+    stxxl::uint64 bytes_written  = 0;
+    stxxl::uint64 files_opened   = 0;       // (re)opened files: the first opening and those after an eviction
+    stxxl::uint64 evictions      = 0;       // files closed to stay within the open file limit
+};
+
+class FileManager;
+
 class BinarySpacePartition
 {
 private:
@@ -61,17 +165,51 @@ private:
 
     std::vector<BspCell *> leaves;    // Bsp leaves. Each leaf refers to its files.
 
-    stxxl::vector<int> vtx2cell;
-    stxxl::vector<int> vtx2boundary;
+    std::vector<BspCell *> lod_nodes;   // Inner cells receiving a LOD sample of their subtree (see set_lod). Empty: no LOD.
+
+    std::unique_ptr<MeshBookkeeping> mesh;     // Allocated by the fill of a mesh (with_polys) only.
 
-    std::vector<Point> input_coords;
+    std::vector<std::string> scratch_directories;   // Intermediate cell files, round-robin by cell. Empty: the out directory.
 
-    std::map<stxxl::uint64, ConstrainedVertex> constrained_vertices;
+    double resolution = 0;          // Quantization of the intermediate point files (0: raw doubles). See point_codec.h
+
+    uint8_t attribute_mask = 0;     // Point attributes carried by the intermediate point files. See point_attributes.h
+
+    std::vector<stxxl::uint64>    file_n_vertices;   // Per input file (as filled): number of vertices.
+    std::vector<std::vector<int>> file_leaves;       // Per input file (as filled): leaves receiving at least one of its vertices.
+
+    FileManagerCounters fill_counters;      // I/O of the cell files during the last fill.
+
+    ProgressCallback progress = console_progress;   // Of the fill and of the tile writers. Empty: quiet.
 
     ///////////////////////////
     /// METHODS
     ///////////////////////////
 
+    void set_cell_filenames (BspCell &cell, const std::string directory) const;
+
+    std::string get_scratch_directory (const int i, const std::string out_directory) const;
+
+    void split_cell (BspCell &cell, const int left_id, const int right_id, const std::string out_directory, const std::string sample_prefix);
+
+    void split_subtree (BspCell *cell, const int max_vtx_per_cell, const std::string out_directory,
+                        std::atomic<int> &provisional_id, TaskPool &pool);
+
+    // reads the binary copy of the inputs or, if input_binary_filename is empty, the input files themselves
+    void fill (const std::string input_binary_filename, const std::vector<std::string> &input_filenames,
+               const unsigned int n_input_files, bool with_polys,
+               const FillProgress *resume,
+               const std::function<void(const FillProgress &)> &checkpoint, const stxxl::uint64 checkpoint_interval,
+               const stxxl::uint64 first_vertex = 0);
+
+    // triangles of the current input file: corners sorted by vertex, joined with the vertex cells, sorted back by triangle
+    void classify_triangles (std::istream &binary_mesh, const stxxl::uint64 n_triangles, FileManager &file_manager);
+
+    void find_constrained_vertices ();
+
+    void write_index_node (std::ostream &os, const BspCell &cell) const;
+    bool read_index_node  (std::istream &is, BspCell &cell);
+
 public:
 
     BinarySpacePartition () {}
@@ -81,19 +219,82 @@ public:
     unsigned int get_n_leaves () const { return leaves.size(); }
     BspCell *get_leaf (const unsigned int i) { return leaves.at(i); }
 
-    const Point &get_point (const unsigned int i) { return input_coords.at(i); }
+    // Cells with an inner vertex file: the leaves, then the LOD cells (positions get_n_leaves() ... get_n_cells() - 1)
+    unsigned int get_n_cells () const { return leaves.size() + lod_nodes.size(); }
+    BspCell *get_cell (const unsigned int i) { return (i < leaves.size()) ? leaves.at(i) : lod_nodes.at(i - leaves.size()); }
+
+    std::string get_cell_name (const unsigned int i) const;     // of the output files: cell_<leaf> or lod_<cell ID>
+
+    unsigned int get_n_lod_nodes () const { return lod_nodes.size(); }
 
-    void create (const int max_vtx_per_cell, const std::string out_directory);
+    bool has_polys () const { return mesh != nullptr; }     // filled as a mesh: leaves have triangle and boundary vertex files
+
+
+    const BspCell &get_root () const { return root; }
+
+    // Directories (e.g. one per local disk) holding the intermediate files of the cells instead of the out directory
+    void set_scratch_directories (const std::vector<std::string> &directories);
+
+    double get_resolution () const { return resolution; }
+    void   set_resolution (const double resolution) { this->resolution = resolution; }
+
+    uint8_t get_attribute_mask () const { return attribute_mask; }
+    void    set_attribute_mask (const uint8_t attribute_mask) { this->attribute_mask = attribute_mask; }
+
+    const ProgressCallback &get_progress () const { return progress; }
+    void                    set_progress (const ProgressCallback &progress) { this->progress = progress; }
+
+    stxxl::uint64 get_file_n_vertices (const unsigned int f) const { return file_n_vertices.at(f); }
+    const std::vector<int> &get_file_leaves (const unsigned int f) const { return file_leaves.at(f); }
+
+    const FileManagerCounters &get_fill_counters () const { return fill_counters; }
+
+    void set_leaf_filenames (const std::string out_directory);     // (re)names the intermediate files of the leaves after their IDs
+
+    BspCell *locate_leaf (const double x, const double y, const double z);     // leaf containing the point (descending from the root)
+
+    // positions of the leaves whose cells intersect (or touch) the box (descending from the root)
+    void find_leaves (const Vtx &bb_min, const Vtx &bb_max, std::vector<int> &leaf_positions) const;
+
+    // Compact binary index of the tree: split planes, cell bboxes and, for leaves, counts and tile filenames.
+    // A loaded index classifies new points (locate_leaf) without rebuilding the tree.
+    bool save_index (const std::string filename) const;
+    bool load_index (const std::string filename);
+
+    void create (const int max_vtx_per_cell, const std::string out_directory, const unsigned int n_threads = 1);
+
+    // Level of detail (point clouds, before the fill): every inner cell receives about points_per_cell points of its
+    // subtree, estimated by the sample of create (inner vertices of the inner cells) times points_per_sample.
+    // A point is kept by the cells whose probability is above a hash of its id: samples are nested from the root down.
+    void set_lod (const stxxl::uint64 points_per_cell, const double points_per_sample, const std::string out_directory);
     void fill   (const std::string input_binary_filename, const unsigned intn_input_files, bool with_polys = true);
 
-    void split_cell (BspCell &cell, const std::string out_directory);
+    // Point cloud fill that calls checkpoint() every checkpoint_interval vertices, with all leaf files flushed,
+    // and that can be resumed from one of those checkpoints (the leaf files are truncated to their flushed length)
+    void fill   (const std::string input_binary_filename, const unsigned int n_input_files,
+                 const FillProgress *resume,
+                 const std::function<void(const FillProgress &)> &checkpoint, const stxxl::uint64 checkpoint_interval);
 
-    const int get_largest_leaf_by_inner_vertices () const;
+    // Point cloud fill reading the input files (.xyz, .las) directly, instead of their binary copy.
+    // Checkpoints store the position in the input file being read.
+    void fill   (const std::vector<std::string> &input_filenames,
+                 const FillProgress *resume = nullptr,
+                 const std::function<void(const FillProgress &)> &checkpoint = nullptr, const stxxl::uint64 checkpoint_interval = 0);
+
+    // Point cloud fill of a share of the input files (distributed tiling), whose vertex ids start from first_vertex
+    void fill_share (const std::vector<std::string> &input_filenames, const stxxl::uint64 first_vertex);
+
+    void restore_fill (const FillProgress &progress);     // leaf counts and per input file statistics
+
+    void split_cell (BspCell &cell, const std::string out_directory);
 
     const BspCell & get_minimum_cell (const BspCell &a, const BspCell &b) const; // by lexicographic order of ther barycenters
 
+    // (cell, vertex) where the triangle lies and (cell, vertex) of its corners lying outside that cell (-1 if none)
     void classify_triangle (const stxxl::uint64 v1, const stxxl::uint64 v2, const stxxl::uint64 v3,
-                            std::pair<int, int> & selected_cell_vtx, std::pair<int, int> & neighbor_cell_vtx_1, std::pair<int, int> & neighbor_cell_vtx_2);
+                            const int cell_pos_v1, const int cell_pos_v2, const int cell_pos_v3,
+                            std::pair<int, stxxl::uint64> & selected_cell_vtx,
+                            std::pair<int, stxxl::uint64> & neighbor_cell_vtx_1, std::pair<int, stxxl::uint64> & neighbor_cell_vtx_2);
 
 #ifdef USE_CEREAL
 
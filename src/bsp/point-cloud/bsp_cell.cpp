@@ -27,6 +27,78 @@
 *                                                                               *
 *********************************************************************************/
 #include "bsp_cell.h"
+#include "binary_io.h"
+
+void PointStatistics::add (const double x, const double y, const double z)
+{
+    const double p[3] = { x, y, z };
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (p[i] < min[i]) min[i] = p[i];
+        if (p[i] > max[i]) max[i] = p[i];
+    }
+}
+
+void PointStatistics::add (const double x, const double y, const double z, const PointAttributes &attributes, const uint8_t attribute_mask)
+{
+    add(x, y, z);
+
+    if ((attribute_mask & ATTRIBUTE_RETURNS) && attributes.return_number >= 1 && attributes.return_number <= N_RETURN_COUNTS)
+        n_points_by_return[attributes.return_number - 1]++;
+
+    if ((attribute_mask & ATTRIBUTE_CLASSIFICATION) && attributes.classification < N_CLASSES)
+        n_points_by_class[attributes.classification]++;
+}
+
+void PointStatistics::add (const PointStatistics &statistics)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        if (statistics.min[i] < min[i]) min[i] = statistics.min[i];
+        if (statistics.max[i] > max[i]) max[i] = statistics.max[i];
+    }
+
+    for (int r = 0; r < N_RETURN_COUNTS; r++)
+        n_points_by_return[r] += statistics.n_points_by_return[r];
+
+    for (int c = 0; c < N_CLASSES; c++)
+        n_points_by_class[c] += statistics.n_points_by_class[c];
+}
+
+void write_statistics (std::ostream &os, const PointStatistics &statistics)
+{
+    for (int i = 0; i < 3; i++) write_value(os, statistics.min[i]);
+    for (int i = 0; i < 3; i++) write_value(os, statistics.max[i]);
+
+    for (int r = 0; r < N_RETURN_COUNTS; r++)
+        write_value(os, static_cast<uint64_t>(statistics.n_points_by_return[r]));
+
+    for (int c = 0; c < N_CLASSES; c++)
+        write_value(os, static_cast<uint64_t>(statistics.n_points_by_class[c]));
+}
+
+bool read_statistics (std::istream &is, PointStatistics &statistics)
+{
+    uint64_t n = 0;
+
+    for (int i = 0; i < 3; i++) read_value(is, statistics.min[i]);
+    for (int i = 0; i < 3; i++) read_value(is, statistics.max[i]);
+
+    for (int r = 0; r < N_RETURN_COUNTS; r++)
+    {
+        read_value(is, n);
+        statistics.n_points_by_return[r] = n;
+    }
+
+    for (int c = 0; c < N_CLASSES; c++)
+    {
+        read_value(is, n);
+        statistics.n_points_by_class[c] = n;
+    }
+
+    return !is.fail();
+}
 
 BspCell::BspCell (const Vtx &v1, const Vtx &v2)
 {
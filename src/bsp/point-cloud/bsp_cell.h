@@ -30,6 +30,7 @@
 #define BSP_CELL_H
 
 #include "geometry_items.h"
+#include "point_attributes.h"
 
 #include <stxxl.h>
 
@@ -40,6 +41,30 @@
 #include <cereal/types/set.hpp>
 #endif
 
+#define N_RETURN_COUNTS 5       // LAS header: points by return number (1 to 5)
+#define N_CLASSES       32      // LAS classification values (5 bits)
+
+// Statistics of the inner vertices of a cell, accumulated while they are classified: the tile header is written
+// without scanning the tile (tight bounding box, points by return) and a catalog can index tiles by them.
+struct PointStatistics
+{
+    double min[3] = { DBL_MAX,  DBL_MAX,  DBL_MAX};
+    double max[3] = {-DBL_MAX, -DBL_MAX, -DBL_MAX};
+
+    stxxl::uint64 n_points_by_return[N_RETURN_COUNTS] = {};      // counted if the attributes have the returns
+    stxxl::uint64 n_points_by_class[N_CLASSES] = {};             // counted if the attributes have the classification
+
+    void add (const double x, const double y, const double z);
+    void add (const double x, const double y, const double z, const PointAttributes &attributes, const uint8_t attribute_mask);
+    void add (const PointStatistics &statistics);      // of other points (e.g. another fragment of the cell)
+
+    bool is_empty () const { return min[0] > max[0]; }
+};
+
+// field by field (bsp.index, checkpoints, worker reports)
+void write_statistics (std::ostream &os, const PointStatistics &statistics);
+bool read_statistics  (std::istream &is, PointStatistics &statistics);
+
 class BspCell {
 
 public:
@@ -52,6 +77,11 @@ public:
     stxxl::uint64 n_inner_vertices   = 0;    // Number of vertices actually lying inside the cell.
     stxxl::uint64 n_inner_triangles  = 0;    // Number of triangles classified as belonging to the cell.
 
+    PointStatistics statistics;             // Of the inner vertices (leaves, once filled) or of the LOD sample (inner cells).
+
+    double lod_probability = 0;             // Inner cells: probability that a point of the subtree is in their LOD sample.
+    int    lod_position    = -1;            // Inner cells with a LOD sample: position (see BinarySpacePartition::get_cell).
+
 //    stxxl::vector<Vtx> inner_vertices;
 //    stxxl::vector<TriangleStruct> inner_triangles;
 //    stxxl::vector<stxxl::uint64> bv_vertices;
@@ -28,6 +28,39 @@
 *********************************************************************************/
 #include "file_manager.h"
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+bool FileManager::truncate_file (const std::string &filename, const stxxl::uint64 length)
+{
+#ifdef _WIN32
+    int fd = -1;
+
+    if (_sopen_s(&fd, filename.c_str(), _O_RDWR | _O_BINARY | _O_CREAT, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0)
+        return false;
+
+    bool success = (_chsize_s(fd, length) == 0);
+
+    _close(fd);
+
+    return success;
+#else
+    if (length == 0)
+    {
+        std::ofstream os (filename.c_str(), std::ofstream::out | std::ofstream::binary);
+        return os.is_open();
+    }
+
+    return truncate(filename.c_str(), length) == 0;
+#endif
+}
+
 void FileManager::close_oldest_file()
 {
     if (n_open_files == 0)
@@ -47,6 +80,9 @@ void FileManager::close_oldest_file()
             file_id = leaf;
         }
 
+        if (!with_polys || leaf >= tOuts.size())
+            continue;
+
         if (tOuts.at(leaf)->is_open() && tOuts_usage.at(leaf) < usage)
         {
             usage = tOuts_usage.at(leaf);
@@ -66,7 +102,7 @@ void FileManager::close_oldest_file()
         return;
 
     if (file_type == 0)
-        vOuts.at(file_id)->close();
+        close_vOut(file_id);
     else
     if (file_type == 1)
         tOuts.at(file_id)->close();
@@ -80,18 +116,22 @@ void FileManager::close_oldest_file()
     }
 
     n_open_files--;
+    counters.evictions++;
 }
 
 void FileManager::close_all ()
 {
-    for (int leaf = 0; leaf < bsp->get_n_leaves(); leaf++)
+    for (int leaf = 0; leaf < vOuts.size(); leaf++)
     {
         if (vOuts.at(leaf)->is_open())
         {
-           vOuts.at(leaf)->close();
+           close_vOut(leaf);
            n_open_files--;
         }
 
+        if (!with_polys || leaf >= tOuts.size())
+            continue;
+
         if (tOuts.at(leaf)->is_open() )
         {
             tOuts.at(leaf)->close();
@@ -108,6 +148,22 @@ void FileManager::close_all ()
     assert (n_open_files == 0);
 }
 
+void FileManager::close_vOut (const int leaf)
+{
+    const stxxl::uint64 bytes = vEncoders.at(leaf).flush(*vOuts.at(leaf));
+
+    vOuts_bytes.at(leaf) += bytes;
+    counters.bytes_written += bytes;
+
+    vOuts.at(leaf)->close();
+
+    if (vOuts.at(leaf)->fail())
+    {
+        std::cout << "[ERROR] Writing file " << bsp->get_cell(leaf)->filename_inner_v << std::endl;
+        exit(1);
+    }
+}
+
 void FileManager::guarantee_vOut_open  (const int leaf)
 {
     if (vOuts.at(leaf)->is_open())
@@ -116,15 +172,16 @@ void FileManager::guarantee_vOut_open  (const int leaf)
     if (n_open_files == max_open_file)
         close_oldest_file();
 
-    vOuts.at(leaf)->open (bsp->get_leaf(leaf)->filename_inner_v.c_str(), std::ofstream::app | std::ofstream::binary);
+    vOuts.at(leaf)->open (bsp->get_cell(leaf)->filename_inner_v.c_str(), std::ofstream::app | std::ofstream::binary);
 
     if (!vOuts.at(leaf)->is_open())
     {
-        std::cout << "[ERROR] Opening file " << bsp->get_leaf(leaf)->filename_inner_v << std::endl;
+        std::cout << "[ERROR] Opening file " << bsp->get_cell(leaf)->filename_inner_v << std::endl;
         exit(1);
     }
 
     n_open_files++;
+    counters.files_opened++;
 }
 
 void FileManager::guarantee_tOut_open  (const int leaf)
@@ -144,6 +201,7 @@ void FileManager::guarantee_tOut_open  (const int leaf)
     }
 
     n_open_files++;
+    counters.files_opened++;
 }
 
 void FileManager::guarantee_bvOut_open (const int leaf)
@@ -163,43 +221,26 @@ void FileManager::guarantee_bvOut_open (const int leaf)
     }
 
     n_open_files++;
+    counters.files_opened++;
 }
 
-void FileManager::write_vertex (const int leaf, const stxxl::uint64 vid, const double x, const double y, const double z)
+void FileManager::write_vertex (const int leaf, const stxxl::uint64 vid, const double x, const double y, const double z,
+                                const PointAttributes *attributes)
 {
     guarantee_vOut_open(leaf);
 
     assert(vOuts.at(leaf)->is_open());
 
-    vOuts.at(leaf)->write(reinterpret_cast<const char*>(&vid), sizeof vid);
+    const stxxl::uint64 bytes = vEncoders.at(leaf).write(*vOuts.at(leaf), vid, x, y, z, attributes);
 
-    if ((vOuts.at(leaf)->fail()))
-    {
-        std::cout << "[ERROR] Writing vertex " << vid << " in cell " << bsp->get_leaf(leaf)->ID << std::endl;
-        exit(1);
-    }
+    vOuts_bytes.at(leaf) += bytes;
 
-    vOuts.at(leaf)->write(reinterpret_cast<const char*>(&x), sizeof x);
+    counters.points_written++;
+    counters.bytes_written += bytes;
 
-    if ((vOuts.at(leaf)->rdstate() & std::ofstream::badbit) != 0)
-    {
-        std::cout << "[ERROR] Writing vertex " << vid << " in cell " << bsp->get_leaf(leaf)->ID << std::endl;
-        exit(1);
-    }
-
-    vOuts.at(leaf)->write(reinterpret_cast<const char*>(&y), sizeof y);
-
-    if ((vOuts.at(leaf)->rdstate() & std::ofstream::badbit) != 0)
-    {
-        std::cout << "[ERROR] Writing vertex " << vid << " in cell " << bsp->get_leaf(leaf)->ID << std::endl;
-        exit(1);
-    }
-
-    vOuts.at(leaf)->write(reinterpret_cast<const char*>(&z), sizeof z);
-
-    if ((vOuts.at(leaf)->rdstate() & std::ofstream::badbit) != 0)
+    if ((vOuts.at(leaf)->fail()))
     {
-        std::cout << "[ERROR] Writing vertex " << vid << " in cell " << bsp->get_leaf(leaf)->ID << std::endl;
+        std::cout << "[ERROR] Writing vertex " << vid << " in cell " << bsp->get_cell(leaf)->ID << std::endl;
         exit(1);
     }
 
@@ -244,22 +285,7 @@ void FileManager::write_boundary_vertex (const int leaf, const stxxl::uint64 vid
         exit(1);
     }
 
-    bvOuts_usage.at(leaf) = usage_indicator;
-
-    usage_indicator++;
-}
-
-void FileManager::write_boundary_vertex (const int leaf, const stxxl::uint64 vid)
-{
-    guarantee_bvOut_open(leaf);
-
-    bvOuts.at(leaf)->write(reinterpret_cast<const char*>(&vid), sizeof vid);
-
-    if ((bvOuts.at(leaf)->rdstate() & std::ofstream::badbit) != 0)
-    {
-        std::cout << "[ERROR] Writing boundary vertex " << vid << " in cell " << bsp->get_leaf(leaf)->ID << std::endl;
-        exit(1);
-    }
+    counters.bytes_written += sizeof vid + sizeof x + sizeof y + sizeof z;
 
     bvOuts_usage.at(leaf) = usage_indicator;
 
@@ -294,6 +320,8 @@ void FileManager::write_triangle (const int leaf, const stxxl::uint64 v1, const
         exit(1);
     }
 
+    counters.bytes_written += sizeof v1 + sizeof v2 + sizeof v3;
+
     tOuts_usage.at(leaf) = usage_indicator;
 
     usage_indicator++;
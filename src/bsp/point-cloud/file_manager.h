@@ -30,6 +30,7 @@
 #define FILE_MANAGER_H
 
 #include "bsp.h"
+#include "point_codec.h"
 
 #include "stxxl.h"
 
@@ -46,27 +47,52 @@ public:
     std::vector<stxxl::uint64> tOuts_usage;
     std::vector<stxxl::uint64> bvOuts_usage;
 
+    std::vector<stxxl::uint64> vOuts_bytes;     // bytes written to each inner vertex file
+
+    std::vector<PointEncoder> vEncoders;        // pending (not yet written) block of each inner vertex file
+
     std::vector<std::ofstream *> vOuts;
     std::vector<std::ofstream *> tOuts;
     std::vector<std::ofstream *> bvOuts;
 
+    bool with_polys = true;         // point clouds have neither inner triangle nor boundary vertex files
+
     stxxl::uint64 usage_indicator = 0;
 
     int n_open_files = 0;
 
+    FileManagerCounters counters;
+
     const int max_open_file = 200;
 
 public:
 
     FileManager () {}
 
-    FileManager (BinarySpacePartition *bsp)
+    // Creates (empties) the inner vertex, inner triangle and boundary vertex files of every leaf (only the
+    // inner vertex ones for point clouds), and the inner vertex files of the LOD cells, if any. Vertex files are
+    // indexed by cell position (see BinarySpacePartition::get_cell). When resuming, inner vertex files are instead
+    // truncated to the given (flushed) lengths.
+    FileManager (BinarySpacePartition *bsp, const std::vector<stxxl::uint64> *resume_v_bytes = nullptr, const bool with_polys = true)
     {
         this->bsp = bsp;
+        this->with_polys = with_polys;
 
-        for (int leaf = 0; leaf < bsp->get_n_leaves(); leaf++)
+        for (int leaf = 0; leaf < bsp->get_n_cells(); leaf++)
         {
-            std::ofstream *os_v = new std::ofstream(bsp->get_leaf(leaf)->filename_inner_v.c_str(), std::ofstream::out | std::ofstream::binary);
+            std::ofstream *os_v;
+
+            if (resume_v_bytes != nullptr)
+            {
+                if (!truncate_file(bsp->get_cell(leaf)->filename_inner_v, resume_v_bytes->at(leaf)))
+                {
+                    std::cout << "[ERROR] Truncating file " << bsp->get_cell(leaf)->filename_inner_v << std::endl;
+                    exit(1);
+                }
+
+                os_v = new std::ofstream(bsp->get_cell(leaf)->filename_inner_v.c_str(), std::ofstream::app | std::ofstream::binary);
+            }
+            else os_v = new std::ofstream(bsp->get_cell(leaf)->filename_inner_v.c_str(), std::ofstream::out | std::ofstream::binary);
 
             if (os_v->is_open())
             {
@@ -74,8 +100,13 @@ public:
                 os_v->close();
 
                 vOuts_usage.push_back(0);
+                vOuts_bytes.push_back((resume_v_bytes != nullptr) ? resume_v_bytes->at(leaf) : 0);
+                vEncoders.push_back(PointEncoder(bsp->get_resolution(), true, bsp->get_attribute_mask()));
             }
 
+            if (!with_polys || leaf >= bsp->get_n_leaves())
+                continue;
+
             std::ofstream * os_t = new std::ofstream (bsp->get_leaf(leaf)->filename_inner_t.c_str(), std::ofstream::out | std::ofstream::binary);
 
             if (os_t->is_open())
@@ -100,16 +131,20 @@ public:
 
     }
 
+    static bool truncate_file (const std::string &filename, const stxxl::uint64 length);
+
     void close_oldest_file ();
 
+    void close_vOut (const int position);      // writes the pending block first
+
     void close_all ();
 
     void guarantee_vOut_open  (const int position);
     void guarantee_tOut_open  (const int position);
     void guarantee_bvOut_open (const int position);
 
-    void write_vertex           (const int position, const stxxl::uint64 vid, const double x, const double y, const double z);
-    void write_boundary_vertex  (const int position, const stxxl::uint64 vid);
+    void write_vertex           (const int position, const stxxl::uint64 vid, const double x, const double y, const double z,
+                                 const PointAttributes *attributes = nullptr);
     void write_boundary_vertex  (const int position, const stxxl::uint64 vid, const double x, const double y, const double z);
     void write_triangle         (const int position, const stxxl::uint64 v1, const stxxl::uint64 v2, const stxxl::uint64 v3);
 
@@ -0,0 +1,886 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "mesh_ingest.h"
+#include "binary_io.h"
+#include "bsp.h"
+#include "point_codec.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace OOC3DTileLib {
+
+// Records of the (out of core) vertex deduplication. The sort comparators provide the sentinels STXXL needs.
+
+struct MeshInputVertex
+{
+    double        x, y, z;
+    stxxl::uint64 index;            // order of appearance in the input file
+};
+
+struct MeshInputCorner
+{
+    stxxl::uint64 tid;
+    int           corner;
+    stxxl::uint64 index;            // input vertex, then (after the remap) unique vertex id
+};
+
+struct MeshUniqueVertex
+{
+    stxxl::uint64 first;            // first input vertex with these coordinates
+    double        x, y, z;
+};
+
+struct MeshVertexRemap
+{
+    stxxl::uint64 index;
+    stxxl::uint64 first;
+    stxxl::uint64 vid;              // unique vertex id
+};
+
+struct MeshInputVertexByCoords
+{
+    bool operator() (const MeshInputVertex &a, const MeshInputVertex &b) const
+    {
+        if (a.x != b.x) return a.x < b.x;
+        if (a.y != b.y) return a.y < b.y;
+        if (a.z != b.z) return a.z < b.z;
+        return a.index < b.index;
+    }
+
+    MeshInputVertex min_value () const { MeshInputVertex v; v.x = v.y = v.z = -DBL_MAX; v.index = 0; return v; }
+    MeshInputVertex max_value () const { MeshInputVertex v; v.x = v.y = v.z = DBL_MAX; v.index = UINT64_MAX; return v; }
+};
+
+struct MeshInputCornerByIndex
+{
+    bool operator() (const MeshInputCorner &a, const MeshInputCorner &b) const { return a.index < b.index || (a.index == b.index && a.tid < b.tid); }
+
+    MeshInputCorner min_value () const { MeshInputCorner c; c.index = c.tid = 0; c.corner = 0; return c; }
+    MeshInputCorner max_value () const { MeshInputCorner c; c.index = c.tid = UINT64_MAX; c.corner = 0; return c; }
+};
+
+struct MeshInputCornerByTriangle
+{
+    bool operator() (const MeshInputCorner &a, const MeshInputCorner &b) const { return a.tid < b.tid || (a.tid == b.tid && a.corner < b.corner); }
+
+    MeshInputCorner min_value () const { MeshInputCorner c; c.index = c.tid = 0; c.corner = INT_MIN; return c; }
+    MeshInputCorner max_value () const { MeshInputCorner c; c.index = c.tid = UINT64_MAX; c.corner = INT_MAX; return c; }
+};
+
+struct MeshUniqueVertexByFirst
+{
+    bool operator() (const MeshUniqueVertex &a, const MeshUniqueVertex &b) const { return a.first < b.first; }
+
+    MeshUniqueVertex min_value () const { MeshUniqueVertex v; v.first = 0; v.x = v.y = v.z = 0; return v; }
+    MeshUniqueVertex max_value () const { MeshUniqueVertex v; v.first = UINT64_MAX; v.x = v.y = v.z = 0; return v; }
+};
+
+struct MeshVertexRemapByFirst
+{
+    bool operator() (const MeshVertexRemap &a, const MeshVertexRemap &b) const { return a.first < b.first || (a.first == b.first && a.index < b.index); }
+
+    MeshVertexRemap min_value () const { MeshVertexRemap r; r.index = r.first = r.vid = 0; return r; }
+    MeshVertexRemap max_value () const { MeshVertexRemap r; r.index = r.first = r.vid = UINT64_MAX; return r; }
+};
+
+struct MeshVertexRemapByIndex
+{
+    bool operator() (const MeshVertexRemap &a, const MeshVertexRemap &b) const { return a.index < b.index; }
+
+    MeshVertexRemap min_value () const { MeshVertexRemap r; r.index = r.first = r.vid = 0; return r; }
+    MeshVertexRemap max_value () const { MeshVertexRemap r; r.index = r.first = r.vid = UINT64_MAX; return r; }
+};
+
+// Vertices and triangle corners of one input file, as read (on disk)
+struct MeshSoup
+{
+    stxxl::vector<MeshInputVertex> vertices;
+    stxxl::vector<MeshInputCorner> corners;
+
+    stxxl::uint64 n_triangles = 0;
+
+    Vtx bb_min, bb_max;
+
+    MeshSoup ()
+    {
+        bb_min.x = bb_min.y = bb_min.z = DBL_MAX;
+        bb_max.x = bb_max.y = bb_max.z = -DBL_MAX;
+    }
+
+    void add_vertex (const double x, const double y, const double z)
+    {
+        if (!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(z))
+        {
+            std::cerr << "[ERROR] Vertex " << vertices.size() << " has non finite coordinates" << std::endl;
+            exit(1);
+        }
+
+        MeshInputVertex v;
+        v.x = x;
+        v.y = y;
+        v.z = z;
+        v.index = vertices.size();
+
+        vertices.push_back(v);
+
+        bb_min.x = std::min(bb_min.x, x); bb_max.x = std::max(bb_max.x, x);
+        bb_min.y = std::min(bb_min.y, y); bb_max.y = std::max(bb_max.y, y);
+        bb_min.z = std::min(bb_min.z, z); bb_max.z = std::max(bb_max.z, z);
+    }
+
+    void add_triangle (const stxxl::uint64 v1, const stxxl::uint64 v2, const stxxl::uint64 v3)
+    {
+        const stxxl::uint64 v[3] = {v1, v2, v3};
+
+        for (int k = 0; k < 3; k++)
+        {
+            MeshInputCorner c;
+            c.tid = n_triangles;
+            c.corner = k;
+            c.index = v[k];
+
+            corners.push_back(c);
+        }
+
+        n_triangles++;
+    }
+
+    // fan triangulation
+    void add_polygon (const std::vector<stxxl::uint64> &polygon)
+    {
+        for (unsigned int i = 2; i < polygon.size(); i++)
+            add_triangle(polygon.at(0), polygon.at(i-1), polygon.at(i));
+    }
+};
+
+inline
+std::string lowercase_extension (const std::string &filename)
+{
+    size_t pos = filename.find_last_of(".");
+
+    std::string ext = (pos == std::string::npos) ? "" : filename.substr(pos);
+
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    return ext;
+}
+
+inline
+bool is_mesh_file (const std::string &filename)
+{
+    std::string ext = lowercase_extension(filename);
+
+    return ext.compare(".stl") == 0 || ext.compare(".ply") == 0 || ext.compare(".off") == 0;
+}
+
+template <typename T>
+inline bool read_binary_value (std::istream &is, T &value, const bool little_endian)
+{
+    char bytes[sizeof(T)];
+
+    if (!is.read(bytes, sizeof(T)))
+        return false;
+
+    if (little_endian != host_is_little_endian())
+        std::reverse(bytes, bytes + sizeof(T));
+
+    std::memcpy(&value, bytes, sizeof(T));
+
+    return true;
+}
+
+///////////////////////////
+/// STL
+///////////////////////////
+
+inline
+bool read_stl (const std::string &filename, MeshSoup &soup, const ProgressCallback &progress)
+{
+    std::ifstream is (filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!is.is_open())
+        return false;
+
+    is.seekg(0, std::ios::end);
+    const stxxl::uint64 file_size = is.tellg();
+    is.seekg(0, std::ios::beg);
+
+    char header[80];
+    uint32_t n_facets = 0;
+
+    is.read(header, sizeof(header));
+    read_binary_value(is, n_facets, true);
+
+    // binary, unless its size disagrees with the facet count and it starts as an ASCII one
+    const bool binary = !is.fail() && file_size == 84 + 50 * (stxxl::uint64) n_facets;
+
+    if (binary || std::strncmp(header, "solid", 5) != 0)
+    {
+        ProgressReporter reporter (progress, "ingest", "Reading Triangles", n_facets);
+
+        for (stxxl::uint64 t = 0; t < n_facets; t++)
+        {
+            reporter.update(t);
+
+            float normal_and_coords[12];
+            uint16_t attribute;
+
+            for (int k = 0; k < 12; k++)
+                read_binary_value(is, normal_and_coords[k], true);
+
+            if (!read_binary_value(is, attribute, true))
+            {
+                std::cerr << "[ERROR] Reading facet " << t << " of " << filename << std::endl;
+                return false;
+            }
+
+            for (int k = 1; k < 4; k++)
+                soup.add_vertex(normal_and_coords[3*k], normal_and_coords[3*k+1], normal_and_coords[3*k+2]);
+
+            const stxxl::uint64 n = soup.vertices.size();
+
+            soup.add_triangle(n-3, n-2, n-1);
+        }
+
+        reporter.complete();
+
+        return true;
+    }
+
+    is.seekg(0, std::ios::beg);
+
+    std::string line;
+    int n_facet_vertices = 0;
+
+    while (std::getline(is, line))
+    {
+        const char *ptr = line.c_str();
+
+        while (*ptr == ' ' || *ptr == '\t')
+            ptr++;
+
+        if (std::strncmp(ptr, "facet", 5) == 0)
+            n_facet_vertices = 0;
+        else
+        if (std::strncmp(ptr, "vertex", 6) == 0)
+        {
+            char *end;
+
+            ptr += 6;
+
+            double x = strtod(ptr, &end); ptr = end;
+            double y = strtod(ptr, &end); ptr = end;
+            double z = strtod(ptr, &end);
+
+            if (end == ptr)
+            {
+                std::cerr << "[ERROR] Reading " << filename << ": " << line << std::endl;
+                return false;
+            }
+
+            soup.add_vertex(x, y, z);
+
+            if (++n_facet_vertices == 3)
+            {
+                const stxxl::uint64 n = soup.vertices.size();
+
+                soup.add_triangle(n-3, n-2, n-1);
+            }
+        }
+    }
+
+    return true;
+}
+
+///////////////////////////
+/// OFF
+///////////////////////////
+
+// next line that is neither blank nor a comment
+inline
+bool next_off_line (std::istream &is, std::string &line)
+{
+    while (std::getline(is, line))
+    {
+        size_t pos = line.find('#');
+
+        if (pos != std::string::npos)
+            line.erase(pos);
+
+        if (line.find_first_not_of(" \t\r") != std::string::npos)
+            return true;
+    }
+
+    return false;
+}
+
+inline
+bool read_off (const std::string &filename, MeshSoup &soup)
+{
+    std::ifstream is (filename.c_str());
+
+    if (!is.is_open())
+        return false;
+
+    std::string line;
+
+    if (!next_off_line(is, line))
+        return false;
+
+    std::istringstream header (line);
+    std::string keyword;
+
+    header >> keyword;
+
+    // OFF, COFF, NOFF, CNOFF, STOFF, ... (extra per vertex values are ignored)
+    if (keyword.size() < 3 || keyword.compare(keyword.size() - 3, 3, "OFF") != 0)
+    {
+        std::cerr << "[ERROR] " << filename << " is not an OFF file" << std::endl;
+        return false;
+    }
+
+    stxxl::uint64 n_v = 0, n_f = 0;
+
+    // the counts may follow the keyword on the same line
+    if (!(header >> n_v >> n_f))
+    {
+        if (line.find("BINARY") != std::string::npos || !next_off_line(is, line))
+        {
+            std::cerr << "[ERROR] Unsupported OFF header in " << filename << std::endl;
+            return false;
+        }
+
+        std::istringstream counts (line);
+
+        if (!(counts >> n_v >> n_f))
+        {
+            std::cerr << "[ERROR] Unsupported OFF header in " << filename << std::endl;
+            return false;
+        }
+    }
+
+    for (stxxl::uint64 v = 0; v < n_v; v++)
+    {
+        char *end;
+
+        if (!next_off_line(is, line))
+        {
+            std::cerr << "[ERROR] Reading vertex " << v << " of " << filename << std::endl;
+            return false;
+        }
+
+        const char *ptr = line.c_str();
+
+        double x = strtod(ptr, &end); ptr = end;
+        double y = strtod(ptr, &end); ptr = end;
+        double z = strtod(ptr, &end);
+
+        soup.add_vertex(x, y, z);
+    }
+
+    std::vector<stxxl::uint64> polygon;
+
+    for (stxxl::uint64 f = 0; f < n_f; f++)
+    {
+        if (!next_off_line(is, line))
+        {
+            std::cerr << "[ERROR] Reading face " << f << " of " << filename << std::endl;
+            return false;
+        }
+
+        const char *ptr = line.c_str();
+        char *end;
+
+        stxxl::uint64 n = strtoull(ptr, &end, 10); ptr = end;
+
+        polygon.resize(n);
+
+        for (stxxl::uint64 i = 0; i < n; i++)
+        {
+            polygon.at(i) = strtoull(ptr, &end, 10);
+
+            if (end == ptr || polygon.at(i) >= n_v)
+            {
+                std::cerr << "[ERROR] Reading face " << f << " of " << filename << std::endl;
+                return false;
+            }
+
+            ptr = end;
+        }
+
+        soup.add_polygon(polygon);
+    }
+
+    return true;
+}
+
+///////////////////////////
+/// PLY
+///////////////////////////
+
+struct PlyProperty
+{
+    std::string name;
+    std::string type;
+    std::string count_type;         // list properties only
+
+    bool is_list () const { return !count_type.empty(); }
+};
+
+struct PlyElement
+{
+    std::string name;
+    stxxl::uint64 count = 0;
+
+    std::vector<PlyProperty> properties;
+};
+
+inline
+bool read_ply_value (std::istream &is, const std::string &type, const int format, double &value)
+{
+    if (format == 0)
+        return static_cast<bool>(is >> value);
+
+    const bool le = (format == 1);
+
+    if (type == "char"   || type == "int8")    { int8_t   v; if (!read_binary_value(is, v, le)) return false; value = v; return true; }
+    if (type == "uchar"  || type == "uint8")   { uint8_t  v; if (!read_binary_value(is, v, le)) return false; value = v; return true; }
+    if (type == "short"  || type == "int16")   { int16_t  v; if (!read_binary_value(is, v, le)) return false; value = v; return true; }
+    if (type == "ushort" || type == "uint16")  { uint16_t v; if (!read_binary_value(is, v, le)) return false; value = v; return true; }
+    if (type == "int"    || type == "int32")   { int32_t  v; if (!read_binary_value(is, v, le)) return false; value = v; return true; }
+    if (type == "uint"   || type == "uint32")  { uint32_t v; if (!read_binary_value(is, v, le)) return false; value = v; return true; }
+    if (type == "float"  || type == "float32") { float    v; if (!read_binary_value(is, v, le)) return false; value = v; return true; }
+    if (type == "double" || type == "float64") { double   v; if (!read_binary_value(is, v, le)) return false; value = v; return true; }
+
+    std::cerr << "[ERROR] Unsupported PLY property type " << type << std::endl;
+    return false;
+}
+
+inline
+bool read_ply (const std::string &filename, MeshSoup &soup)
+{
+    std::ifstream is (filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!is.is_open())
+        return false;
+
+    std::string line, keyword;
+
+    int format = -1;                // 0: ascii, 1: binary little endian, 2: binary big endian
+
+    std::vector<PlyElement> elements;
+
+    if (!std::getline(is, line) || line.compare(0, 3, "ply") != 0)
+    {
+        std::cerr << "[ERROR] " << filename << " is not a PLY file" << std::endl;
+        return false;
+    }
+
+    while (std::getline(is, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        std::istringstream tokens (line);
+        tokens >> keyword;
+
+        if (keyword == "end_header")
+            break;
+
+        if (keyword == "format")
+        {
+            std::string name;
+            tokens >> name;
+
+            format = (name == "ascii") ? 0 : (name == "binary_little_endian") ? 1 : (name == "binary_big_endian") ? 2 : -1;
+        }
+        else
+        if (keyword == "element")
+        {
+            elements.push_back(PlyElement());
+            tokens >> elements.back().name >> elements.back().count;
+        }
+        else
+        if (keyword == "property" && !elements.empty())
+        {
+            PlyProperty property;
+            tokens >> property.type;
+
+            if (property.type == "list")
+                tokens >> property.count_type >> property.type;
+
+            tokens >> property.name;
+
+            elements.back().properties.push_back(property);
+        }
+    }
+
+    if (format < 0)
+    {
+        std::cerr << "[ERROR] Unsupported PLY format in " << filename << std::endl;
+        return false;
+    }
+
+    stxxl::uint64 n_v = 0;
+
+    std::vector<stxxl::uint64> polygon;
+
+    for (const PlyElement &element : elements)
+    {
+        const bool is_vertex = (element.name == "vertex");
+        const bool is_face   = (element.name == "face");
+
+        std::cout << " --- --- Reading " << element.count << " " << element.name << " elements" << std::endl;
+
+        for (stxxl::uint64 e = 0; e < element.count; e++)
+        {
+            double xyz[3] = {0, 0, 0};
+
+            polygon.clear();
+
+            for (const PlyProperty &property : element.properties)
+            {
+                double value;
+
+                if (!property.is_list())
+                {
+                    if (!read_ply_value(is, property.type, format, value))
+                    {
+                        std::cerr << "[ERROR] Reading " << element.name << " " << e << " of " << filename << std::endl;
+                        return false;
+                    }
+
+                    if (is_vertex && property.name.size() == 1 && property.name[0] >= 'x' && property.name[0] <= 'z')
+                        xyz[property.name[0] - 'x'] = value;
+
+                    continue;
+                }
+
+                double count;
+
+                if (!read_ply_value(is, property.count_type, format, count))
+                {
+                    std::cerr << "[ERROR] Reading " << element.name << " " << e << " of " << filename << std::endl;
+                    return false;
+                }
+
+                const bool is_polygon = is_face && (property.name == "vertex_indices" || property.name == "vertex_index");
+
+                for (stxxl::uint64 i = 0; i < (stxxl::uint64) count; i++)
+                {
+                    if (!read_ply_value(is, property.type, format, value))
+                    {
+                        std::cerr << "[ERROR] Reading " << element.name << " " << e << " of " << filename << std::endl;
+                        return false;
+                    }
+
+                    if (is_polygon)
+                    {
+                        if (value < 0 || value >= n_v)
+                        {
+                            std::cerr << "[ERROR] Face " << e << " of " << filename << " refers to the missing vertex " << value << std::endl;
+                            return false;
+                        }
+
+                        polygon.push_back((stxxl::uint64) value);
+                    }
+                }
+            }
+
+            if (is_vertex)
+            {
+                soup.add_vertex(xyz[0], xyz[1], xyz[2]);
+                n_v++;
+            }
+            else
+            if (is_face)
+                soup.add_polygon(polygon);
+        }
+    }
+
+    return true;
+}
+
+///////////////////////////
+/// INGEST
+///////////////////////////
+
+inline
+bool read_mesh (const std::string &filename, MeshSoup &soup, const ProgressCallback &progress)
+{
+    std::string ext = lowercase_extension(filename);
+
+    if (ext.compare(".stl") == 0)
+        return read_stl(filename, soup, progress);
+
+    if (ext.compare(".ply") == 0)
+        return read_ply(filename, soup);
+
+    if (ext.compare(".off") == 0)
+        return read_off(filename, soup);
+
+    return false;
+}
+
+// Merges the coincident vertices of the soup. Unique vertices are numbered by first appearance and the
+// corners of the soup get those numbers (in triangle order).
+inline
+void merge_vertices (MeshSoup &soup, stxxl::vector<MeshUniqueVertex> &unique_vertices)
+{
+    const stxxl::uint64 n_input_vertices = soup.vertices.size();
+
+    stxxl::sort(soup.vertices.begin(), soup.vertices.end(), MeshInputVertexByCoords(), MESH_SORT_MEMORY);
+
+    stxxl::vector<MeshVertexRemap> remap;
+
+    for (stxxl::vector<MeshInputVertex>::const_iterator it = soup.vertices.begin(); it != soup.vertices.end(); )
+    {
+        MeshUniqueVertex unique_vertex;
+        unique_vertex.first = it->index;    // the smallest index of the group: ties are sorted by index
+        unique_vertex.x = it->x;
+        unique_vertex.y = it->y;
+        unique_vertex.z = it->z;
+
+        unique_vertices.push_back(unique_vertex);
+
+        for (; it != soup.vertices.end() && it->x == unique_vertex.x && it->y == unique_vertex.y && it->z == unique_vertex.z; ++it)
+        {
+            MeshVertexRemap r;
+            r.index = it->index;
+            r.first = unique_vertex.first;
+            r.vid   = 0;
+
+            remap.push_back(r);
+        }
+    }
+
+    soup.vertices.clear();
+
+    stxxl::sort(unique_vertices.begin(), unique_vertices.end(), MeshUniqueVertexByFirst(), MESH_SORT_MEMORY);
+
+    // no coincident vertices: ids are unchanged and the corners are already in triangle order
+    if (unique_vertices.size() == n_input_vertices)
+        return;
+
+    std::cout << " --- --- Merged " << n_input_vertices - unique_vertices.size() << " coincident vertices" << std::endl;
+
+    // unique vertex ids: join with the unique vertices, both sorted by first appearance
+    stxxl::sort(remap.begin(), remap.end(), MeshVertexRemapByFirst(), MESH_SORT_MEMORY);
+
+    stxxl::vector<MeshUniqueVertex>::const_iterator unique_vertex = unique_vertices.begin();
+    stxxl::uint64 vid = 0;
+
+    for (stxxl::vector<MeshVertexRemap>::iterator it = remap.begin(); it != remap.end(); ++it)
+    {
+        for (; unique_vertex->first < it->first; ++unique_vertex)
+            vid++;
+
+        it->vid = vid;
+    }
+
+    stxxl::sort(remap.begin(), remap.end(), MeshVertexRemapByIndex(), MESH_SORT_MEMORY);
+
+    // corners: sorted by input vertex, joined with the remap (one record per input vertex), sorted back by triangle
+    stxxl::sort(soup.corners.begin(), soup.corners.end(), MeshInputCornerByIndex(), MESH_SORT_MEMORY);
+
+    stxxl::vector<MeshVertexRemap>::const_iterator r = remap.begin();
+    stxxl::uint64 index = 0;
+
+    for (stxxl::vector<MeshInputCorner>::iterator it = soup.corners.begin(); it != soup.corners.end(); ++it)
+    {
+        r += it->index - index;
+        index = it->index;
+
+        it->index = r->vid;
+    }
+
+    remap.clear();
+
+    stxxl::sort(soup.corners.begin(), soup.corners.end(), MeshInputCornerByTriangle(), MESH_SORT_MEMORY);
+}
+
+inline
+void get_bounding_box_and_downsample_and_binary_mesh (const std::vector<std::string> & mesh_filenames,
+                                                      const std::string downsample_filename,
+                                                      const std::string binary_filename,
+                                                      const int percentage,
+                                                      stxxl::uint64 &mesh_n_vertices,
+                                                      stxxl::uint64 &mesh_n_triangles,
+                                                      int &mesh_sample_vertices,
+                                                      Vtx & bb_min,
+                                                      Vtx & bb_max,
+                                                      std::vector<stxxl::uint64> &infile2lastv,
+                                                      const double resolution,
+                                                      const ProgressCallback &progress)
+{
+    bb_min.x = bb_min.y = bb_min.z = DBL_MAX;
+    bb_max.x = bb_max.y = bb_max.z = -DBL_MAX;
+
+    infile2lastv.clear();
+
+    std::cout << "[OPENING] Sample file " << downsample_filename << std::endl;
+
+    FILE *sample_fp = fopen (downsample_filename.c_str(), "wb");
+
+    if (sample_fp == NULL)
+    {
+        std::cerr << "[ERROR] Opening file " << downsample_filename << std::endl;
+        exit(1);
+    }
+
+    std::cout << "[OPENING] Binary file " << binary_filename << std::endl;
+
+    std::ofstream binary_mesh (binary_filename.c_str(), std::ios::out | std::ios::binary);
+
+    if (!binary_mesh.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << binary_filename << std::endl;
+        exit(1);
+    }
+
+    mesh_n_vertices = 0;
+    mesh_n_triangles = 0;
+    mesh_sample_vertices = 0;
+
+    for (unsigned int file = 0; file < mesh_filenames.size(); file++)
+    {
+        std::string mesh_filename = mesh_filenames.at(file);
+
+        std::cout << std::endl;
+        std::cout << "---------------------------------------------" << std::endl;
+        std::cout << "[OPENING] Mesh file " << mesh_filename << std::endl;
+
+        MeshSoup soup;
+
+        if (!read_mesh(mesh_filename, soup, progress))
+        {
+            std::cerr << "[ERROR] Reading file " << mesh_filename << std::endl;
+            exit(1);
+        }
+
+        bb_min.x = std::min(bb_min.x, soup.bb_min.x); bb_max.x = std::max(bb_max.x, soup.bb_max.x);
+        bb_min.y = std::min(bb_min.y, soup.bb_min.y); bb_max.y = std::max(bb_max.y, soup.bb_max.y);
+        bb_min.z = std::min(bb_min.z, soup.bb_min.z); bb_max.z = std::max(bb_max.z, soup.bb_max.z);
+
+        stxxl::vector<MeshUniqueVertex> unique_vertices;
+
+        merge_vertices(soup, unique_vertices);
+
+        // triangles with global vertex ids; those collapsed by the merge are dropped
+        stxxl::vector<stxxl::uint64> triangles;
+
+        for (stxxl::vector<MeshInputCorner>::const_iterator it = soup.corners.begin(); it != soup.corners.end(); )
+        {
+            stxxl::uint64 v[3];
+
+            for (int k = 0; k < 3; k++, ++it)
+                v[k] = it->index;
+
+            if (v[0] == v[1] || v[1] == v[2] || v[0] == v[2])
+                continue;
+
+            for (int k = 0; k < 3; k++)
+                triangles.push_back(mesh_n_vertices + v[k]);
+        }
+
+        soup.corners.clear();
+
+        stxxl::uint64 n_v = unique_vertices.size();
+        stxxl::uint64 n_t = triangles.size() / 3;
+
+        if (n_t < soup.n_triangles)
+            std::cout << " --- --- Dropped " << soup.n_triangles - n_t << " degenerate triangles" << std::endl;
+
+        binary_mesh.write(reinterpret_cast<const char*>(&n_v), sizeof n_v);
+        binary_mesh.write(reinterpret_cast<const char*>(&n_t), sizeof n_t);
+
+        stxxl::uint64 start = percentage /2;
+        stxxl::uint64 sample_ptr = start;
+
+        int delta = -start + (rand() % percentage);
+
+        double coord_buffer[3];
+
+        PointEncoder encoder (resolution, false);
+
+        stxxl::uint64 i = 0;
+
+        for (stxxl::vector<MeshUniqueVertex>::const_iterator it = unique_vertices.begin(); it != unique_vertices.end(); ++it, i++)
+        {
+            coord_buffer[0] = it->x;
+            coord_buffer[1] = it->y;
+            coord_buffer[2] = it->z;
+
+            encoder.write(binary_mesh, i, coord_buffer[0], coord_buffer[1], coord_buffer[2]);
+
+            if (i == sample_ptr + delta)
+            {
+                fwrite((void *) coord_buffer, sizeof(double), 3, sample_fp);
+
+                sample_ptr+= percentage;
+                delta = -start + rand() % percentage;
+
+                mesh_sample_vertices++;
+            }
+        }
+
+        encoder.flush(binary_mesh);
+
+        for (stxxl::vector<stxxl::uint64>::const_iterator it = triangles.begin(); it != triangles.end(); ++it)
+            binary_mesh.write(reinterpret_cast<const char*>(&(*it)), sizeof(stxxl::uint64));
+
+        if (binary_mesh.fail())
+        {
+            std::cerr << "[ERROR] Writing file " << binary_filename << std::endl;
+            exit(1);
+        }
+
+        std::cout << " --- --- " << n_v << " vertices, " << n_t << " triangles" << std::endl;
+
+        mesh_n_vertices += n_v;
+        mesh_n_triangles += n_t;
+
+        infile2lastv.push_back(mesh_n_vertices-1);
+
+        std::cout << "---------------------------------------------" << std::endl;
+    }
+
+    fclose(sample_fp);
+
+    binary_mesh.close();
+}
+
+}
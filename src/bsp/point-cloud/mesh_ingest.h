@@ -0,0 +1,65 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+#ifndef MESH_INGEST_H
+#define MESH_INGEST_H
+
+#include "geometry_items.h"
+#include "tiling_progress.h"
+
+#include <string>
+#include <vector>
+
+namespace OOC3DTileLib {
+
+// Triangle mesh input formats: STL (binary and ASCII), PLY (ASCII and binary) and OFF. Polygons are triangulated as fans.
+bool is_mesh_file (const std::string &filename);
+
+// Ingest of triangle meshes. Per input file, coincident vertices are merged (out of core, by external sorts:
+// STL has no shared vertices at all) and degenerate triangles are dropped. The binary copy holds, per file,
+// the unique vertices, in order of first appearance, and the triangles as triples of global vertex ids.
+void get_bounding_box_and_downsample_and_binary_mesh (const std::vector<std::string> & mesh_filenames,
+                                                      const std::string downsample_filename,
+                                                      const std::string binary_filename,
+                                                      const int percentage,
+                                                      stxxl::uint64 &mesh_n_vertices,
+                                                      stxxl::uint64 &mesh_n_triangles,
+                                                      int &mesh_sample_vertices,
+                                                      Vtx & bb_min,
+                                                      Vtx & bb_max,
+                                                      std::vector<stxxl::uint64> &infile2lastv,
+                                                      const double resolution = 0,
+                                                      const ProgressCallback &progress = console_progress);
+
+}
+
+#ifndef OOC3DTileLib_STATIC
+#include "mesh_ingest.cpp"
+#endif
+
+#endif // MESH_INGEST_H
@@ -2,7 +2,11 @@
 
 #include <liblas/liblas.hpp>
 
+#include "point_stream.h"
+
+#include <algorithm>
 #include <cfloat>
+#include <memory>
 
 namespace OOC3DTileLib {
 
@@ -16,7 +20,10 @@ inline
                                                             int &mesh_sample_vertices,
                                                             Vtx & bb_min,
                                                             Vtx & bb_max,
-                                                            std::vector<stxxl::uint64> &infile2lastv)
+                                                            std::vector<stxxl::uint64> &infile2lastv,
+                                                            const double resolution,
+                                                            const uint8_t attribute_mask,
+                                                            const ProgressCallback &progress)
 {
 
     bb_min.x = bb_min.y = bb_min.z = DBL_MAX;
@@ -48,6 +55,9 @@ inline
 
     stxxl::uint64 managed_v = 0;
 
+    mesh_n_vertices = 0;
+    mesh_sample_vertices = 0;
+
     for (int file = 0; file < pc_filenames.size(); file++)
     {
         std::string pc_filename = pc_filenames.at(file);
@@ -57,7 +67,7 @@ inline
         std::cout << "[OPENING] Point Cloud file " << pc_filename << std::endl;
 
         std::ifstream pc_file;
-        pc_file.open(pc_filename);
+        pc_file.open(pc_filename, std::ios::in | std::ios::binary);
 
         if (!pc_file.is_open())
         {
@@ -65,17 +75,18 @@ inline
             exit(1);
         }
 
-        liblas::Reader reader (pc_file);
+        liblas::Reader reader = liblas::ReaderFactory().CreateWithStream(pc_file);
 
         liblas::Header header = reader.GetHeader();
 
-        bb_min.x = header.GetMinX();
-        bb_min.y = header.GetMinY();
-        bb_min.z = header.GetMinZ();
+        // union of the bounding boxes of the input files
+        bb_min.x = std::min(bb_min.x, header.GetMinX());
+        bb_min.y = std::min(bb_min.y, header.GetMinY());
+        bb_min.z = std::min(bb_min.z, header.GetMinZ());
 
-        bb_max.x = header.GetMaxX();
-        bb_max.y = header.GetMaxY();
-        bb_max.z = header.GetMaxZ();
+        bb_max.x = std::max(bb_max.x, header.GetMaxX());
+        bb_max.y = std::max(bb_max.y, header.GetMaxY());
+        bb_max.z = std::max(bb_max.z, header.GetMaxZ());
 
         stxxl::uint64 n_v = header.GetPointRecordsCount();
         stxxl::uint64 n_t = 0;
@@ -84,9 +95,8 @@ inline
         binary_mesh.write(reinterpret_cast<const char*>(&n_t), sizeof n_t);
 
         mesh_n_vertices += n_v;
-        mesh_sample_vertices = 0;
 
-        stxxl::uint64 perc = (stxxl::uint64)(n_v / 10);
+        ProgressReporter reporter (progress, "ingest", "Reading Vertices", n_v, file, pc_filenames.size());
 
         stxxl::uint64 start = percentage /2;
         stxxl::uint64 sample_ptr = start;
@@ -94,21 +104,18 @@ inline
         int delta = -start + (rand() % percentage);
 
         double coord_buffer[3];
+        PointAttributes attributes;
+
+        PointEncoder encoder (resolution, false, attribute_mask);
 
         for (stxxl::uint64 i = 0; i < n_v; i++)
         {
-            if ((i%perc) == 0)
-                std::cout << " --- --- Reading Vertices .. " << i << " \\ " << n_v << " ( " << (i / perc) * 10 << "% )" << std::endl;
-
-            if (i == n_v - 1)
-                std::cout << " --- --- Reading Vertices .. " << i + 1 << " \\ " << n_v << " -- COMPLETED" << std::endl;
+            reporter.update(i);
 
-
-            bool success = reader.ReadNextPoint();
-
-            if (!success)
+            if (!reader.ReadNextPoint())
             {
-                std::cerr << "EROOOOOOOOOOOOOOOOOOOOOOOOO" << std::endl;
+                std::cerr << "[ERROR] Reading point " << i << " of " << pc_filename << std::endl;
+                exit(1);
             }
 
             liblas::Point point = reader.GetPoint();
@@ -117,9 +124,10 @@ inline
             coord_buffer[1] = point.GetY();
             coord_buffer[2] = point.GetZ();
 
-            binary_mesh.write(reinterpret_cast<const char*>(&coord_buffer[0]), sizeof coord_buffer[0]);
-            binary_mesh.write(reinterpret_cast<const char*>(&coord_buffer[1]), sizeof coord_buffer[1]);
-            binary_mesh.write(reinterpret_cast<const char*>(&coord_buffer[2]), sizeof coord_buffer[2]);
+            if (attribute_mask != 0)
+                get_las_attributes(point, attributes);
+
+            encoder.write(binary_mesh, i, coord_buffer[0], coord_buffer[1], coord_buffer[2], &attributes);
 
             if (i == sample_ptr + delta)
             {
@@ -132,6 +140,10 @@ inline
             }
         }
 
+        reporter.complete();
+
+        encoder.flush(binary_mesh);
+
         managed_v += n_v;
         infile2lastv.push_back(managed_v-1);
         pc_file.close();
@@ -153,7 +165,10 @@ inline
                                                    stxxl::uint64 &mesh_n_vertices,
                                                    int &mesh_sample_vertices,
                                                    Vtx & bb_min,
-                                                   Vtx & bb_max)
+                                                   Vtx & bb_max,
+                                                   const double resolution,
+                                                   const uint8_t attribute_mask,
+                                                   const ProgressCallback &progress)
 {
     bb_min.x = bb_min.y = bb_min.z = DBL_MAX;
     bb_max.x = bb_max.y = bb_max.z = -DBL_MAX;
@@ -182,39 +197,32 @@ inline
 
     stxxl::uint64 managed_v = 0;
 
+    mesh_n_vertices = 0;
+    mesh_sample_vertices = 0;
+
     for (int file = 0; file < pc_filenames.size(); file++)
     {
         std::string pc_filename = pc_filenames.at(file);
 
         std::cout << "[OPENING] Point Cloud file " << pc_filename << std::endl;
 
-        std::ifstream fp;
-        fp.open(pc_filename.c_str());
+        XYZPointStream fp (attribute_mask);     // attribute columns, then ignored ones
 
-        if (!fp.is_open())
+        if (!fp.open(pc_filename))
         {
             std::cerr << "[ERROR] Opening file " << pc_filename << std::endl;
             exit(1);
         }
 
-        int n = 0;
-        stxxl::uint64 n_v = std::count(std::istreambuf_iterator<char>(fp),
-                                       std::istreambuf_iterator<char>(), '\n');
-
+        stxxl::uint64 n_v = fp.get_n_points();
         stxxl::uint64 n_t = 0;
 
-        fp.clear();
-        fp.seekg(0);
-
-
-
         binary_mesh.write(reinterpret_cast<const char*>(&n_v), sizeof n_v);
         binary_mesh.write(reinterpret_cast<const char*>(&n_t), sizeof n_t);
 
-        mesh_n_vertices = n_v;
-        mesh_sample_vertices = 0;
+        mesh_n_vertices += n_v;
 
-        stxxl::uint64 perc = (stxxl::uint64)(n_v / 10);
+        ProgressReporter reporter (progress, "ingest", "Reading Vertices", n_v, file, pc_filenames.size());
 
         stxxl::uint64 start = percentage /2;
         stxxl::uint64 sample_ptr = start;
@@ -222,20 +230,21 @@ inline
         int delta = -start + (rand() % percentage);
 
         double coord_buffer[3];
+        PointAttributes attributes;
+
+        PointEncoder encoder (resolution, false, attribute_mask);
 
         for (stxxl::uint64 i = 0; i < n_v; i++)
         {
-            if ((i%perc) == 0)
-                std::cout << " --- --- Reading Vertices .. " << i << " \\ " << n_v << " ( " << (i / perc) * 10 << "% )" << std::endl;
+            reporter.update(i);
 
-            if (i == n_v - 1)
-                std::cout << " --- --- Reading Vertices .. " << i + 1 << " \\ " << n_v << " -- COMPLETED" << std::endl;
-
-            fp >> coord_buffer[0] >> coord_buffer[1] >> coord_buffer[2];
+            if (!fp.read_point(coord_buffer[0], coord_buffer[1], coord_buffer[2], &attributes))
+            {
+                std::cerr << "[ERROR] Reading vertex " << i << " of " << pc_filename << std::endl;
+                exit(1);
+            }
 
-            binary_mesh.write(reinterpret_cast<const char*>(&coord_buffer[0]), sizeof coord_buffer[0]);
-            binary_mesh.write(reinterpret_cast<const char*>(&coord_buffer[1]), sizeof coord_buffer[1]);
-            binary_mesh.write(reinterpret_cast<const char*>(&coord_buffer[2]), sizeof coord_buffer[2]);
+            encoder.write(binary_mesh, i, coord_buffer[0], coord_buffer[1], coord_buffer[2], &attributes);
 
             // x
             if (coord_buffer[0] < bb_min.x)
@@ -269,9 +278,11 @@ inline
             }
         }
 
-        managed_v += n_v;
+        reporter.complete();
+
+        encoder.flush(binary_mesh);
 
-        fp.close();
+        managed_v += n_v;
     }
 
     fclose(sample_fp);
@@ -279,4 +290,135 @@ inline
     binary_mesh.close();
 }
 
+inline
+    void get_bounding_box_and_downsample (const std::vector<std::string> & pc_filenames,
+                                          const std::string downsample_filename,
+                                          const int percentage,
+                                          stxxl::uint64 &n_vertices,
+                                          int &n_sample_vertices,
+                                          Vtx & bb_min,
+                                          Vtx & bb_max,
+                                          std::vector<stxxl::uint64> &infile2lastv,
+                                          const ProgressCallback &progress)
+{
+    bb_min.x = bb_min.y = bb_min.z = DBL_MAX;
+    bb_max.x = bb_max.y = bb_max.z = -DBL_MAX;
+
+    infile2lastv.clear();
+
+    std::cout << "[OPENING] Sample file " << downsample_filename << std::endl;
+
+    FILE *sample_fp = fopen (downsample_filename.c_str(), "wb");
+
+    if (sample_fp == NULL)
+    {
+        std::cerr << "[ERROR] Opening file " << downsample_filename << std::endl;
+        exit(1);
+    }
+
+    n_vertices = 0;
+    n_sample_vertices = 0;
+
+    for (int file = 0; file < pc_filenames.size(); file++)
+    {
+        std::string pc_filename = pc_filenames.at(file);
+
+        std::cout << "[OPENING] Point Cloud file " << pc_filename << std::endl;
+
+        std::unique_ptr<PointStream> points (open_point_stream(pc_filename));
+
+        if (!points)
+        {
+            std::cerr << "[ERROR] Opening file " << pc_filename << std::endl;
+            exit(1);
+        }
+
+        stxxl::uint64 n_v = points->get_n_points();
+
+        Vtx file_bb_min, file_bb_max;
+
+        // with a header bounding box, only the sampled points are read
+        const bool read_all = !points->get_bounding_box(file_bb_min, file_bb_max);
+
+        if (read_all)
+        {
+            file_bb_min.x = file_bb_min.y = file_bb_min.z = DBL_MAX;
+            file_bb_max.x = file_bb_max.y = file_bb_max.z = -DBL_MAX;
+        }
+
+        // same sampling (and random sequence) as the single pass ingest
+        stxxl::uint64 start = percentage /2;
+        stxxl::uint64 sample_ptr = start;
+
+        int delta = -start + (rand() % percentage);
+
+        double coord_buffer[3];
+
+        ProgressReporter reporter (progress, "sample", read_all ? "Reading Vertices" : "Sampling Vertices", n_v, file, pc_filenames.size());
+
+        for (stxxl::uint64 i = 0; i < n_v; i++)
+        {
+            const stxxl::uint64 next_sample = sample_ptr + delta;
+
+            if (!read_all)
+            {
+                if (next_sample >= n_v)
+                    break;
+
+                if (!points->skip(next_sample - i))
+                {
+                    std::cerr << "[ERROR] Reading vertex " << next_sample << " of " << pc_filename << std::endl;
+                    exit(1);
+                }
+
+                i = next_sample;
+            }
+
+            reporter.update(i);
+
+            if (!points->read_point(coord_buffer[0], coord_buffer[1], coord_buffer[2]))
+            {
+                std::cerr << "[ERROR] Reading vertex " << i << " of " << pc_filename << std::endl;
+                exit(1);
+            }
+
+            if (read_all)
+            {
+                file_bb_min.x = std::min(file_bb_min.x, coord_buffer[0]);
+                file_bb_min.y = std::min(file_bb_min.y, coord_buffer[1]);
+                file_bb_min.z = std::min(file_bb_min.z, coord_buffer[2]);
+
+                file_bb_max.x = std::max(file_bb_max.x, coord_buffer[0]);
+                file_bb_max.y = std::max(file_bb_max.y, coord_buffer[1]);
+                file_bb_max.z = std::max(file_bb_max.z, coord_buffer[2]);
+            }
+
+            if (i == next_sample)
+            {
+                fwrite((void *) coord_buffer, sizeof(double), 3, sample_fp);
+
+                sample_ptr+= percentage;
+                delta = -start + rand() % percentage;
+
+                n_sample_vertices++;
+            }
+        }
+
+        reporter.complete();
+
+        bb_min.x = std::min(bb_min.x, file_bb_min.x);
+        bb_min.y = std::min(bb_min.y, file_bb_min.y);
+        bb_min.z = std::min(bb_min.z, file_bb_min.z);
+
+        bb_max.x = std::max(bb_max.x, file_bb_max.x);
+        bb_max.y = std::max(bb_max.y, file_bb_max.y);
+        bb_max.z = std::max(bb_max.z, file_bb_max.z);
+
+        n_vertices += n_v;
+        infile2lastv.push_back(n_vertices-1);
+    }
+
+    fclose(sample_fp);
+}
+
 }
@@ -2,6 +2,8 @@
 #define PC_BSP_H
 
 #include "geometry_items.h"
+#include "point_codec.h"
+#include "tiling_progress.h"
 
 #include <string>
 #include <vector>
@@ -16,7 +18,10 @@ void get_bounding_box_and_downsample_and_binary_LAS (const std::vector<std::stri
                                                      stxxl::uint64 &mesh_n_vertices,
                                                      int &mesh_sample_vertices,
                                                      Vtx & bb_min,
-                                                     Vtx & bb_max, std::vector<stxxl::uint64> &infile2lastv);
+                                                     Vtx & bb_max, std::vector<stxxl::uint64> &infile2lastv,
+                                                     const double resolution = 0,      // V_binary quantization (see point_codec.h)
+                                                     const uint8_t attribute_mask = 0,     // attributes copied to V_binary (see point_attributes.h)
+                                                     const ProgressCallback &progress = console_progress);
 
 void get_bounding_box_and_downsample_and_binary_XYZ (const std::vector<std::string> & mesh_filenames,
                                                     const std::string downsample_filename,
@@ -25,7 +30,22 @@ void get_bounding_box_and_downsample_and_binary_XYZ (const std::vector<std::stri
                                                     stxxl::uint64 &mesh_n_vertices,
                                                     int &mesh_sample_vertices,
                                                     Vtx & bb_min,
-                                                    Vtx & bb_max);
+                                                    Vtx & bb_max,
+                                                    const double resolution = 0,
+                                                    const uint8_t attribute_mask = 0,
+                                                    const ProgressCallback &progress = console_progress);
+
+// First pass of the two pass ingest: bounding box and sample only, no binary copy of the inputs.
+// LAS files take the bounding box from their headers and read just the sampled records.
+void get_bounding_box_and_downsample (const std::vector<std::string> & pc_filenames,
+                                      const std::string downsample_filename,
+                                      const int percentage,
+                                      stxxl::uint64 &n_vertices,
+                                      int &n_sample_vertices,
+                                      Vtx & bb_min,
+                                      Vtx & bb_max,
+                                      std::vector<stxxl::uint64> &infile2lastv,
+                                      const ProgressCallback &progress = console_progress);
 
 }
 
@@ -0,0 +1,794 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "pc_distributed.h"
+#include "binary_io.h"
+#include "pc_bsp.h"
+#include "pc_tiling.h"
+#include "tiling_stats.h"
+#include "write_las.h"
+#include "write_manifest.h"
+#include "write_ply.h"
+#include "write_xyz.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#ifndef _WIN32
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char **environ;
+#endif
+
+namespace OOC3DTileLib {
+
+namespace TilingAlgorithms {
+
+static const char     DISTRIBUTED_JOB_MAGIC[8] = {'B', 'S', 'P', 'D', 'J', 'O', 'B', ' '};
+static const uint32_t DISTRIBUTED_JOB_VERSION  = 1;
+
+static const int DISTRIBUTED_POLL_MS = 50;      // period of the checks for the files of the other processes
+
+static std::string job_filename (const std::string &out_directory) { return out_directory + "/distributed.job"; }
+static std::string job_index_filename (const std::string &out_directory) { return out_directory + "/distributed.index"; }
+
+static std::string report_filename (const std::string &out_directory, const unsigned int worker, const std::string &stage)
+{
+    return out_directory + "/worker_" + std::to_string(worker) + "." + stage;
+}
+
+static bool file_exists (const std::string &filename)
+{
+    return std::ifstream(filename.c_str()).good();
+}
+
+// the others see the file complete or not at all
+static bool commit_file (std::ofstream &os, const std::string &tmp_filename, const std::string &filename)
+{
+    os.close();
+
+    if (os.fail())
+    {
+        std::cerr << "[ERROR] Writing file " << tmp_filename << std::endl;
+        return false;
+    }
+
+    remove(filename.c_str());
+
+    if (rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        std::cerr << "[ERROR] Renaming " << tmp_filename << " to " << filename << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool save_distributed_job (const std::string &filename, const DistributedJob &job)
+{
+    const std::string tmp_filename = filename + ".tmp";
+
+    std::ofstream os (tmp_filename.c_str(), std::ios::out | std::ios::binary);
+
+    if (!os.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << tmp_filename << std::endl;
+        return false;
+    }
+
+    os.write(DISTRIBUTED_JOB_MAGIC, sizeof(DISTRIBUTED_JOB_MAGIC));
+    write_value(os, DISTRIBUTED_JOB_VERSION);
+
+    write_value(os, static_cast<int32_t>(job.stage));
+    write_value(os, static_cast<uint32_t>(job.n_workers));
+
+    write_value(os, static_cast<uint32_t>(job.input_filenames.size()));
+
+    for (unsigned int f = 0; f < job.input_filenames.size(); f++)
+        write_string(os, job.input_filenames.at(f));
+
+    write_string(os, job.out_ext);
+    write_value(os, job.resolution);
+    write_value(os, job.attribute_mask);
+
+    for (unsigned int w = 0; w <= job.n_workers; w++)
+        write_value(os, static_cast<uint32_t>(job.first_file.at(w)));
+
+    write_value(os, static_cast<uint32_t>(job.infile2lastv.size()));
+
+    for (unsigned int f = 0; f < job.infile2lastv.size(); f++)
+        write_value(os, static_cast<uint64_t>(job.infile2lastv.at(f)));
+
+    return commit_file(os, tmp_filename, filename);
+}
+
+bool load_distributed_job (const std::string &filename, DistributedJob &job)
+{
+    std::ifstream is (filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!is.is_open())
+        return false;
+
+    char magic[8];
+    uint32_t version = 0;
+
+    is.read(magic, sizeof(magic));
+
+    if (is.fail() || std::memcmp(magic, DISTRIBUTED_JOB_MAGIC, sizeof(magic)) != 0 ||
+        !read_value(is, version) || version != DISTRIBUTED_JOB_VERSION)
+    {
+        std::cerr << "[ERROR] " << filename << " is not a distributed tiling job (or has an unsupported version)" << std::endl;
+        return false;
+    }
+
+    int32_t stage = 0;
+    uint32_t n_workers = 0, n_files = 0, n_lastv = 0;
+
+    read_value(is, stage);
+    read_value(is, n_workers);
+    read_value(is, n_files);
+
+    job.input_filenames.resize(n_files);
+
+    for (unsigned int f = 0; f < n_files; f++)
+        read_string(is, job.input_filenames.at(f));
+
+    read_string(is, job.out_ext);
+    read_value(is, job.resolution);
+    read_value(is, job.attribute_mask);
+
+    job.first_file.resize(n_workers + 1);
+
+    for (unsigned int w = 0; w <= n_workers; w++)
+    {
+        uint32_t first = 0;
+        read_value(is, first);
+        job.first_file.at(w) = first;
+    }
+
+    read_value(is, n_lastv);
+
+    job.infile2lastv.resize(n_lastv);
+
+    for (unsigned int f = 0; f < n_lastv; f++)
+    {
+        uint64_t lastv = 0;
+        read_value(is, lastv);
+        job.infile2lastv.at(f) = lastv;
+    }
+
+    if (is.fail())
+        return false;
+
+    job.stage = stage;
+    job.n_workers = n_workers;
+
+    return true;
+}
+
+// Contiguous shares of about the same size (in bytes): vertex ids of a share follow those of the previous one
+static std::vector<unsigned int> split_input_files (const std::vector<std::string> &input_filenames, const unsigned int n_workers)
+{
+    std::vector<stxxl::uint64> sizes;
+    stxxl::uint64 total = 0;
+
+    for (unsigned int f = 0; f < input_filenames.size(); f++)
+    {
+        std::ifstream is (input_filenames.at(f).c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+
+        sizes.push_back(is.is_open() ? static_cast<stxxl::uint64>(is.tellg()) : 0);
+        total += sizes.back();
+    }
+
+    std::vector<unsigned int> first_file (1, 0);
+    stxxl::uint64 cumulated = 0;
+    unsigned int f = 0;
+
+    for (unsigned int w = 1; w < n_workers; w++)
+    {
+        const stxxl::uint64 target = total * w / n_workers;
+
+        while (f < input_filenames.size() && cumulated + sizes.at(f) / 2 <= target)
+            cumulated += sizes.at(f++);
+
+        first_file.push_back(f);
+    }
+
+    first_file.push_back(input_filenames.size());
+
+    return first_file;
+}
+
+static void write_tiles_as (const std::string &out_ext, BinarySpacePartition &bsp, const DistributedJob &job,
+                            const std::string out_directory, const std::vector<int> &leaves, const unsigned int n_threads)
+{
+    if (out_ext.compare("xyz") == 0)
+        write_bsp_XYZ(bsp, out_directory, leaves, n_threads);
+    else
+    if (out_ext.compare("ply") == 0)
+        write_bsp_PLY(bsp, out_directory, leaves, n_threads);
+    else
+        write_bsp_LAS(bsp, job.input_filenames, job.infile2lastv, out_directory, leaves, n_threads, out_ext.compare("laz") == 0);
+}
+
+///////////////////////////
+/// WORKER
+///////////////////////////
+
+// Remote workers are not children of the coordinator: a worker that fails (returning false or calling exit)
+// leaves a "failed" report, else the coordinator would wait for its reports forever.
+static std::string worker_failure_filename;
+
+static void report_worker_failure ()
+{
+    if (!worker_failure_filename.empty())
+        std::ofstream os (worker_failure_filename.c_str());
+}
+
+// false if the job is aborted
+static bool wait_for_stage (const std::string &out_directory, const int stage, DistributedJob &job)
+{
+    while (true)
+    {
+        if (load_distributed_job(job_filename(out_directory), job))
+        {
+            if (job.stage == JOB_ABORTED)
+                return false;
+
+            if (job.stage >= stage)
+                return true;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(DISTRIBUTED_POLL_MS));
+    }
+}
+
+bool run_tiling_worker (const std::string out_directory, const unsigned int worker, const unsigned int n_threads, const ProgressCallback &progress)
+{
+    DistributedJob job;
+
+    static bool failure_handler_registered = false;
+
+    if (!failure_handler_registered)
+        std::atexit(report_worker_failure);
+
+    failure_handler_registered = true;
+    worker_failure_filename = report_filename(out_directory, worker, "failed");
+
+    std::cout << "[WORKER " << worker << "] Waiting for the job in " << out_directory << std::endl;
+
+    if (!wait_for_stage(out_directory, JOB_SAMPLE, job))
+        return false;
+
+    if (worker >= job.n_workers)
+    {
+        std::cerr << "[ERROR] Worker " << worker << " of a job with " << job.n_workers << " workers" << std::endl;
+        return false;
+    }
+
+    const std::vector<std::string> share (job.input_filenames.begin() + job.first_file.at(worker),
+                                          job.input_filenames.begin() + job.first_file.at(worker + 1));
+
+    // Sample: bounding box, counts and sample of the share
+    {
+        const std::string downsample_filename = out_directory + "/V_downsample_w" + std::to_string(worker);
+
+        stxxl::uint64 n_vertices = 0;
+        int n_sample_vertices = 0;
+        Vtx bb_min, bb_max;
+        std::vector<stxxl::uint64> infile2lastv;
+
+        get_bounding_box_and_downsample(share, downsample_filename, 1000, n_vertices, n_sample_vertices, bb_min, bb_max, infile2lastv, progress);
+
+        const std::string filename = report_filename(out_directory, worker, "sample");
+        std::ofstream os ((filename + ".tmp").c_str(), std::ios::out | std::ios::binary);
+
+        write_value(os, static_cast<uint32_t>(infile2lastv.size()));
+
+        for (unsigned int f = 0; f < infile2lastv.size(); f++)
+            write_value(os, static_cast<uint64_t>(infile2lastv.at(f)));
+
+        write_value(os, static_cast<int32_t>(n_sample_vertices));
+        write_value(os, bb_min.x); write_value(os, bb_min.y); write_value(os, bb_min.z);
+        write_value(os, bb_max.x); write_value(os, bb_max.y); write_value(os, bb_max.z);
+
+        if (!commit_file(os, filename + ".tmp", filename))
+            return false;
+    }
+
+    // Fill: the share into per leaf fragments, with the ids of a single process fill
+    if (!wait_for_stage(out_directory, JOB_FILL, job))
+        return false;
+
+    {
+        BinarySpacePartition bsp;
+
+        if (!bsp.load_index(job_index_filename(out_directory)))
+            return false;
+
+        bsp.set_attribute_mask(job.attribute_mask);
+        bsp.set_progress(progress);
+        bsp.set_leaf_filenames(out_directory);
+
+        for (unsigned int l = 0; l < bsp.get_n_leaves(); l++)
+            bsp.get_leaf(l)->filename_inner_v += "_w" + std::to_string(worker);
+
+        const unsigned int first = job.first_file.at(worker);
+
+        bsp.fill_share(share, (first == 0) ? 0 : job.infile2lastv.at(first - 1) + 1);
+
+        const std::string filename = report_filename(out_directory, worker, "fill");
+        std::ofstream os ((filename + ".tmp").c_str(), std::ios::out | std::ios::binary);
+
+        write_value(os, static_cast<uint32_t>(bsp.get_n_leaves()));
+
+        for (unsigned int l = 0; l < bsp.get_n_leaves(); l++)
+        {
+            write_value(os, static_cast<uint64_t>(bsp.get_leaf(l)->n_inner_vertices));
+            write_statistics(os, bsp.get_leaf(l)->statistics);
+        }
+
+        if (!commit_file(os, filename + ".tmp", filename))
+            return false;
+    }
+
+    // Write: the tiles of the leaves of this worker, from their joined fragments
+    if (!wait_for_stage(out_directory, JOB_WRITE, job))
+        return false;
+
+    {
+        BinarySpacePartition bsp;
+
+        if (!bsp.load_index(job_index_filename(out_directory)))
+            return false;
+
+        bsp.set_attribute_mask(job.attribute_mask);
+        bsp.set_progress(progress);
+        bsp.set_leaf_filenames(out_directory);
+
+        std::vector<int> leaves;
+
+        for (unsigned int l = worker; l < bsp.get_n_leaves(); l += job.n_workers)
+        {
+            BspCell *cell = bsp.get_leaf(l);
+
+            std::ofstream os (cell->filename_inner_v.c_str(), std::ios::out | std::ios::binary);
+
+            // fragments by worker: ascending vertex ids, as a single process fill writes them
+            for (unsigned int w = 0; w < job.n_workers; w++)
+            {
+                const std::string fragment = cell->filename_inner_v + "_w" + std::to_string(w);
+
+                std::ifstream is (fragment.c_str(), std::ios::in | std::ios::binary);
+
+                if (!is.is_open())
+                {
+                    std::cerr << "[ERROR] Opening file " << fragment << std::endl;
+                    return false;
+                }
+
+                if (is.peek() != std::ifstream::traits_type::eof())
+                    os << is.rdbuf();
+
+                is.close();
+                remove(fragment.c_str());
+            }
+
+            os.close();
+
+            if (os.fail())
+            {
+                std::cerr << "[ERROR] Writing file " << cell->filename_inner_v << std::endl;
+                return false;
+            }
+
+            leaves.push_back(l);
+        }
+
+        write_tiles_as(job.out_ext, bsp, job, out_directory, leaves, n_threads);
+
+        const std::string filename = report_filename(out_directory, worker, "written");
+        std::ofstream os ((filename + ".tmp").c_str(), std::ios::out | std::ios::binary);
+
+        write_value(os, static_cast<uint32_t>(leaves.size()));
+
+        if (!commit_file(os, filename + ".tmp", filename))
+            return false;
+    }
+
+    worker_failure_filename.clear();
+
+    std::cout << "[WORKER " << worker << "] Completed." << std::endl;
+
+    return true;
+}
+
+///////////////////////////
+/// COORDINATOR
+///////////////////////////
+
+// pid of a local worker process (0 if it cannot be started)
+static long spawn_worker (const std::string &executable, const std::string &out_directory, const unsigned int worker, const unsigned int n_threads,
+                          const bool quiet)
+{
+#ifdef _WIN32
+    std::cerr << "[ERROR] Local workers are not supported on Windows: start them by hand (--remote-workers)" << std::endl;
+    return 0;
+#else
+    std::vector<std::string> args = { executable, "--worker", std::to_string(worker), "--out", out_directory,
+                                      "--threads", std::to_string(n_threads) };
+
+    if (quiet)
+        args.push_back("--quiet");
+
+    std::vector<char *> argv;
+
+    for (unsigned int a = 0; a < args.size(); a++)
+        argv.push_back(const_cast<char *>(args.at(a).c_str()));
+
+    argv.push_back(nullptr);
+
+    pid_t pid = 0;
+
+    // spawnp: an executable without a directory (e.g. argv[0] of a command found in the PATH) is searched in the PATH
+    if (posix_spawnp(&pid, executable.c_str(), nullptr, nullptr, argv.data(), environ) != 0)
+        return 0;
+
+    return pid;
+#endif
+}
+
+// Waits for the report of every worker. Fails as soon as a local worker exits without it.
+static bool wait_for_reports (const std::string &out_directory, const unsigned int n_workers, const std::string &stage,
+                              std::vector<long> &workers)
+{
+    while (true)
+    {
+        bool complete = true;
+
+        for (unsigned int w = 0; w < n_workers && complete; w++)
+            complete = file_exists(report_filename(out_directory, w, stage));
+
+        if (complete)
+            return true;
+
+        for (unsigned int w = 0; w < n_workers; w++)
+        {
+            if (file_exists(report_filename(out_directory, w, "failed")))
+            {
+                std::cerr << "[ERROR] Worker " << w << " failed (" << stage << ")" << std::endl;
+                return false;
+            }
+        }
+
+#ifndef _WIN32
+        for (unsigned int w = 0; w < workers.size(); w++)
+        {
+            int status = 0;
+
+            if (workers.at(w) <= 0 || waitpid(workers.at(w), &status, WNOHANG) != workers.at(w))
+                continue;
+
+            workers.at(w) = 0;
+
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !file_exists(report_filename(out_directory, w, stage)))
+            {
+                std::cerr << "[ERROR] Worker " << w << " failed (" << stage << ")" << std::endl;
+                return false;
+            }
+        }
+#endif
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(DISTRIBUTED_POLL_MS));
+    }
+}
+
+void create_pointcloud_tiling_distributed (const std::vector<std::string>   input_filenames,
+                                           const std::string                out_directory,
+                                           const std::string                out_ext,
+                                           const int                        max_vtx_per_tile,
+                                           const TilingOptions            & options,
+                                           std::vector<std::string>       & tile_filenames)
+{
+    const unsigned int n_workers = options.n_workers;
+
+    if (options.incremental || options.checkpoint || options.lod || !options.scratch_directories.empty())
+        std::cout << "[WARNING] Distributed tiling: incremental updates, checkpoints, LOD and scratch directories are not supported (ignored)." << std::endl;
+
+    TilingStats stats;
+    stats.set_input(input_filenames);
+
+    DistributedJob job;
+
+    job.stage           = JOB_SAMPLE;
+    job.n_workers       = n_workers;
+    job.input_filenames = input_filenames;
+    job.out_ext         = out_ext;
+    job.resolution      = options.resolution;
+    job.attribute_mask  = options.attributes ? get_attribute_mask(input_filenames, options.xyz_attributes) : 0;
+    job.first_file      = split_input_files(input_filenames, n_workers);
+
+    for (unsigned int w = 0; w < n_workers; w++)
+    {
+        remove(report_filename(out_directory, w, "sample").c_str());
+        remove(report_filename(out_directory, w, "fill").c_str());
+        remove(report_filename(out_directory, w, "written").c_str());
+        remove(report_filename(out_directory, w, "failed").c_str());
+    }
+
+    std::vector<long> workers;
+
+    auto abort = [&]()
+    {
+        job.stage = JOB_ABORTED;
+        save_distributed_job(job_filename(out_directory), job);
+        exit(1);
+    };
+
+    StageTimer sample (&stats, "sample");     // by the workers, then merged
+
+    if (!save_distributed_job(job_filename(out_directory), job))
+        exit(1);
+
+    std::cout << "[DISTRIBUTED] " << n_workers << " workers, " << input_filenames.size() << " input files" << std::endl;
+
+    if (options.spawn_workers)
+    {
+        for (unsigned int w = 0; w < n_workers; w++)
+        {
+            workers.push_back(spawn_worker(options.worker_executable, out_directory, w, options.n_threads, !options.progress));
+
+            if (workers.back() == 0)
+            {
+                std::cerr << "[ERROR] Starting worker " << w << ": " << options.worker_executable << std::endl;
+                abort();
+            }
+        }
+    }
+    else
+        std::cout << "[DISTRIBUTED] Start worker i (0 ... " << n_workers - 1 << ") on a node sharing " << out_directory
+                  << ": bsp --worker <i> --out " << out_directory << std::endl;
+
+    // Samples of the workers: bounding box, vertex ids by file and sample of create
+    if (!wait_for_reports(out_directory, n_workers, "sample", workers))
+        abort();
+
+    const std::string downsample_filename = out_directory + "/V_downsample";
+
+    std::ofstream downsample (downsample_filename.c_str(), std::ios::out | std::ios::binary);
+
+    Vtx bb_min = { DBL_MAX,  DBL_MAX,  DBL_MAX};
+    Vtx bb_max = {-DBL_MAX, -DBL_MAX, -DBL_MAX};
+
+    stxxl::uint64 n_vertices = 0;
+    int n_sample_vertices = 0;
+
+    job.infile2lastv.clear();
+
+    for (unsigned int w = 0; w < n_workers; w++)
+    {
+        std::ifstream is (report_filename(out_directory, w, "sample").c_str(), std::ios::in | std::ios::binary);
+
+        uint32_t n_files = 0;
+        int32_t n_sample = 0;
+        Vtx w_min, w_max;
+
+        read_value(is, n_files);
+
+        const stxxl::uint64 first_vertex = n_vertices;
+
+        for (unsigned int f = 0; f < n_files; f++)
+        {
+            uint64_t lastv = 0;
+            read_value(is, lastv);
+            job.infile2lastv.push_back(first_vertex + lastv);
+
+            n_vertices = first_vertex + lastv + 1;
+        }
+
+        read_value(is, n_sample);
+        read_value(is, w_min.x); read_value(is, w_min.y); read_value(is, w_min.z);
+        read_value(is, w_max.x); read_value(is, w_max.y); read_value(is, w_max.z);
+
+        if (is.fail() || n_files != job.first_file.at(w + 1) - job.first_file.at(w))
+        {
+            std::cerr << "[ERROR] Reading file " << report_filename(out_directory, w, "sample") << std::endl;
+            abort();
+        }
+
+        bb_min.x = std::min(bb_min.x, w_min.x); bb_min.y = std::min(bb_min.y, w_min.y); bb_min.z = std::min(bb_min.z, w_min.z);
+        bb_max.x = std::max(bb_max.x, w_max.x); bb_max.y = std::max(bb_max.y, w_max.y); bb_max.z = std::max(bb_max.z, w_max.z);
+
+        n_sample_vertices += n_sample;
+
+        const std::string w_downsample_filename = out_directory + "/V_downsample_w" + std::to_string(w);
+        std::ifstream w_downsample (w_downsample_filename.c_str(), std::ios::in | std::ios::binary);
+
+        if (w_downsample.peek() != std::ifstream::traits_type::eof())
+            downsample << w_downsample.rdbuf();
+
+        w_downsample.close();
+        remove(w_downsample_filename.c_str());
+    }
+
+    downsample.close();
+
+    sample.stage.points        = n_vertices;
+    sample.stage.bytes_read    = stats.input_bytes;
+    sample.stage.bytes_written = get_file_size(downsample_filename);
+    sample.stop();
+
+    stats.n_points = n_vertices;
+
+    std::cout << "[DISTRIBUTED] Sampled " << n_vertices << " vertices (" << n_sample_vertices << " samples)" << std::endl;
+
+    // Tree, from the merged sample (as create_pointcloud_tiling does)
+    BspCell root (bb_min, bb_max);
+    root.is_bsp_root = true;
+    root.n_inner_vertices = n_sample_vertices;
+    root.filename_inner_v = downsample_filename;
+
+    BinarySpacePartition bsp (root);
+    bsp.set_resolution(options.resolution);
+    bsp.set_attribute_mask(job.attribute_mask);
+    bsp.set_progress(options.progress);
+
+    StageTimer create (&stats, "create");
+    create.stage.points     = n_sample_vertices;
+    create.stage.bytes_read = get_file_size(downsample_filename);
+
+    bsp.create(max_vtx_per_tile / 1000, out_directory, options.n_threads);
+
+    create.stop();
+
+    if (!bsp.save_index(job_index_filename(out_directory)))
+        abort();
+
+    StageTimer fill (&stats, "fill");
+    fill.stage.points     = n_vertices;
+    fill.stage.bytes_read = stats.input_bytes;
+
+    job.stage = JOB_FILL;
+
+    if (!save_distributed_job(job_filename(out_directory), job))
+        abort();
+
+    // Leaf counts and statistics of the fragments
+    if (!wait_for_reports(out_directory, n_workers, "fill", workers))
+        abort();
+
+    for (unsigned int w = 0; w < n_workers; w++)
+    {
+        std::ifstream is (report_filename(out_directory, w, "fill").c_str(), std::ios::in | std::ios::binary);
+
+        uint32_t n_leaves = 0;
+        read_value(is, n_leaves);
+
+        if (n_leaves != bsp.get_n_leaves())
+        {
+            std::cerr << "[ERROR] Reading file " << report_filename(out_directory, w, "fill") << std::endl;
+            abort();
+        }
+
+        for (unsigned int l = 0; l < n_leaves; l++)
+        {
+            uint64_t n = 0;
+            PointStatistics statistics;
+
+            read_value(is, n);
+            read_statistics(is, statistics);
+
+            bsp.get_leaf(l)->n_inner_vertices += n;
+            bsp.get_leaf(l)->statistics.add(statistics);
+        }
+
+        if (is.fail())
+        {
+            std::cerr << "[ERROR] Reading file " << report_filename(out_directory, w, "fill") << std::endl;
+            abort();
+        }
+    }
+
+    if (!bsp.save_index(job_index_filename(out_directory)))
+        abort();
+
+    fill.stop();
+
+    StageTimer write (&stats, "write");
+    write.stage.points = n_vertices;
+
+    job.stage = JOB_WRITE;
+
+    if (!save_distributed_job(job_filename(out_directory), job))
+        abort();
+
+    if (!wait_for_reports(out_directory, n_workers, "written", workers))
+        abort();
+
+    write.stop();
+
+    StageTimer index (&stats, "index");
+
+    // Tiles as the workers named them
+    for (unsigned int leaf = 0; leaf < bsp.get_n_leaves(); leaf++)
+    {
+        BspCell *cell = bsp.get_leaf(leaf);
+
+        if (cell->n_inner_vertices > 0)
+        {
+            cell->filename_mesh         = out_directory + bsp.get_cell_name(leaf) + "." + out_ext;
+            cell->filename_local2global = out_directory + bsp.get_cell_name(leaf) + "_v_loc2glob";
+        }
+
+        tile_filenames.push_back(cell->filename_mesh);
+
+        stats.n_tiles += cell->n_inner_vertices > 0;
+    }
+
+    bsp.save_index(out_directory + "/bsp.index");
+
+    write_bsp_manifest(bsp, out_directory);
+
+    index.stage.bytes_written = get_file_size(out_directory + "/bsp.index") + get_file_size(out_directory + "/tiles.manifest");
+    index.stop();
+
+#ifndef _WIN32
+    for (unsigned int w = 0; w < workers.size(); w++)
+        if (workers.at(w) > 0)
+            waitpid(workers.at(w), nullptr, 0);
+#endif
+
+    for (unsigned int w = 0; w < n_workers; w++)
+    {
+        remove(report_filename(out_directory, w, "sample").c_str());
+        remove(report_filename(out_directory, w, "fill").c_str());
+        remove(report_filename(out_directory, w, "written").c_str());
+        remove(report_filename(out_directory, w, "failed").c_str());
+    }
+
+    remove(job_filename(out_directory).c_str());
+    remove(job_index_filename(out_directory).c_str());
+
+    if (!options.stats_filename.empty())
+        stats.save_json(options.stats_filename);
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - stats.start).count();
+
+    std::cout << "[DISTRIBUTED] Completed: " << bsp.get_n_leaves() << " leaves (" << elapsed << " s)" << std::endl;
+}
+
+}
+
+}
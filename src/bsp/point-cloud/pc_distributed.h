@@ -0,0 +1,101 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#ifndef PC_DISTRIBUTED_H
+#define PC_DISTRIBUTED_H
+
+#include "bsp.h"
+
+#include <string>
+#include <vector>
+
+namespace OOC3DTileLib {
+
+namespace TilingAlgorithms {
+
+struct TilingOptions;
+
+// Distributed point cloud tiling. A coordinator and n worker processes (local, or one per node) share the output
+// directory and talk through files there:
+//   - the coordinator splits the inputs in contiguous shares and publishes the job (distributed.job);
+//   - each worker samples its share (bounding box, counts, V_downsample_w<i>) and reports it (worker_<i>.sample);
+//   - the coordinator merges the samples, builds the tree and publishes it (distributed.index, the bsp index);
+//   - each worker classifies its share into per leaf fragments (V_cell_<id>_w<i>) and reports the leaf counts (worker_<i>.fill);
+//   - the coordinator merges the counts; each worker joins the fragments of its leaves and writes their tiles (worker_<i>.written).
+// Vertex ids, and so the tiles, are those of a single process tiling of the same inputs.
+
+enum DistributedStage
+{
+    JOB_ABORTED = -1,       // a worker failed: the others exit
+    JOB_SAMPLE  = 1,
+    JOB_FILL    = 2,
+    JOB_WRITE   = 3
+};
+
+struct DistributedJob
+{
+    int stage = JOB_SAMPLE;
+
+    unsigned int n_workers = 0;
+
+    std::vector<std::string> input_filenames;
+    std::string out_ext;
+    double resolution = 0;
+    uint8_t attribute_mask = 0;
+
+    std::vector<unsigned int>  first_file;      // share of worker i: files first_file[i] ... first_file[i+1] - 1
+    std::vector<stxxl::uint64> infile2lastv;    // id of the last vertex of each input file (once sampled)
+};
+
+bool save_distributed_job (const std::string &filename, const DistributedJob &job);     // atomic (write + rename)
+bool load_distributed_job (const std::string &filename, DistributedJob &job);
+
+// Coordinator: runs the whole tiling with options.n_workers workers, started as local processes
+// (options.worker_executable) unless options.spawn_workers is false.
+void create_pointcloud_tiling_distributed (const std::vector<std::string>   input_filenames,
+                                           const std::string                out_directory,
+                                           const std::string                out_ext,
+                                           const int                        max_vtx_per_tile,
+                                           const TilingOptions            & options,
+                                           std::vector<std::string>       & tile_filenames);
+
+// Worker i of the distributed tiling in out_directory: waits for the job, runs its share of every stage and returns.
+// False if the job was aborted or the worker failed: a failure (exit included) leaves worker_<i>.failed, which stops the coordinator.
+bool run_tiling_worker (const std::string out_directory, const unsigned int worker, const unsigned int n_threads = 1,
+                        const ProgressCallback &progress = console_progress);
+
+}
+
+}
+
+#ifndef OOC3DTileLib_STATIC
+#include "pc_distributed.cpp"
+#endif
+
+#endif // PC_DISTRIBUTED_H
@@ -0,0 +1,604 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "pc_incremental.h"
+#include "pc_bsp.h"
+#include "binary_io.h"
+#include "write_las.h"
+#include "write_manifest.h"
+#include "write_ply.h"
+#include "write_xyz.h"
+
+#include <liblas/liblas.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+
+namespace OOC3DTileLib {
+
+namespace TilingAlgorithms {
+
+// Sequential reader of the points of an existing tile, paired with their global ids (local to global file).
+class TilePointReader
+{
+private:
+
+    std::ifstream tile;
+    std::ifstream local2global;
+
+    liblas::Reader *las_reader = nullptr;
+
+    bool ply = false;               // binary PLY tile (see write_ply.h): native doubles after the header
+
+public:
+
+    TilePointReader (const BspCell &cell)
+    {
+        if (cell.filename_mesh.empty())
+            return;
+
+        local2global.open(cell.filename_local2global.c_str());
+        tile.open(cell.filename_mesh.c_str(), std::ios::in | std::ios::binary);
+
+        if (!tile.is_open() || !local2global.is_open())
+        {
+            std::cerr << "[ERROR] Opening tile " << cell.filename_mesh << " or " << cell.filename_local2global << std::endl;
+            exit(1);
+        }
+
+        const std::string ext = cell.filename_mesh.substr(cell.filename_mesh.find_last_of("."));
+
+        if (ext.compare(".las") == 0 || ext.compare(".laz") == 0)
+            las_reader = new liblas::Reader (liblas::ReaderFactory().CreateWithStream(tile));
+        else
+        if (ext.compare(".ply") == 0)
+        {
+            std::string line;
+
+            while (std::getline(tile, line) && line.compare("end_header") != 0);
+
+            ply = true;
+        }
+    }
+
+    ~TilePointReader ()
+    {
+        delete las_reader;
+    }
+
+    bool next (stxxl::uint64 &id, double &x, double &y, double &z)
+    {
+        if (!local2global.is_open() || !(local2global >> id))
+            return false;
+
+        if (las_reader != nullptr)
+        {
+            if (!las_reader->ReadNextPoint())
+                return false;
+
+            const liblas::Point &point = las_reader->GetPoint();
+
+            x = point.GetX();
+            y = point.GetY();
+            z = point.GetZ();
+
+            return true;
+        }
+
+        if (ply)
+            return read_value(tile, x) && read_value(tile, y) && read_value(tile, z);
+
+        return static_cast<bool>(tile >> x >> y >> z);
+    }
+};
+
+inline
+void save_pointcloud_tiling_state (const BinarySpacePartition     & bsp,
+                                   const std::vector<std::string> & input_filenames,
+                                   const std::string                out_directory,
+                                   const std::string                out_ext)
+{
+    std::cout << "[INCREMENTAL] Fingerprinting input files ..." << std::endl;
+
+    TilingState state;
+    state.out_ext = out_ext;
+
+    stxxl::uint64 first_id = 0;
+
+    for (unsigned int f = 0; f < input_filenames.size(); f++)
+    {
+        InputFileState file;
+
+        if (!get_file_fingerprint(input_filenames.at(f), file, true))
+            exit(1);
+
+        file.first_id = first_id;
+        file.n_points = bsp.get_file_n_vertices(f);
+        file.leaves   = bsp.get_file_leaves(f);
+
+        first_id += file.n_points;
+
+        state.files.push_back(file);
+    }
+
+    if (!save_tiling_state(out_directory + "/tiling.state", state))
+        exit(1);
+}
+
+inline
+bool update_pointcloud_tiling (const std::vector<std::string>   input_filenames,
+                               const std::string                out_directory,
+                               const std::string                out_ext,
+                               const int                        max_vtx_per_tile,
+                               std::vector<std::string>       & tile_filenames,
+                               const std::vector<std::string> & scratch_directories,
+                               const unsigned int               n_write_threads,
+                               const ProgressCallback         & progress)
+{
+    const std::string state_filename = out_directory + "/tiling.state";
+    const std::string index_filename = out_directory + "/bsp.index";
+
+    TilingState old_state;
+
+    if (!load_tiling_state(state_filename, old_state) || old_state.out_ext.compare(out_ext) != 0)
+        return false;
+
+    BinarySpacePartition bsp;
+
+    if (!bsp.load_index(index_filename))
+        return false;
+
+    bsp.set_progress(progress);
+
+    std::cout << std::endl << "[INCREMENTAL] Checking " << input_filenames.size() << " input files against " << state_filename << std::endl;
+
+    // Files keep their position (i.e. their id range) in the previous order; new files are appended.
+    std::vector<InputFileState> files;
+    std::vector<bool> changed;
+    std::vector<int> old2new (old_state.files.size(), -1);     // -1: removed (or changed)
+
+    std::map<std::string, int> input_position;
+
+    for (unsigned int f = 0; f < input_filenames.size(); f++)
+        input_position[input_filenames.at(f)] = f;
+
+    std::vector<bool> is_known (input_filenames.size(), false);
+
+    bool any_update = false;
+
+    for (unsigned int f = 0; f < old_state.files.size(); f++)
+    {
+        const InputFileState &old_file = old_state.files.at(f);
+
+        std::map<std::string, int>::const_iterator it = input_position.find(old_file.filename);
+
+        if (it == input_position.end())
+        {
+            std::cout << " --- [REMOVED] " << old_file.filename << std::endl;
+            any_update = true;
+            continue;
+        }
+
+        is_known.at(it->second) = true;
+
+        InputFileState file;
+
+        if (!get_file_fingerprint(old_file.filename, file, false))
+            exit(1);
+
+        bool is_changed = false;
+
+        if (file.size != old_file.size || file.mtime != old_file.mtime)
+        {
+            // touched: compare the content
+            get_file_fingerprint(old_file.filename, file, true);
+            is_changed = (file.size != old_file.size || file.hash != old_file.hash);
+        }
+        else file.hash = old_file.hash;
+
+        if (is_changed)
+        {
+            std::cout << " --- [CHANGED] " << old_file.filename << std::endl;
+            any_update = true;
+        }
+        else
+        {
+            file.n_points = old_file.n_points;
+            file.leaves   = old_file.leaves;
+            old2new.at(f) = files.size();
+        }
+
+        files.push_back(file);
+        changed.push_back(is_changed);
+    }
+
+    for (unsigned int f = 0; f < input_filenames.size(); f++)
+    {
+        if (is_known.at(f))
+            continue;
+
+        InputFileState file;
+
+        if (!get_file_fingerprint(input_filenames.at(f), file, true))
+            exit(1);
+
+        std::cout << " --- [NEW] " << file.filename << std::endl;
+
+        files.push_back(file);
+        changed.push_back(true);
+        any_update = true;
+    }
+
+    if (!any_update)
+    {
+        std::cout << "[INCREMENTAL] Tiling is up to date." << std::endl;
+
+        for (unsigned int leaf = 0; leaf < bsp.get_n_leaves(); leaf++)
+            tile_filenames.push_back(bsp.get_leaf(leaf)->filename_mesh);
+
+        return true;
+    }
+
+    // Leaves to be rewritten: those holding points of removed or changed files ...
+    std::vector<bool> affected (bsp.get_n_leaves(), false);
+
+    for (unsigned int f = 0; f < old_state.files.size(); f++)
+        if (old2new.at(f) < 0)
+            for (unsigned int l = 0; l < old_state.files.at(f).leaves.size(); l++)
+                affected.at(old_state.files.at(f).leaves.at(l)) = true;
+
+    // ... and those receiving points of new or changed files
+    std::vector<std::string> changed_filenames;
+    std::vector<int> changed_positions;
+
+    for (unsigned int f = 0; f < files.size(); f++)
+    {
+        if (changed.at(f))
+        {
+            changed_filenames.push_back(files.at(f).filename);
+            changed_positions.push_back(f);
+        }
+    }
+
+    std::vector<stxxl::uint64>   saved_n_vertices (bsp.get_n_leaves());
+    std::vector<PointStatistics> saved_statistics (bsp.get_n_leaves());
+
+    for (unsigned int leaf = 0; leaf < bsp.get_n_leaves(); leaf++)
+    {
+        saved_n_vertices.at(leaf) = bsp.get_leaf(leaf)->n_inner_vertices;
+        saved_statistics.at(leaf) = bsp.get_leaf(leaf)->statistics;
+
+        bsp.get_leaf(leaf)->n_inner_vertices = 0;
+        bsp.get_leaf(leaf)->statistics = PointStatistics();
+    }
+
+    bsp.set_scratch_directories(scratch_directories);
+    bsp.set_leaf_filenames(out_directory);
+
+    // the update does not fit the persisted tree: drop its intermediate files and the previous tiling, to be re-tiled from scratch
+    auto discard_tiling = [&](const std::string &reason) -> bool
+    {
+        std::cout << "[WARNING] " << reason << ": the previous tiling cannot be updated." << std::endl;
+
+        for (unsigned int leaf = 0; leaf < bsp.get_n_leaves(); leaf++)
+        {
+            const BspCell *cell = bsp.get_leaf(leaf);
+
+            remove(cell->filename_inner_v.c_str());
+
+            if (!cell->filename_mesh.empty())
+            {
+                remove(cell->filename_mesh.c_str());
+                remove(cell->filename_local2global.c_str());
+            }
+        }
+
+        remove(state_filename.c_str());
+        remove(index_filename.c_str());
+        remove((out_directory + "/tiles.manifest").c_str());
+
+        return false;
+    };
+
+    if (changed_filenames.size() > 0)
+    {
+        // classify the new points against the persisted tree, reading the changed files directly (local ids, remapped while merging)
+        bsp.fill(changed_filenames);
+
+        for (unsigned int k = 0; k < changed_positions.size(); k++)
+        {
+            InputFileState &file = files.at(changed_positions.at(k));
+
+            file.n_points = bsp.get_file_n_vertices(k);
+            file.leaves   = bsp.get_file_leaves(k);
+
+            for (unsigned int l = 0; l < file.leaves.size(); l++)
+                affected.at(file.leaves.at(l)) = true;
+        }
+
+        // points outside the root are not located (they end up in a border leaf): the tree would need to grow
+        const BspCell &root = bsp.get_root();
+
+        const double tolerance = bsp.get_resolution() / 2;     // quantized points of the previous extent
+        const double root_min[3] = { root.bbox_min.x - tolerance, root.bbox_min.y - tolerance, root.bbox_min.z - tolerance };
+        const double root_max[3] = { root.bbox_max.x + tolerance, root.bbox_max.y + tolerance, root.bbox_max.z + tolerance };
+
+        for (unsigned int leaf = 0; leaf < bsp.get_n_leaves(); leaf++)
+        {
+            const PointStatistics &statistics = bsp.get_leaf(leaf)->statistics;     // of the new points only
+
+            if (statistics.is_empty())
+                continue;
+
+            for (int i = 0; i < 3; i++)
+                if (statistics.min[i] < root_min[i] || statistics.max[i] > root_max[i])
+                    return discard_tiling("New points lie outside the bounding box of the previous tiling");
+        }
+    }
+
+    // New id ranges
+    stxxl::uint64 first_id = 0;
+
+    std::vector<stxxl::uint64> infile2lastv;
+    std::vector<std::string> new_filenames;
+
+    for (unsigned int f = 0; f < files.size(); f++)
+    {
+        files.at(f).first_id = first_id;
+        first_id += files.at(f).n_points;
+
+        infile2lastv.push_back(first_id - 1);
+        new_filenames.push_back(files.at(f).filename);
+    }
+
+    std::vector<stxxl::uint64> old_first_ids;
+
+    for (unsigned int f = 0; f < old_state.files.size(); f++)
+        old_first_ids.push_back(old_state.files.at(f).first_id);
+
+    // global id in the previous tiling --> global id in the updated one (false for points of removed or changed files)
+    auto remap_old_id = [&](const stxxl::uint64 old_id, stxxl::uint64 &new_id) -> bool
+    {
+        int f = std::upper_bound(old_first_ids.begin(), old_first_ids.end(), old_id) - old_first_ids.begin() - 1;
+
+        if (f < 0 || old2new.at(f) < 0)
+            return false;
+
+        new_id = old_id - old_state.files.at(f).first_id + files.at(old2new.at(f)).first_id;
+        return true;
+    };
+
+    std::vector<stxxl::uint64> changed_local_first;     // first local id (as filled) of each changed file
+
+    for (unsigned int k = 0, local = 0; k < changed_positions.size(); k++)
+    {
+        changed_local_first.push_back(local);
+        local += files.at(changed_positions.at(k)).n_points;
+    }
+
+    auto remap_local_id = [&](const stxxl::uint64 local_id) -> stxxl::uint64
+    {
+        int k = std::upper_bound(changed_local_first.begin(), changed_local_first.end(), local_id) - changed_local_first.begin() - 1;
+
+        return local_id - changed_local_first.at(k) + files.at(changed_positions.at(k)).first_id;
+    };
+
+    // Merge, for each affected leaf, the points kept from its tile with the new ones (both sorted by global id)
+    std::vector<int> leaves_to_write;
+
+    for (unsigned int leaf = 0; leaf < bsp.get_n_leaves(); leaf++)
+    {
+        BspCell *cell = bsp.get_leaf(leaf);
+
+        if (!affected.at(leaf))
+        {
+            remove(cell->filename_inner_v.c_str());
+
+            cell->n_inner_vertices = saved_n_vertices.at(leaf);
+            cell->statistics = saved_statistics.at(leaf);
+            continue;
+        }
+
+        std::string merged_filename = cell->filename_inner_v + "_merged";
+
+        std::ifstream new_points;
+        std::ofstream merged (merged_filename.c_str(), std::ios::out | std::ios::binary);
+
+        if (!merged.is_open())
+        {
+            std::cerr << "[ERROR] Opening file " << merged_filename << std::endl;
+            exit(1);
+        }
+
+        if (changed_filenames.size() > 0)
+            new_points.open(cell->filename_inner_v.c_str(), std::ios::in | std::ios::binary);
+
+        TilePointReader old_points (*cell);
+
+        PointDecoder new_points_decoder (bsp.get_resolution());
+        PointEncoder merged_encoder (bsp.get_resolution());
+
+        stxxl::uint64 old_id = 0, new_id = 0, id = 0;
+        double old_xyz[3], new_xyz[3];
+
+        auto next_old = [&]() -> bool
+        {
+            stxxl::uint64 tile_id;
+
+            while (old_points.next(tile_id, old_xyz[0], old_xyz[1], old_xyz[2]))
+                if (remap_old_id(tile_id, old_id))
+                    return true;
+
+            return false;
+        };
+
+        auto next_new = [&]() -> bool
+        {
+            stxxl::uint64 local_id;
+
+            if (!new_points.is_open() || !new_points_decoder.read(new_points, local_id, new_xyz[0], new_xyz[1], new_xyz[2]))
+                return false;
+
+            new_id = remap_local_id(local_id);
+            return true;
+        };
+
+        bool has_old = next_old();
+        bool has_new = next_new();
+
+        stxxl::uint64 n_merged = 0;
+
+        cell->statistics = PointStatistics();     // coordinates only: the update carries no attributes
+
+        while (has_old || has_new)
+        {
+            double *xyz;
+
+            if (has_old && (!has_new || old_id < new_id))
+            {
+                id = old_id;
+                xyz = old_xyz;
+            }
+            else
+            {
+                id = new_id;
+                xyz = new_xyz;
+            }
+
+            merged_encoder.write(merged, id, xyz[0], xyz[1], xyz[2]);
+            cell->statistics.add(xyz[0], xyz[1], xyz[2]);
+
+            n_merged++;
+
+            if (xyz == old_xyz)
+                has_old = next_old();
+            else
+                has_new = next_new();
+        }
+
+        merged_encoder.flush(merged);
+
+        new_points.close();
+        merged.close();
+
+        if (merged.fail())
+        {
+            std::cerr << "[ERROR] Writing file " << merged_filename << std::endl;
+            exit(1);
+        }
+
+        remove(cell->filename_inner_v.c_str());
+        rename(merged_filename.c_str(), cell->filename_inner_v.c_str());
+
+        cell->n_inner_vertices = n_merged;
+
+        leaves_to_write.push_back(leaf);
+    }
+
+    // leaves are not re-split
+    for (const int leaf : leaves_to_write)
+        if (bsp.get_leaf(leaf)->n_inner_vertices > (stxxl::uint64) max_vtx_per_tile)
+            return discard_tiling("Tile " + std::to_string(leaf) + " would exceed " + std::to_string(max_vtx_per_tile) + " points");
+
+    for (const int leaf : leaves_to_write)
+    {
+        BspCell *cell = bsp.get_leaf(leaf);
+
+        if (cell->n_inner_vertices > 0)
+            continue;
+
+        remove(cell->filename_mesh.c_str());
+        remove(cell->filename_local2global.c_str());
+
+        cell->filename_mesh = "";
+        cell->filename_local2global = "";
+    }
+
+    // Unaffected tiles keep their points, but ids shift if a preceding file changed its size
+    std::vector<bool> shifted (bsp.get_n_leaves(), false);
+
+    for (unsigned int f = 0; f < old_state.files.size(); f++)
+        if (old2new.at(f) >= 0 && files.at(old2new.at(f)).first_id != old_state.files.at(f).first_id)
+            for (unsigned int l = 0; l < old_state.files.at(f).leaves.size(); l++)
+                shifted.at(old_state.files.at(f).leaves.at(l)) = true;
+
+    for (unsigned int leaf = 0; leaf < bsp.get_n_leaves(); leaf++)
+    {
+        BspCell *cell = bsp.get_leaf(leaf);
+
+        if (affected.at(leaf) || !shifted.at(leaf) || cell->filename_local2global.empty())
+            continue;
+
+        std::string renumbered_filename = cell->filename_local2global + "_renumbered";
+
+        std::ifstream in (cell->filename_local2global.c_str());
+        std::ofstream out (renumbered_filename.c_str());
+
+        stxxl::uint64 id, remapped;
+
+        while (in >> id)
+        {
+            remap_old_id(id, remapped);
+            out << remapped << std::endl;
+        }
+
+        in.close();
+        out.close();
+
+        remove(cell->filename_local2global.c_str());
+        rename(renumbered_filename.c_str(), cell->filename_local2global.c_str());
+    }
+
+    std::cout << "[INCREMENTAL] Rewriting " << leaves_to_write.size() << " of " << bsp.get_n_leaves() << " tiles" << std::endl;
+
+    if (out_ext.compare("xyz") == 0)
+        write_bsp_XYZ(bsp, out_directory, leaves_to_write, n_write_threads);
+    else
+    if (out_ext.compare("ply") == 0)
+        write_bsp_PLY(bsp, out_directory, leaves_to_write, n_write_threads);
+    else
+        write_bsp_LAS(bsp, new_filenames, infile2lastv, out_directory, leaves_to_write, n_write_threads, out_ext.compare("laz") == 0);
+
+    TilingState state;
+    state.out_ext = out_ext;
+    state.files = files;
+
+    if (!save_tiling_state(state_filename, state) || !bsp.save_index(index_filename) || !write_bsp_manifest(bsp, out_directory))
+        exit(1);
+
+    for (unsigned int leaf = 0; leaf < bsp.get_n_leaves(); leaf++)
+        tile_filenames.push_back(bsp.get_leaf(leaf)->filename_mesh);
+
+    return true;
+}
+
+}
+
+}
@@ -0,0 +1,73 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+
+#ifndef PC_INCREMENTAL_H
+#define PC_INCREMENTAL_H
+
+#include "bsp.h"
+#include "tiling_state.h"
+
+#include <string>
+#include <vector>
+
+namespace OOC3DTileLib {
+
+namespace TilingAlgorithms {
+
+// Records fingerprints, id ranges and touched leaves of the inputs of a completed tiling (<out>/tiling.state).
+void save_pointcloud_tiling_state (const BinarySpacePartition         & bsp,
+                                   const std::vector<std::string>     & input_filenames,
+                                   const std::string                    out_directory,
+                                   const std::string                    out_ext);
+
+// Updates a previous tiling of out_directory (bsp.index + tiling.state) against the current inputs:
+// only new or changed files are ingested and classified against the persisted tree, and only
+// the tiles receiving (or losing) their points are rewritten.
+// Returns false, without touching the output, when there is no compatible previous tiling. The persisted tree is
+// neither grown nor re-split: if new points fall outside its bounding box, or a leaf would exceed max_vtx_per_tile,
+// the previous tiles are removed and false is returned, for the caller to re-tile from scratch.
+bool update_pointcloud_tiling (const std::vector<std::string>   input_filenames,
+                               const std::string                out_directory,
+                               const std::string                out_ext,
+                               const int                        max_vtx_per_tile,
+                               std::vector<std::string>       & tile_filenames,
+                               const std::vector<std::string> & scratch_directories = std::vector<std::string>(),
+                               const unsigned int               n_write_threads = 1,
+                               const ProgressCallback         & progress = console_progress);
+
+}
+
+}
+
+#ifndef OOC3DTileLib_STATIC
+#include "pc_incremental.cpp"
+#endif
+
+#endif // PC_INCREMENTAL_H
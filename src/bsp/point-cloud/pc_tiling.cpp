@@ -27,8 +27,16 @@
 *                                                                               *
 *********************************************************************************/
 #include "pc_tiling.h"
+#include "mesh_ingest.h"
 #include "pc_bsp.h"
+#include "pc_distributed.h"
+#include "pc_incremental.h"
+#include "tiling_checkpoint.h"
+#include "tiling_stats.h"
 #include "write_las.h"
+#include "write_manifest.h"
+#include "write_ply.h"
+#include "write_tileset.h"
 #include "write_xyz.h"
 
 
@@ -51,11 +59,39 @@ void create_pointcloud_tiling(const std::vector<std::string> input_filenames,
     create_pointcloud_tiling(input_filenames, out_directory, out_ext, max_vtx_per_tile, bufferzone_size, tile_filenames, bufferzone_filenames);
 }
 
+void create_pointcloud_tiling(const std::vector<std::string> input_filenames,
+                                const std::string              out_directory,
+                                const std::string              out_ext,
+                                const int                      max_vtx_per_tile,
+                                const TilingOptions          & options,
+                                std::vector<std::string>     & tile_filenames)
+{
+    int bufferzone_size = 0;
+
+    std::vector<std::vector<std::string>> bufferzone_filenames;
+
+    create_pointcloud_tiling(input_filenames, out_directory, out_ext, max_vtx_per_tile, bufferzone_size, options, tile_filenames, bufferzone_filenames);
+}
+
+void create_pointcloud_tiling (const std::vector<std::string> input_filenames,
+                                const std::string              out_directory,
+                                const std::string              out_ext,
+                                const int                      max_vtx_per_tile,
+                                const int                      bufferzone_size,
+                                std::vector<std::string>     & tile_filenames,
+                                std::vector<std::vector<std::string>>     & bufferzone_filenames)
+{
+    TilingOptions options;
+
+    create_pointcloud_tiling(input_filenames, out_directory, out_ext, max_vtx_per_tile, bufferzone_size, options, tile_filenames, bufferzone_filenames);
+}
+
 void create_pointcloud_tiling (const std::vector<std::string> input_filenames,
                                 const std::string              out_directory,
                                 const std::string              out_ext,
                                 const int                      max_vtx_per_tile,
                                 const int                      bufferzone_size,
+                                const TilingOptions          & options,
                                 std::vector<std::string>     & tile_filenames,
                                 std::vector<std::vector<std::string>>     & bufferzone_filenames)
 {
@@ -64,11 +100,94 @@ void create_pointcloud_tiling (const std::vector<std::string> input_filenames,
     exit(1);
 #else
 
+    const unsigned int n_write_threads = (options.n_write_threads > 0) ? options.n_write_threads : options.n_threads;
+
+    TilingStats stats;
+    stats.set_input(input_filenames);
+
+    auto save_stats = [&]()
+    {
+        if (!options.stats_filename.empty())
+            stats.save_json(options.stats_filename);
+    };
+
+    // triangle meshes: vertices and triangles are classified together (single pass, neither updated nor resumed incrementally)
+    const bool with_polys = is_mesh_file(input_filenames.at(0));
+
+    for (unsigned int f = 0; f < input_filenames.size(); f++)
+    {
+        if (is_mesh_file(input_filenames.at(f)) != with_polys)
+        {
+            std::cerr << "[ERROR] Triangle meshes and point clouds cannot be tiled together: " << input_filenames.at(f) << std::endl;
+            exit(1);
+        }
+    }
+
+#ifndef USE_LASZIP
+    for (unsigned int f = 0; f < input_filenames.size(); f++)
+    {
+        if (input_filenames.at(f).substr(input_filenames.at(f).find_last_of(".")).compare(".laz") == 0)
+        {
+            std::cerr << "[ERROR] LAZ input needs libLAS with LASzip (build with USE_LASZIP): " << input_filenames.at(f) << std::endl;
+            exit(1);
+        }
+    }
+#endif
+
+    // workers sample and classify their share of the inputs: point clouds only
+    if (options.n_workers > 0)
+    {
+        if (with_polys)
+        {
+            std::cerr << "[ERROR] Triangle meshes cannot be tiled by distributed workers" << std::endl;
+            exit(1);
+        }
+
+        create_pointcloud_tiling_distributed(input_filenames, out_directory, out_ext, max_vtx_per_tile, options, tile_filenames);
+        return;
+    }
+
+    if (with_polys && (options.incremental || options.two_pass))
+        std::cout << "[WARNING] Triangle meshes are tiled in a single pass, from scratch." << std::endl;
+
+    // incremental updates re-tile from the coordinates of the tiles: tilings to be updated carry no attributes
+    const uint8_t attribute_mask = (with_polys || options.incremental || !options.attributes) ? 0 : get_attribute_mask(input_filenames, options.xyz_attributes);
+
+    // LOD samples are filled with the leaves: incremental updates would leave them stale
+    if (options.lod && (with_polys || options.incremental))
+        std::cout << "[WARNING] The level of detail is written for point clouds, and not updated incrementally: no LOD." << std::endl;
+
+    const stxxl::uint64 lod_points = (!options.lod || with_polys || options.incremental) ? 0 :
+                                     (options.lod_points > 0) ? options.lod_points : std::max(1, max_vtx_per_tile / 4);
+
+    if (options.incremental && !with_polys)
+    {
+        StageTimer update (&stats, "update");
+
+        const bool updated = update_pointcloud_tiling(input_filenames, out_directory, out_ext, max_vtx_per_tile, tile_filenames, options.scratch_directories, n_write_threads, options.progress);
+
+        update.stop();
+
+        if (updated)
+        {
+            for (unsigned int t = 0; t < tile_filenames.size(); t++)
+                stats.n_tiles += !tile_filenames.at(t).empty();
+
+            save_stats();
+            return;
+        }
+
+        std::cout << "[INCREMENTAL] No previous tiling to update in " << out_directory << ": running the whole pipeline." << std::endl;
+    }
+
     Vtx bb_min;
     Vtx bb_max;
 
-    std::string downsample_filename = out_directory + "/V_downsample";
-    std::string binary_filename     = out_directory + "/V_binary";
+    // intermediate files go to the (first) scratch directory, if any
+    const std::string scratch_directory = options.scratch_directories.empty() ? out_directory : options.scratch_directories.at(0);
+
+    std::string downsample_filename = scratch_directory + "/V_downsample";
+    std::string binary_filename     = scratch_directory + "/V_binary";
 
     stxxl::uint64 n_vertices = 0, n_triangles = 0;
     int n_sample_vertices = 0 ;
@@ -80,19 +199,95 @@ void create_pointcloud_tiling (const std::vector<std::string> input_filenames,
 
     std::vector<stxxl::uint64> infile2lastv;
 
-    if (ext.compare(".xyz") == 0)
-        get_bounding_box_and_downsample_and_binary_XYZ(input_filenames, downsample_filename, binary_filename, percentage,
-                                                   n_vertices, n_sample_vertices,
-                                                   bb_min, bb_max);
-    else
-    if (ext.compare(".las") == 0)
-        get_bounding_box_and_downsample_and_binary_LAS(input_filenames, downsample_filename, binary_filename, percentage,
-                                                   n_vertices, n_sample_vertices,
-                                                   bb_min, bb_max, infile2lastv);
+    // Resume from the last consistent point of a previous (interrupted) run with the same arguments
+    std::string checkpoint_filename       = out_directory + "/tiling.checkpoint";
+    std::string checkpoint_index_filename = out_directory + "/tiling.checkpoint.index";
+
+    TilingCheckpoint checkpoint;
+
+    if (options.checkpoint && load_tiling_checkpoint(checkpoint_filename, checkpoint))
+    {
+        if (checkpoint.input_filenames != input_filenames || checkpoint.out_ext.compare(out_ext) != 0 ||
+            checkpoint.max_vtx_per_tile != max_vtx_per_tile || checkpoint.two_pass != options.two_pass ||
+            checkpoint.resolution != options.resolution || checkpoint.attribute_mask != attribute_mask ||
+            checkpoint.lod_points != lod_points ||
+            checkpoint.scratch_directories != options.scratch_directories)
+        {
+            std::cout << "[CHECKPOINT] " << checkpoint_filename << " belongs to a different run: starting over." << std::endl;
+            checkpoint = TilingCheckpoint();
+        }
+        else std::cout << "[CHECKPOINT] Resuming from stage " << checkpoint.stage << std::endl;
+    }
+
+    checkpoint.input_filenames  = input_filenames;
+    checkpoint.out_ext          = out_ext;
+    checkpoint.max_vtx_per_tile = max_vtx_per_tile;
+    checkpoint.two_pass         = options.two_pass;
+    checkpoint.resolution       = options.resolution;
+    checkpoint.attribute_mask   = attribute_mask;
+    checkpoint.lod_points       = lod_points;
+    checkpoint.scratch_directories = options.scratch_directories;
+
+    auto save_checkpoint = [&](const int stage)
+    {
+        checkpoint.stage = stage;
+
+        if (!save_tiling_checkpoint(checkpoint_filename, checkpoint))
+            exit(1);
+    };
+
+    if (checkpoint.stage >= STAGE_INGESTED)
+    {
+        n_vertices        = checkpoint.n_vertices;
+        n_sample_vertices = checkpoint.n_sample_vertices;
+        bb_min            = checkpoint.bb_min;
+        bb_max            = checkpoint.bb_max;
+        infile2lastv      = checkpoint.infile2lastv;
+    }
     else
     {
-        std::cerr << "Unsupported file format: " << ext << std::endl;
-        return;
+        StageTimer ingest (&stats, (options.two_pass && !with_polys) ? "sample" : "ingest");
+
+        if (with_polys)
+            get_bounding_box_and_downsample_and_binary_mesh(input_filenames, downsample_filename, binary_filename, percentage,
+                                                            n_vertices, n_triangles, n_sample_vertices,
+                                                            bb_min, bb_max, infile2lastv, options.resolution, options.progress);
+        else
+        if (options.two_pass)
+            get_bounding_box_and_downsample(input_filenames, downsample_filename, percentage,
+                                            n_vertices, n_sample_vertices,
+                                            bb_min, bb_max, infile2lastv, options.progress);
+        else
+        if (ext.compare(".xyz") == 0)
+            get_bounding_box_and_downsample_and_binary_XYZ(input_filenames, downsample_filename, binary_filename, percentage,
+                                                       n_vertices, n_sample_vertices,
+                                                       bb_min, bb_max, options.resolution, attribute_mask, options.progress);
+        else
+        if (is_las_file(input_filenames.at(0)))
+            get_bounding_box_and_downsample_and_binary_LAS(input_filenames, downsample_filename, binary_filename, percentage,
+                                                       n_vertices, n_sample_vertices,
+                                                       bb_min, bb_max, infile2lastv, options.resolution, attribute_mask, options.progress);
+        else
+        {
+            std::cerr << "Unsupported file format: " << ext << std::endl;
+            return;
+        }
+
+        ingest.stage.points        = n_vertices;
+        ingest.stage.bytes_read    = stats.input_bytes;     // at most: two pass LAS reads the headers and the sampled records
+        ingest.stage.bytes_written = get_file_size(downsample_filename) + get_file_size(binary_filename);
+        ingest.stop();
+
+        if (options.checkpoint)
+        {
+            checkpoint.n_vertices        = n_vertices;
+            checkpoint.n_sample_vertices = n_sample_vertices;
+            checkpoint.bb_min            = bb_min;
+            checkpoint.bb_max            = bb_max;
+            checkpoint.infile2lastv      = infile2lastv;
+
+            save_checkpoint(STAGE_INGESTED);
+        }
     }
 
     // Create BSP root by exploiting the vertex downsample
@@ -103,28 +298,184 @@ void create_pointcloud_tiling (const std::vector<std::string> input_filenames,
 
     // Create BSP starting from the root and exploiting the vertex downsample
     BinarySpacePartition bsp (root);
-    bsp.create(stop, out_directory);
+    bsp.set_resolution(options.resolution);
+    bsp.set_attribute_mask(attribute_mask);
+    bsp.set_scratch_directories(options.scratch_directories);
+    bsp.set_progress(options.progress);
+
+    if (checkpoint.stage >= STAGE_TREE_BUILT)
+    {
+        if (!bsp.load_index(checkpoint_index_filename))
+            exit(1);
+
+        bsp.set_leaf_filenames(out_directory);
+    }
+    else
+    {
+        StageTimer create (&stats, "create");
+        create.stage.points     = n_sample_vertices;
+        create.stage.bytes_read = get_file_size(downsample_filename);
+
+        bsp.create(stop, out_directory, options.n_threads);
+
+        create.stop();
+
+        if (options.checkpoint)
+        {
+            if (!bsp.save_index(checkpoint_index_filename))
+                exit(1);
+
+            save_checkpoint(STAGE_TREE_BUILT);
+        }
+    }
+
+    // about n_vertices / n_sample_vertices points behind each sample of create
+    if (lod_points > 0)
+        bsp.set_lod(lod_points, (n_sample_vertices > 0) ? (double) n_vertices / n_sample_vertices : 1, out_directory);
+
+    stats.n_points = n_vertices;
+
+    StageTimer fill ((!with_polys && checkpoint.stage >= STAGE_FILLED) ? nullptr : &stats, "fill");
 
     // Fill the BSP cells by reading the original input (both vertices and triangles)
-    bsp.fill(binary_filename, input_filenames.size(), false);
+    if (with_polys)
+    {
+        bsp.fill(binary_filename, input_filenames.size(), true);     // meshes are filled again after an interruption
+    }
+    else
+    if (checkpoint.stage >= STAGE_FILLED)
+    {
+        bsp.restore_fill(checkpoint.fill_progress);
+    }
+    else
+    if (options.checkpoint)
+    {
+        const FillProgress *resume = (checkpoint.stage == STAGE_FILLING) ? &checkpoint.fill_progress : nullptr;
+
+        auto on_checkpoint = [&](const FillProgress &progress)
+        {
+            checkpoint.fill_progress = progress;
+            save_checkpoint(STAGE_FILLING);
+        };
+
+        if (options.two_pass)
+            bsp.fill(input_filenames, resume, on_checkpoint, options.checkpoint_interval);
+        else
+            bsp.fill(binary_filename, input_filenames.size(), resume, on_checkpoint, options.checkpoint_interval);
+
+        FillProgress &progress = checkpoint.fill_progress;
+
+        progress = FillProgress();
+        progress.file = input_filenames.size();
+
+        for (unsigned int l = 0; l < bsp.get_n_cells(); l++)
+        {
+            progress.leaf_n_vertices.push_back(bsp.get_cell(l)->n_inner_vertices);
+            progress.leaf_statistics.push_back(bsp.get_cell(l)->statistics);
+        }
+
+        for (unsigned int f = 0; f < input_filenames.size(); f++)
+        {
+            progress.file_n_vertices.push_back(bsp.get_file_n_vertices(f));
+            progress.file_leaves.push_back(bsp.get_file_leaves(f));
+        }
+
+        save_checkpoint(STAGE_FILLED);
+    }
+    else
+    if (options.two_pass)
+        bsp.fill(input_filenames);
+    else bsp.fill(binary_filename, input_filenames.size(), false);
+
+    stats.file_manager = bsp.get_fill_counters();
+
+    fill.stage.points        = n_vertices;
+    fill.stage.bytes_read    = (options.two_pass && !with_polys) ? stats.input_bytes : get_file_size(binary_filename);
+    fill.stage.bytes_written = stats.file_manager.bytes_written;
+    fill.stop();
+
+    // Tiles (and LOD samples) written before the interruption: the writers remove the leaf files once the tile is complete
+    std::vector<int> leaves_to_write;
+
+    for (unsigned int leaf = 0; leaf < bsp.get_n_cells(); leaf++)
+    {
+        BspCell *cell = bsp.get_cell(leaf);
+
+        if (checkpoint.stage >= STAGE_FILLED && cell->n_inner_vertices > 0 && !std::ifstream(cell->filename_inner_v.c_str()).good())
+        {
+            cell->filename_mesh         = out_directory + bsp.get_cell_name(leaf) + "." + out_ext;
+            cell->filename_local2global = out_directory + bsp.get_cell_name(leaf) + "_v_loc2glob";
+            continue;
+        }
+
+        leaves_to_write.push_back(leaf);
+    }
+
+    StageTimer write (&stats, "write");
+
+    for (unsigned int l = 0; l < leaves_to_write.size(); l++)
+    {
+        write.stage.points     += bsp.get_cell(leaves_to_write.at(l))->n_inner_vertices;
+        write.stage.bytes_read += get_file_size(bsp.get_cell(leaves_to_write.at(l))->filename_inner_v);
+    }
 
     // Write the output according to selected output format
     if (out_ext.compare("xyz") == 0)
-        write_bsp_XYZ(bsp, out_directory);
+        write_bsp_XYZ(bsp, out_directory, leaves_to_write, n_write_threads);
     else
-        if (out_ext.compare("las") == 0)
-            write_bsp_LAS(bsp, input_filenames, infile2lastv, out_directory);
+        if (out_ext.compare("las") == 0 || out_ext.compare("laz") == 0)
+            write_bsp_LAS(bsp, input_filenames, infile2lastv, out_directory, leaves_to_write, n_write_threads, out_ext.compare("laz") == 0);
+    else
+        if (out_ext.compare("ply") == 0)
+            write_bsp_PLY(bsp, out_directory, leaves_to_write, n_write_threads);
     else
     {
         std::cerr << "Unsupported output file format: " << out_ext << std::endl;
         return;
     }
 
+    for (unsigned int l = 0; l < leaves_to_write.size(); l++)
+    {
+        write.stage.bytes_written += get_file_size(bsp.get_cell(leaves_to_write.at(l))->filename_mesh) +
+                                     get_file_size(bsp.get_cell(leaves_to_write.at(l))->filename_local2global);
+    }
+
+    write.stop();
+
     for (int leaf = 0; leaf < bsp.get_n_leaves(); leaf++)
     {
         tile_filenames.push_back(bsp.get_leaf(leaf)->filename_mesh);
+
+        stats.n_tiles += bsp.get_leaf(leaf)->n_inner_vertices > 0;
+    }
+
+    StageTimer index (&stats, "index");
+
+    // Persist the tree, so that new points can be classified against this tiling without rebuilding it
+    bsp.save_index(out_directory + "/bsp.index");
+
+    // and the tiles, so that they can be looked up by region without opening them
+    write_bsp_manifest(bsp, out_directory);
+
+    // and the hierarchy of the LOD samples down to the tiles, for streaming viewers
+    if (lod_points > 0)
+        write_bsp_tileset(bsp, out_directory);
+
+    if (options.incremental && !with_polys)
+        save_pointcloud_tiling_state(bsp, input_filenames, out_directory, out_ext);
+
+    index.stage.bytes_written = get_file_size(out_directory + "/bsp.index") + get_file_size(out_directory + "/tiles.manifest") +
+                                ((lod_points > 0) ? get_file_size(out_directory + "/tileset.json") : 0);
+    index.stop();
+
+    if (options.checkpoint)
+    {
+        remove(checkpoint_filename.c_str());
+        remove(checkpoint_index_filename.c_str());
     }
 
+    save_stats();
+
 #endif
 }
 
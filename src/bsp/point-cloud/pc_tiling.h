@@ -29,6 +29,9 @@
 #ifndef PC_TILING_H
 #define PC_TILING_H
 
+#include "tiling_progress.h"
+
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -36,17 +39,66 @@ namespace OOC3DTileLib {
 
 namespace TilingAlgorithms {
 
+struct TilingOptions
+{
+    unsigned int n_threads = 1;     // Threads used to build the BSP.
+
+    unsigned int n_write_threads = 0;   // Tiles written concurrently (0: n_threads).
+
+    bool incremental = false;       // Update a previous tiling of the output directory, re-tiling only what changed in the inputs.
+
+    bool two_pass = false;          // Sample the inputs first, then classify them straight from the input files (no V_binary copy).
+
+    std::vector<std::string> scratch_directories;     // Intermediate files (e.g. one directory per local disk). Empty: the out directory.
+
+    double resolution = 0;          // Quantization step of the intermediate point files (0: raw doubles, exact).
+
+    bool attributes = true;         // Carry the point attributes of the inputs (LAS fields, XYZ intensity and color) to the tiles.
+
+    uint8_t xyz_attributes = 0;     // Attribute columns of the XYZ inputs after the coordinates (see xyz_attribute_mask). 0: none, extra columns ignored.
+
+    bool lod = false;                       // Also write a LOD sample of every inner bsp cell and tileset.json (point clouds).
+    unsigned long long lod_points = 0;      // Points of each LOD sample (0: a quarter of the tile size).
+
+    bool checkpoint = false;                                // Save checkpoints in the output directory and resume from them.
+    unsigned long long checkpoint_interval = 100000000;     // Vertices classified between two fill checkpoints.
+
+    std::string stats_filename;     // Write the time, throughput and I/O of each stage here, as JSON (empty: none).
+
+    unsigned int n_workers = 0;         // Distributed tiling with this many worker processes (0: a single process).
+    bool spawn_workers = true;          // Start the workers as local processes, else wait for workers started by hand (e.g. one per node).
+    std::string worker_executable;      // Executable run by the local workers (with --worker <i>).
+
+    ProgressCallback progress = console_progress;   // Progress of ingest, fill and tile writing (stage, counts, throughput, ETA). Empty: quiet.
+};
+
 void create_pointcloud_tiling (const std::vector<std::string>   input_filenames,
                                 const std::string               out_directory,
                                 const std::string               out_ext,
                                 const int                       max_vtx_per_tile,
                                 std::vector<std::string>      & tile_filenames);
 
+void create_pointcloud_tiling (const std::vector<std::string>   input_filenames,
+                                const std::string               out_directory,
+                                const std::string               out_ext,
+                                const int                       max_vtx_per_tile,
+                                const TilingOptions           & options,
+                                std::vector<std::string>      & tile_filenames);
+
+void create_pointcloud_tiling (const std::vector<std::string>   input_filenames,
+                                const std::string               out_directory,
+                                const std::string               out_ext,
+                                const int                       max_vtx_per_tile,
+                                const int                       bufferzone_size,
+                                std::vector<std::string>      & tile_filenames,
+                                std::vector<std::vector<std::string> > &bufferzone_filenames);
+
 void create_pointcloud_tiling (const std::vector<std::string>   input_filenames,
                                 const std::string               out_directory,
                                 const std::string               out_ext,
                                 const int                       max_vtx_per_tile,
                                 const int                       bufferzone_size,
+                                const TilingOptions           & options,
                                 std::vector<std::string>      & tile_filenames,
                                 std::vector<std::vector<std::string> > &bufferzone_filenames);
 
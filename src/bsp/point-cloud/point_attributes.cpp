@@ -0,0 +1,129 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "point_attributes.h"
+
+#include <cstring>
+
+template <typename T>
+static inline void put_field (std::string &buffer, const T &value)
+{
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static inline void get_field (const char *&record, T &value)
+{
+    memcpy(&value, record, sizeof(T));
+    record += sizeof(T);
+}
+
+unsigned int attribute_record_size (const uint8_t mask)
+{
+    unsigned int size = 0;
+
+    if (mask & ATTRIBUTE_INTENSITY)      size += sizeof(uint16_t);
+    if (mask & ATTRIBUTE_RETURNS)        size += 2 * sizeof(uint8_t);
+    if (mask & ATTRIBUTE_CLASSIFICATION) size += sizeof(uint8_t);
+    if (mask & ATTRIBUTE_RGB)            size += 3 * sizeof(uint16_t);
+    if (mask & ATTRIBUTE_GPS_TIME)       size += sizeof(double);
+
+    return size;
+}
+
+void encode_attributes (std::string &buffer, const uint8_t mask, const PointAttributes &attributes)
+{
+    if (mask & ATTRIBUTE_INTENSITY)
+        put_field(buffer, attributes.intensity);
+
+    if (mask & ATTRIBUTE_RETURNS)
+    {
+        put_field(buffer, attributes.return_number);
+        put_field(buffer, attributes.number_of_returns);
+    }
+
+    if (mask & ATTRIBUTE_CLASSIFICATION)
+        put_field(buffer, attributes.classification);
+
+    if (mask & ATTRIBUTE_RGB)
+    {
+        put_field(buffer, attributes.red);
+        put_field(buffer, attributes.green);
+        put_field(buffer, attributes.blue);
+    }
+
+    if (mask & ATTRIBUTE_GPS_TIME)
+        put_field(buffer, attributes.gps_time);
+}
+
+void decode_attributes (const char *record, const uint8_t mask, PointAttributes &attributes)
+{
+    attributes = PointAttributes();
+
+    if (mask & ATTRIBUTE_INTENSITY)
+        get_field(record, attributes.intensity);
+
+    if (mask & ATTRIBUTE_RETURNS)
+    {
+        get_field(record, attributes.return_number);
+        get_field(record, attributes.number_of_returns);
+    }
+
+    if (mask & ATTRIBUTE_CLASSIFICATION)
+        get_field(record, attributes.classification);
+
+    if (mask & ATTRIBUTE_RGB)
+    {
+        get_field(record, attributes.red);
+        get_field(record, attributes.green);
+        get_field(record, attributes.blue);
+    }
+
+    if (mask & ATTRIBUTE_GPS_TIME)
+        get_field(record, attributes.gps_time);
+}
+
+bool xyz_attribute_mask (const std::string &columns, uint8_t &mask)
+{
+    if (columns.compare("xyz") == 0)
+        mask = 0;
+    else
+    if (columns.compare("xyzi") == 0)
+        mask = ATTRIBUTE_INTENSITY;
+    else
+    if (columns.compare("xyzrgb") == 0)
+        mask = ATTRIBUTE_RGB;
+    else
+    if (columns.compare("xyzirgb") == 0)
+        mask = ATTRIBUTE_INTENSITY | ATTRIBUTE_RGB;
+    else
+        return false;
+
+    return true;
+}
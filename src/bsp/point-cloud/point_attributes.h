@@ -0,0 +1,72 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#ifndef POINT_ATTRIBUTES_H
+#define POINT_ATTRIBUTES_H
+
+#include <cstdint>
+#include <string>
+
+// Per point attributes carried with the coordinates from the ingest to the tiles (LAS fields, XYZ extra columns).
+// A mask tells which of them a tiling carries: the intermediate files store just those, with a fixed size record
+// per point (see point_codec.h). Mask 0: coordinates only, as before.
+#define ATTRIBUTE_INTENSITY         0x01
+#define ATTRIBUTE_RETURNS           0x02        // return number and number of returns
+#define ATTRIBUTE_CLASSIFICATION    0x04
+#define ATTRIBUTE_RGB               0x08
+#define ATTRIBUTE_GPS_TIME          0x10
+
+struct PointAttributes
+{
+    uint16_t intensity         = 0;
+    uint8_t  return_number     = 0;
+    uint8_t  number_of_returns = 0;
+    uint8_t  classification    = 0;
+    uint16_t red = 0, green = 0, blue = 0;
+    double   gps_time          = 0;
+};
+
+// bytes of the record of a point
+unsigned int attribute_record_size (const uint8_t mask);
+
+// record of a point: the fields of the mask, in the order of their bits (native endianness)
+void encode_attributes (std::string &buffer, const uint8_t mask, const PointAttributes &attributes);
+void decode_attributes (const char *record, const uint8_t mask, PointAttributes &attributes);
+
+// ASCII point files: "x y z [intensity] [r g b]". The layout of the columns is given, never guessed:
+// "xyz", "xyzi", "xyzrgb" or "xyzirgb" (i: intensity, rgb: color). Returns false on an unknown layout.
+#define XYZ_ATTRIBUTES              (ATTRIBUTE_INTENSITY | ATTRIBUTE_RGB)
+
+bool xyz_attribute_mask (const std::string &columns, uint8_t &mask);
+
+#ifndef OOCTRITILELIB_STATIC
+#include "point_attributes.cpp"
+#endif
+
+#endif // POINT_ATTRIBUTES_H
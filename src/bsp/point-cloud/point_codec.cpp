@@ -0,0 +1,363 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+
+#include "point_codec.h"
+
+#include <cmath>
+#include <cstdint>
+
+static inline void put_varint (std::string &buffer, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+
+    buffer.push_back(static_cast<char>(value));
+}
+
+static inline bool get_varint (const std::string &buffer, size_t &pos, uint64_t &value)
+{
+    value = 0;
+
+    for (int shift = 0; shift < 64 && pos < buffer.size(); shift += 7)
+    {
+        const uint8_t byte = static_cast<uint8_t>(buffer[pos++]);
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+static inline bool get_varint (std::istream &is, uint64_t &value)
+{
+    value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        const int byte = is.get();
+
+        if (byte == std::char_traits<char>::eof())
+            return false;
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+static inline uint64_t zigzag (const long long value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+static inline long long unzigzag (const uint64_t value) { return static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1); }
+
+stxxl::uint64 PointEncoder::write (std::ostream &os, const stxxl::uint64 id, const double x, const double y, const double z,
+                                   const PointAttributes *attributes)
+{
+    const PointAttributes no_attributes;
+
+    if (attributes == nullptr)
+        attributes = &no_attributes;
+
+    if (resolution <= 0 && !with_ids)
+    {
+        os.write(reinterpret_cast<const char*>(&x), sizeof x);
+        os.write(reinterpret_cast<const char*>(&y), sizeof y);
+        os.write(reinterpret_cast<const char*>(&z), sizeof z);
+
+        if (attribute_mask == 0)
+            return 3 * sizeof(double);
+
+        record.clear();
+        encode_attributes(record, attribute_mask, *attributes);
+
+        os.write(record.data(), record.size());
+
+        return 3 * sizeof(double) + record.size();
+    }
+
+    if (resolution <= 0)
+    {
+        stxxl::uint64 n_bytes = 0;
+
+        // the run goes on only with the next id
+        if (n_block_points > 0 && id != run_first_id + n_block_points)
+            n_bytes = flush(os);
+
+        if (n_block_points == 0)
+            run_first_id = id;
+
+        const double coords[3] = { x, y, z };
+
+        block.append(reinterpret_cast<const char*>(coords), sizeof(coords));
+
+        if (attribute_mask != 0)
+            encode_attributes(block, attribute_mask, *attributes);
+
+        n_block_points++;
+
+        if (n_block_points == POINT_BLOCK_SIZE)
+            n_bytes += flush(os);
+
+        return n_bytes;
+    }
+
+    if (n_block_points == 0)
+    {
+        prev_id = 0;
+        prev_q[0] = prev_q[1] = prev_q[2] = 0;
+    }
+
+    const long long q[3] = { std::llround(x / resolution), std::llround(y / resolution), std::llround(z / resolution) };
+
+    if (with_ids)
+    {
+        put_varint(block, id - prev_id);
+        prev_id = id;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        put_varint(block, zigzag(q[i] - prev_q[i]));
+        prev_q[i] = q[i];
+    }
+
+    if (attribute_mask != 0)
+        encode_attributes(block, attribute_mask, *attributes);
+
+    n_block_points++;
+
+    if (n_block_points == POINT_BLOCK_SIZE)
+        return flush(os);
+
+    return 0;
+}
+
+stxxl::uint64 PointEncoder::flush (std::ostream &os)
+{
+    if (n_block_points == 0)
+        return 0;
+
+    if (resolution <= 0)
+    {
+        std::string header;
+
+        put_varint(header, run_first_id);
+        put_varint(header, n_block_points);
+
+        os.write(header.data(), header.size());
+        os.write(block.data(), block.size());
+
+        const stxxl::uint64 n_bytes = header.size() + block.size();
+
+        block.clear();
+        n_block_points = 0;
+
+        return n_bytes;
+    }
+
+    const uint32_t n_points = n_block_points;
+    const uint32_t n_bytes  = block.size();
+
+    os.write(reinterpret_cast<const char*>(&n_points), sizeof n_points);
+    os.write(reinterpret_cast<const char*>(&n_bytes), sizeof n_bytes);
+    os.write(block.data(), block.size());
+
+    block.clear();
+    n_block_points = 0;
+
+    return sizeof(n_points) + sizeof(n_bytes) + n_bytes;
+}
+
+bool PointDecoder::read_block (std::istream &is)
+{
+    uint32_t n_points = 0, n_bytes = 0;
+
+    block_offset = is.tellg();
+
+    if (!is.read(reinterpret_cast<char *>(&n_points), sizeof(n_points)) ||
+        !is.read(reinterpret_cast<char *>(&n_bytes), sizeof(n_bytes)) || n_points == 0)
+        return false;
+
+    block.resize(n_bytes);
+
+    if (!is.read(&block[0], n_bytes))
+        return false;
+
+    n_block_points = n_points;
+    block_index = 0;
+    block_pos = 0;
+
+    prev_id = 0;
+    prev_q[0] = prev_q[1] = prev_q[2] = 0;
+
+    return true;
+}
+
+bool PointDecoder::read_run (std::istream &is)
+{
+    uint64_t first_id = 0, n_points = 0;
+
+    if (!get_varint(is, first_id) || !get_varint(is, n_points) || n_points == 0)
+        return false;
+
+    prev_id = first_id;
+    n_block_points = n_points;
+    block_index = 0;
+
+    return true;
+}
+
+bool PointDecoder::read (std::istream &is, stxxl::uint64 &id, double &x, double &y, double &z, PointAttributes *attributes)
+{
+    const unsigned int record_size = attribute_record_size(attribute_mask);
+
+    if (resolution <= 0 && with_ids)
+    {
+        if (block_index == n_block_points && !read_run(is))
+            return false;
+
+        id = prev_id + block_index;
+        block_index++;
+    }
+
+    if (resolution <= 0)
+    {
+        is.read(reinterpret_cast<char *>(&x), sizeof(x));
+        is.read(reinterpret_cast<char *>(&y), sizeof(y));
+        is.read(reinterpret_cast<char *>(&z), sizeof(z));
+
+        if (record_size > 0)
+        {
+            record.resize(record_size);
+            is.read(&record[0], record_size);
+
+            if (attributes != nullptr && !is.fail())
+                decode_attributes(record.data(), attribute_mask, *attributes);
+        }
+
+        return !is.fail();
+    }
+
+    if (block_index == n_block_points && !read_block(is))
+        return false;
+
+    uint64_t value;
+
+    if (with_ids)
+    {
+        if (!get_varint(block, block_pos, value))
+            return false;
+
+        id = prev_id + value;
+        prev_id = id;
+    }
+
+    double *coords[3] = { &x, &y, &z };
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (!get_varint(block, block_pos, value))
+            return false;
+
+        prev_q[i] += unzigzag(value);
+        *coords[i] = prev_q[i] * resolution;
+    }
+
+    if (record_size > 0)
+    {
+        if (block_pos + record_size > block.size())
+            return false;
+
+        if (attributes != nullptr)
+            decode_attributes(block.data() + block_pos, attribute_mask, *attributes);
+
+        block_pos += record_size;
+    }
+
+    block_index++;
+
+    return true;
+}
+
+stxxl::uint64 PointDecoder::tell (std::istream &is)
+{
+    if (resolution <= 0)
+        return is.tellg();
+
+    if (block_index < n_block_points)
+        return (block_offset << 16) | block_index;
+
+    return static_cast<stxxl::uint64>(is.tellg()) << 16;
+}
+
+bool PointDecoder::seek (std::istream &is, const stxxl::uint64 position)
+{
+    is.clear();
+
+    if (resolution <= 0)
+        return !is.seekg(position).fail();
+
+    n_block_points = block_index = 0;
+
+    if (is.seekg(position >> 16).fail())
+        return false;
+
+    const unsigned int index = position & 0xFFFF;
+
+    if (index == 0)
+        return true;
+
+    if (!read_block(is) || index > n_block_points)
+        return false;
+
+    stxxl::uint64 id;
+    double x, y, z;
+
+    for (unsigned int i = 0; i < index; i++)
+        if (!read(is, id, x, y, z))
+            return false;
+
+    return true;
+}
+
+double quantize_coordinate (const double v, const double resolution)
+{
+    if (resolution <= 0)
+        return v;
+
+    return std::llround(v / resolution) * resolution;
+}
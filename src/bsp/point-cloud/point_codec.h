@@ -0,0 +1,122 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+
+#ifndef POINT_CODEC_H
+#define POINT_CODEC_H
+
+#include "point_attributes.h"
+
+#include <stxxl.h>
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+// Encoding of the intermediate point files (V_binary and the leaf V_cell_* files).
+//
+// resolution == 0: raw double x, y, z. Without ids (V_binary) one record per point; with ids (leaf files) runs of
+//                  consecutive ids, [varint first_id][varint n_points][n_points * (x, y, z)]: ids are increasing
+//                  in a leaf, so a run replaces the 8 bytes id of each of its points.
+// resolution  > 0: blocks of at most POINT_BLOCK_SIZE points, [uint32 n_points][uint32 n_bytes][payload].
+//                  Coordinates are quantized to multiples of the resolution (a global grid, so re-encoding a
+//                  decoded point is exact) and, like the (increasing) ids, stored as varint deltas from the
+//                  previous point of the block. Each block is self-contained: files can be appended block-wise.
+//
+// With an attribute mask, the attribute record of each point (point_attributes.h) follows its coordinates.
+#define POINT_BLOCK_SIZE 4096
+
+class PointEncoder
+{
+    double  resolution;
+    bool    with_ids;
+    uint8_t attribute_mask;
+
+    std::string   block;            // payload of the pending block (or coordinates of the pending run)
+    unsigned int  n_block_points = 0;
+    stxxl::uint64 run_first_id = 0;
+    stxxl::uint64 prev_id = 0;
+    long long     prev_q[3] = {0, 0, 0};
+    std::string   record;           // attribute record of a raw point (without ids)
+
+public:
+
+    PointEncoder (const double resolution = 0, const bool with_ids = true, const uint8_t attribute_mask = 0)
+        : resolution(resolution), with_ids(with_ids), attribute_mask(attribute_mask) {}
+
+    // Returns the bytes written to os: raw records are written immediately, blocks once full.
+    // Without attributes, those of the mask are written as zero.
+    stxxl::uint64 write (std::ostream &os, const stxxl::uint64 id, const double x, const double y, const double z,
+                         const PointAttributes *attributes = nullptr);
+
+    stxxl::uint64 flush (std::ostream &os);     // writes the pending (partial) block or run, if any
+
+    bool has_pending () const { return n_block_points > 0; }
+};
+
+class PointDecoder
+{
+    double  resolution;
+    bool    with_ids;
+    uint8_t attribute_mask;
+
+    std::string   block;
+    size_t        block_pos = 0;
+    unsigned int  n_block_points = 0;
+    unsigned int  block_index = 0;      // next point of the block
+    stxxl::uint64 block_offset = 0;     // position of the block in the stream
+    stxxl::uint64 prev_id = 0;
+    long long     prev_q[3] = {0, 0, 0};
+    std::string   record;
+
+    bool read_block (std::istream &is);
+    bool read_run   (std::istream &is);
+
+public:
+
+    PointDecoder (const double resolution = 0, const bool with_ids = true, const uint8_t attribute_mask = 0)
+        : resolution(resolution), with_ids(with_ids), attribute_mask(attribute_mask) {}
+
+    // attributes: those of the mask (or none), if not null
+    bool read (std::istream &is, stxxl::uint64 &id, double &x, double &y, double &z, PointAttributes *attributes = nullptr);
+
+    // Position of the next point, restored by seek(): the byte offset of raw records, or the block offset
+    // (shifted left by 16 bits) plus the index of the point in its block. Not available for runs.
+    stxxl::uint64 tell (std::istream &is);
+    bool          seek (std::istream &is, const stxxl::uint64 position);
+};
+
+// A coordinate as stored in the intermediate files, i.e. as the decoder returns it (resolution 0: unchanged)
+double quantize_coordinate (const double v, const double resolution);
+
+#ifndef OOCTRITILELIB_STATIC
+#include "point_codec.cpp"
+#endif
+
+#endif // POINT_CODEC_H
@@ -0,0 +1,330 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+
+#include "point_stream.h"
+
+#include <liblas/liblas.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <memory>
+
+bool PointStream::skip (const stxxl::uint64 n_points)
+{
+    double x, y, z;
+
+    for (stxxl::uint64 i = 0; i < n_points; i++)
+        if (!read_point(x, y, z))
+            return false;
+
+    return true;
+}
+
+bool BinaryPointStream::read_point (double &x, double &y, double &z, PointAttributes *attributes)
+{
+    stxxl::uint64 id;
+
+    return decoder.read(is, id, x, y, z, attributes);
+}
+
+static bool is_blank (const std::string &line)
+{
+    return line.find_first_not_of(" \t\r") == std::string::npos;
+}
+
+bool XYZPointStream::open (const std::string &filename)
+{
+    // binary mode: tellg() and seekg() are byte offsets on every platform
+    fp.open(filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!fp.is_open())
+        return false;
+
+    // points: the non blank lines (the last one may have no newline)
+    n_points = 0;
+    bool blank = true;
+
+    for (std::istreambuf_iterator<char> c (fp), end; c != end; ++c)
+    {
+        if (*c == '\n')
+        {
+            if (!blank)
+                n_points++;
+
+            blank = true;
+        }
+        else
+        if (*c != ' ' && *c != '\t' && *c != '\r')
+            blank = false;
+    }
+
+    if (!blank)
+        n_points++;
+
+    fp.clear();
+    fp.seekg(0);
+
+    return true;
+}
+
+bool XYZPointStream::read_line ()
+{
+    while (std::getline(fp, line))
+        if (!is_blank(line))
+            return true;
+
+    return false;
+}
+
+// an attribute column: an integer in the range of the field, followed by a separator
+static bool read_column (const char *&ptr, uint16_t &value)
+{
+    char *end;
+
+    const unsigned long column = strtoul(ptr, &end, 10);
+
+    if (end == ptr || column > UINT16_MAX || (*end != '\0' && *end != ' ' && *end != '\t' && *end != '\r'))
+        return false;
+
+    value = static_cast<uint16_t>(column);
+    ptr = end;
+
+    return true;
+}
+
+bool XYZPointStream::read_point (double &x, double &y, double &z, PointAttributes *attributes)
+{
+    if (!read_line())
+        return false;
+
+    const char *ptr = line.c_str();
+    char *end;
+
+    x = strtod(ptr, &end); ptr = end;
+    y = strtod(ptr, &end); ptr = end;
+    z = strtod(ptr, &end);
+
+    if (end == ptr)
+        return false;
+
+    if (attributes != nullptr)
+    {
+        *attributes = PointAttributes();
+        ptr = end;
+
+        if ((attribute_mask & ATTRIBUTE_INTENSITY) && !read_column(ptr, attributes->intensity))
+            return false;
+
+        if ((attribute_mask & ATTRIBUTE_RGB) &&
+            (!read_column(ptr, attributes->red) || !read_column(ptr, attributes->green) || !read_column(ptr, attributes->blue)))
+            return false;
+    }
+
+    return true;
+}
+
+bool XYZPointStream::skip (const stxxl::uint64 n_points)
+{
+    for (stxxl::uint64 i = 0; i < n_points; i++)
+        if (!read_line())
+            return false;
+
+    return true;
+}
+
+bool XYZPointStream::seek (const stxxl::uint64 position)
+{
+    fp.clear();
+    return !fp.seekg(position).fail();
+}
+
+LASPointStream::~LASPointStream ()
+{
+    delete reader;
+}
+
+bool LASPointStream::open (const std::string &filename)
+{
+    fp.open(filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!fp.is_open())
+        return false;
+
+    // the factory picks the LAZ reader for compressed files (the Reader constructor reads LAS only)
+    reader = new liblas::Reader (liblas::ReaderFactory().CreateWithStream(fp));
+
+    n_points = reader->GetHeader().GetPointRecordsCount();
+    next = 0;
+
+    return true;
+}
+
+bool LASPointStream::get_bounding_box (Vtx &bb_min, Vtx &bb_max) const
+{
+    const liblas::Header &header = reader->GetHeader();
+
+    bb_min.x = header.GetMinX();
+    bb_min.y = header.GetMinY();
+    bb_min.z = header.GetMinZ();
+
+    bb_max.x = header.GetMaxX();
+    bb_max.y = header.GetMaxY();
+    bb_max.z = header.GetMaxZ();
+
+    return true;
+}
+
+uint8_t LASPointStream::get_attribute_mask () const
+{
+    return las_attribute_mask(reader->GetHeader());
+}
+
+bool LASPointStream::read_point (double &x, double &y, double &z, PointAttributes *attributes)
+{
+    if (next >= n_points || !reader->ReadNextPoint())
+        return false;
+
+    const liblas::Point &point = reader->GetPoint();
+
+    x = point.GetX();
+    y = point.GetY();
+    z = point.GetZ();
+
+    if (attributes != nullptr)
+        get_las_attributes(point, *attributes);
+
+    next++;
+
+    return true;
+}
+
+bool LASPointStream::seek (const stxxl::uint64 position)
+{
+    if (position > n_points)
+        return false;
+
+    if (position < n_points && !reader->Seek(position))
+        return false;
+
+    next = position;
+
+    return true;
+}
+
+bool is_las_file (const std::string &filename)
+{
+    const size_t ext_pos = filename.find_last_of(".");
+    const std::string ext = (ext_pos != std::string::npos) ? filename.substr(ext_pos) : "";
+
+    return ext.compare(".las") == 0 || ext.compare(".laz") == 0;
+}
+
+uint8_t get_attribute_mask (const std::vector<std::string> &filenames, const uint8_t xyz_attributes)
+{
+    uint8_t mask = 0;
+
+    for (const std::string &filename : filenames)
+    {
+        if (!is_las_file(filename))
+        {
+            mask |= xyz_attributes & XYZ_ATTRIBUTES;
+            continue;
+        }
+
+        std::unique_ptr<PointStream> points (open_point_stream(filename));
+
+        if (points)
+            mask |= points->get_attribute_mask();
+    }
+
+    return mask;
+}
+
+uint8_t las_attribute_mask (const liblas::Header &header)
+{
+    uint8_t mask = ATTRIBUTE_INTENSITY | ATTRIBUTE_RETURNS | ATTRIBUTE_CLASSIFICATION;
+
+    // point formats 1 and 3 (and 4, 5) have the GPS time, 2 and 3 (and 5) the color
+    const int format = static_cast<int>(header.GetDataFormatId());
+
+    if (format == 1 || format == 3 || format == 4 || format == 5)
+        mask |= ATTRIBUTE_GPS_TIME;
+
+    if (format == 2 || format == 3 || format == 5)
+        mask |= ATTRIBUTE_RGB;
+
+    return mask;
+}
+
+void get_las_attributes (const liblas::Point &point, PointAttributes &attributes)
+{
+    attributes.intensity         = point.GetIntensity();
+    attributes.return_number     = point.GetReturnNumber();
+    attributes.number_of_returns = point.GetNumberOfReturns();
+    attributes.classification    = point.GetClassification().GetClass();
+
+    const liblas::Color color = point.GetColor();
+
+    attributes.red   = color.GetRed();
+    attributes.green = color.GetGreen();
+    attributes.blue  = color.GetBlue();
+
+    attributes.gps_time = point.GetTime();
+}
+
+PointStream *open_point_stream (const std::string &filename, const uint8_t xyz_attributes)
+{
+    const size_t ext_pos = filename.find_last_of(".");
+    const std::string ext = (ext_pos != std::string::npos) ? filename.substr(ext_pos) : "";
+
+    if (ext.compare(".xyz") == 0)
+    {
+        XYZPointStream *stream = new XYZPointStream(xyz_attributes);
+
+        if (stream->open(filename))
+            return stream;
+
+        delete stream;
+    }
+    else
+    if (is_las_file(filename))
+    {
+        LASPointStream *stream = new LASPointStream();
+
+        if (stream->open(filename))
+            return stream;
+
+        delete stream;
+    }
+    else std::cerr << "Unsupported file format: " << ext << std::endl;
+
+    return nullptr;
+}
@@ -0,0 +1,161 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+
+#ifndef POINT_STREAM_H
+#define POINT_STREAM_H
+
+#include "geometry_items.h"
+#include "point_codec.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace liblas { class Reader; class Header; class Point; }
+
+// Sequential reader of the points of an input file (or of the binary copy of an input file).
+// tell() gives a position that seek() can restore: the fill resumes from it after a checkpoint.
+class PointStream
+{
+public:
+
+    virtual ~PointStream () {}
+
+    virtual stxxl::uint64 get_n_points () const = 0;
+
+    // bounding box stored in the file header, if any (LAS)
+    virtual bool get_bounding_box (Vtx &/*bb_min*/, Vtx &/*bb_max*/) const { return false; }
+
+    // attributes the file has (point_attributes.h)
+    virtual uint8_t get_attribute_mask () const { return 0; }
+
+    // attributes: those of the file (the others cleared), if not null
+    virtual bool read_point (double &x, double &y, double &z, PointAttributes *attributes = nullptr) = 0;
+
+    virtual bool skip (const stxxl::uint64 n_points);      // default: read and discard
+
+    virtual stxxl::uint64 tell () = 0;
+    virtual bool          seek (const stxxl::uint64 position) = 0;
+};
+
+// Points of one input file in the binary copy (V_binary), read from a stream shared by all the files.
+class BinaryPointStream : public PointStream
+{
+    std::istream &is;
+    stxxl::uint64 n_points;
+    PointDecoder  decoder;
+    uint8_t       attribute_mask;
+
+public:
+
+    BinaryPointStream (std::istream &is, const stxxl::uint64 n_points, const double resolution = 0, const uint8_t attribute_mask = 0)
+        : is(is), n_points(n_points), decoder(resolution, false, attribute_mask), attribute_mask(attribute_mask) {}
+
+    stxxl::uint64 get_n_points () const { return n_points; }
+    uint8_t       get_attribute_mask () const { return attribute_mask; }
+
+    bool read_point (double &x, double &y, double &z, PointAttributes *attributes = nullptr);
+
+    stxxl::uint64 tell () { return decoder.tell(is); }
+    bool          seek (const stxxl::uint64 position) { return decoder.seek(is, position); }
+};
+
+// ASCII file, one "x y z" point per line (blank lines are skipped). The attribute columns follow the coordinates
+// as given by the mask (see xyz_attribute_mask), further columns are ignored.
+class XYZPointStream : public PointStream
+{
+    std::ifstream fp;
+    stxxl::uint64 n_points = 0;
+    uint8_t       attribute_mask = 0;
+    std::string   line;
+
+    bool read_line ();      // next non blank line
+
+public:
+
+    explicit XYZPointStream (const uint8_t attribute_mask = 0) : attribute_mask(attribute_mask & XYZ_ATTRIBUTES) {}
+
+    bool open (const std::string &filename);
+
+    stxxl::uint64 get_n_points () const { return n_points; }
+    uint8_t       get_attribute_mask () const { return attribute_mask; }
+
+    bool read_point (double &x, double &y, double &z, PointAttributes *attributes = nullptr);
+    bool skip       (const stxxl::uint64 n_points);
+
+    stxxl::uint64 tell () { return fp.tellg(); }
+    bool          seek (const stxxl::uint64 position);
+};
+
+// LAS file: the position is the index of the next point record, so that skip() and seek() do not parse the records in between.
+class LASPointStream : public PointStream
+{
+    std::ifstream   fp;
+    liblas::Reader *reader = nullptr;
+    stxxl::uint64   n_points = 0;
+    stxxl::uint64   next = 0;
+
+public:
+
+    ~LASPointStream ();
+
+    bool open (const std::string &filename);
+
+    stxxl::uint64 get_n_points () const { return n_points; }
+    bool get_bounding_box (Vtx &bb_min, Vtx &bb_max) const;
+    uint8_t get_attribute_mask () const;
+
+    bool read_point (double &x, double &y, double &z, PointAttributes *attributes = nullptr);
+    bool skip       (const stxxl::uint64 n_points) { return seek(next + n_points); }
+
+    stxxl::uint64 tell () { return next; }
+    bool          seek (const stxxl::uint64 position);
+};
+
+// Opens an input file according to its extension (.xyz, .las, .laz). Returns nullptr on failure.
+// xyz_attributes: the attribute columns of XYZ files (LAS files tell theirs).
+PointStream *open_point_stream (const std::string &filename, const uint8_t xyz_attributes = 0);
+
+// .las or .laz (LAZ needs libLAS built with LASzip: USE_LASZIP)
+bool is_las_file (const std::string &filename);
+
+// Attributes of the input files (union of their masks), carried through the tiling. Only the LAS headers are read:
+// XYZ files have the attribute columns xyz_attributes.
+uint8_t get_attribute_mask (const std::vector<std::string> &filenames, const uint8_t xyz_attributes = 0);
+
+// LAS point records: attributes of a point format and of a point
+uint8_t las_attribute_mask  (const liblas::Header &header);
+void    get_las_attributes  (const liblas::Point &point, PointAttributes &attributes);
+
+#ifndef OOCTRITILELIB_STATIC
+#include "point_stream.cpp"
+#endif
+
+#endif // POINT_STREAM_H
@@ -0,0 +1,164 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "task_pool.h"
+
+namespace {
+
+// Pool and worker index of the calling thread (NULL for threads outside any pool).
+thread_local const TaskPool *current_pool = nullptr;
+thread_local unsigned int    current_worker = 0;
+
+}
+
+TaskPool::TaskPool (const unsigned int n_threads) : n_queued(0), n_pending(0), next_queue(0)
+{
+    unsigned int n = (n_threads > 0) ? n_threads : 1;
+
+    for (unsigned int i = 0; i < n; i++)
+        queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+
+    for (unsigned int i = 0; i < n; i++)
+        workers.push_back(std::thread(&TaskPool::worker_loop, this, i));
+}
+
+TaskPool::~TaskPool ()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock (state_mutex);
+        stopping = true;
+    }
+
+    work_available.notify_all();
+
+    for (unsigned int i = 0; i < workers.size(); i++)
+        workers.at(i).join();
+}
+
+unsigned int TaskPool::default_n_threads ()
+{
+    unsigned int n = std::thread::hardware_concurrency();
+
+    return (n > 0) ? n : 1;
+}
+
+void TaskPool::submit (std::function<void()> task)
+{
+    unsigned int queue = (current_pool == this) ? current_worker : (next_queue++ % queues.size());
+
+    n_pending++;
+
+    {
+        // publish under the state mutex, so that a worker going to sleep cannot miss it
+        std::lock_guard<std::mutex> state_lock (state_mutex);
+        std::lock_guard<std::mutex> queue_lock (queues.at(queue)->mutex);
+
+        queues.at(queue)->tasks.push_back(std::move(task));
+        n_queued++;
+    }
+
+    work_available.notify_one();
+}
+
+void TaskPool::wait ()
+{
+    std::unique_lock<std::mutex> lock (state_mutex);
+
+    all_done.wait(lock, [this]() { return n_pending == 0; });
+}
+
+bool TaskPool::pop_local (const unsigned int worker, std::function<void()> &task)
+{
+    WorkerQueue &queue = *queues.at(worker);
+
+    std::lock_guard<std::mutex> lock (queue.mutex);
+
+    if (queue.tasks.empty())
+        return false;
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+
+    return true;
+}
+
+bool TaskPool::steal (const unsigned int worker, std::function<void()> &task)
+{
+    for (unsigned int i = 1; i < queues.size(); i++)
+    {
+        WorkerQueue &queue = *queues.at((worker + i) % queues.size());
+
+        std::lock_guard<std::mutex> lock (queue.mutex);
+
+        if (queue.tasks.empty())
+            continue;
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+
+        return true;
+    }
+
+    return false;
+}
+
+void TaskPool::worker_loop (const unsigned int worker)
+{
+    current_pool = this;
+    current_worker = worker;
+
+    while (true)
+    {
+        std::function<void()> task;
+
+        if (pop_local(worker, task) || steal(worker, task))
+        {
+            n_queued--;
+
+            task();
+
+            if (--n_pending == 0)
+            {
+                std::lock_guard<std::mutex> lock (state_mutex);
+                all_done.notify_all();
+            }
+
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock (state_mutex);
+
+        work_available.wait(lock, [this]() { return stopping || n_queued > 0; });
+
+        if (stopping && n_queued <= 0)
+            return;
+    }
+}
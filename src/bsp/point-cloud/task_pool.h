@@ -0,0 +1,96 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads with one task deque per worker.
+// Tasks submitted by a worker are pushed on its own deque and popped in LIFO order
+// (depth-first, cache friendly); idle workers steal from the front of the other deques.
+class TaskPool
+{
+private:
+
+    struct WorkerQueue
+    {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::atomic<int> n_queued;      // Tasks waiting in some deque (may be transiently negative).
+    std::atomic<int> n_pending;     // Tasks submitted and not completed yet.
+    std::atomic<unsigned int> next_queue;   // Round robin for tasks submitted from outside the pool.
+
+    bool stopping = false;
+
+    std::mutex state_mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+
+    ///////////////////////////
+    /// METHODS
+    ///////////////////////////
+
+    bool pop_local (const unsigned int worker, std::function<void()> &task);
+    bool steal     (const unsigned int worker, std::function<void()> &task);
+
+    void worker_loop (const unsigned int worker);
+
+public:
+
+    TaskPool (const unsigned int n_threads);
+    ~TaskPool ();
+
+    unsigned int size () const { return workers.size(); }
+
+    void submit (std::function<void()> task);     // thread safe; may be called from inside a task
+
+    void wait ();                                  // blocks until every submitted task is completed (not from inside a task)
+
+    static unsigned int default_n_threads ();
+};
+
+#ifndef OOCTRITILELIB_STATIC
+#include "task_pool.cpp"
+#endif
+
+#endif // TASK_POOL_H
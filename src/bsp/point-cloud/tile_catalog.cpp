@@ -0,0 +1,334 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "tile_catalog.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+struct CatalogBox
+{
+    double min[3], max[3];
+
+    double center (const int axis) const { return (min[axis] + max[axis]) / 2; }
+};
+
+// Sort-Tile-Recursive order of the boxes: sqrt(n / NODE_SIZE) slices by x, each sorted by y
+static std::vector<uint32_t> str_order (const std::vector<CatalogBox> &boxes)
+{
+    std::vector<uint32_t> order (boxes.size());
+
+    for (uint32_t i = 0; i < order.size(); i++)
+        order.at(i) = i;
+
+    std::sort(order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) { return boxes.at(a).center(0) < boxes.at(b).center(0); });
+
+    const size_t n_nodes  = (boxes.size() + TILE_CATALOG_NODE_SIZE - 1) / TILE_CATALOG_NODE_SIZE;
+    const size_t n_slices = std::max<size_t>(1, std::ceil(std::sqrt(static_cast<double>(n_nodes))));
+    const size_t slice    = n_slices * TILE_CATALOG_NODE_SIZE;
+
+    for (size_t start = 0; start < order.size(); start += slice)
+        std::sort(order.begin() + start, order.begin() + std::min(order.size(), start + slice),
+                  [&](const uint32_t a, const uint32_t b) { return boxes.at(a).center(1) < boxes.at(b).center(1); });
+
+    return order;
+}
+
+void TileCatalog::build (const std::vector<TileEntry> &tiles, const std::string &directory)
+{
+    this->tiles = tiles;
+    this->directory = directory;
+
+    order.clear();
+    nodes.clear();
+    position_of_id.clear();
+
+    for (uint32_t t = 0; t < tiles.size(); t++)
+    {
+        const int32_t id = tiles.at(t).id;
+
+        if (id < 0)
+            continue;
+
+        if (id >= (int32_t) position_of_id.size())
+            position_of_id.resize(id + 1, -1);
+
+        position_of_id.at(id) = t;
+    }
+
+    if (tiles.empty())
+        return;
+
+    std::vector<CatalogBox> boxes (tiles.size());
+
+    for (uint32_t t = 0; t < tiles.size(); t++)
+        for (int i = 0; i < 3; i++)
+        {
+            boxes.at(t).min[i] = tiles.at(t).min[i];
+            boxes.at(t).max[i] = tiles.at(t).max[i];
+        }
+
+    order = str_order(boxes);
+
+    // leaf nodes: runs of NODE_SIZE tiles (in order); then, level by level, runs of NODE_SIZE nodes
+    std::vector<Node> level;
+
+    for (uint32_t start = 0; start < order.size(); start += TILE_CATALOG_NODE_SIZE)
+    {
+        Node node;
+
+        node.first = start;
+        node.count = std::min<uint32_t>(TILE_CATALOG_NODE_SIZE, order.size() - start);
+        node.is_leaf = true;
+
+        for (int i = 0; i < 3; i++)
+        {
+            node.min[i] =  DBL_MAX;
+            node.max[i] = -DBL_MAX;
+        }
+
+        for (uint32_t k = start; k < start + node.count; k++)
+            for (int i = 0; i < 3; i++)
+            {
+                node.min[i] = std::min(node.min[i], boxes.at(order.at(k)).min[i]);
+                node.max[i] = std::max(node.max[i], boxes.at(order.at(k)).max[i]);
+            }
+
+        level.push_back(node);
+    }
+
+    while (level.size() > 1)
+    {
+        std::vector<CatalogBox> level_boxes (level.size());
+
+        for (uint32_t n = 0; n < level.size(); n++)
+            for (int i = 0; i < 3; i++)
+            {
+                level_boxes.at(n).min[i] = level.at(n).min[i];
+                level_boxes.at(n).max[i] = level.at(n).max[i];
+            }
+
+        const std::vector<uint32_t> level_order = str_order(level_boxes);
+        const uint32_t first = nodes.size();
+
+        for (const uint32_t n : level_order)
+            nodes.push_back(level.at(n));
+
+        std::vector<Node> parents;
+
+        for (uint32_t start = 0; start < level_order.size(); start += TILE_CATALOG_NODE_SIZE)
+        {
+            Node node;
+
+            node.first = first + start;
+            node.count = std::min<uint32_t>(TILE_CATALOG_NODE_SIZE, level_order.size() - start);
+            node.is_leaf = false;
+
+            for (int i = 0; i < 3; i++)
+            {
+                node.min[i] =  DBL_MAX;
+                node.max[i] = -DBL_MAX;
+            }
+
+            for (uint32_t k = node.first; k < node.first + node.count; k++)
+                for (int i = 0; i < 3; i++)
+                {
+                    node.min[i] = std::min(node.min[i], nodes.at(k).min[i]);
+                    node.max[i] = std::max(node.max[i], nodes.at(k).max[i]);
+                }
+
+            parents.push_back(node);
+        }
+
+        level.swap(parents);
+    }
+
+    nodes.push_back(level.front());
+}
+
+bool TileCatalog::load (const std::string &manifest_filename)
+{
+    std::vector<TileEntry> manifest_tiles;
+
+    if (!load_tile_manifest(manifest_filename, manifest_tiles))
+        return false;
+
+    const size_t slash = manifest_filename.find_last_of("/\\");
+    const std::string manifest_directory = (slash != std::string::npos) ? manifest_filename.substr(0, slash + 1) : "";
+
+    build(manifest_tiles, manifest_directory);
+
+    return true;
+}
+
+const TileEntry *TileCatalog::find (const int32_t id) const
+{
+    if (id < 0 || id >= (int32_t) position_of_id.size() || position_of_id.at(id) < 0)
+        return nullptr;
+
+    return &tiles.at(position_of_id.at(id));
+}
+
+// Depth first visit of the nodes accepted by accept(min, max), calling visit(position) on their tiles
+template <typename Visit, typename Accept>
+void TileCatalog::search (const Accept &accept, const Visit &visit) const
+{
+    if (nodes.empty())
+        return;
+
+    std::vector<uint32_t> stack (1, nodes.size() - 1);
+
+    while (!stack.empty())
+    {
+        const Node &node = nodes.at(stack.back());
+        stack.pop_back();
+
+        if (!accept(node.min, node.max))
+            continue;
+
+        for (uint32_t k = node.first; k < node.first + node.count; k++)
+        {
+            if (!node.is_leaf)
+            {
+                stack.push_back(k);
+                continue;
+            }
+
+            const TileEntry &tile = tiles.at(order.at(k));
+
+            if (accept(tile.min, tile.max))
+                visit(order.at(k));
+        }
+    }
+}
+
+void TileCatalog::query_box (const double min[3], const double max[3], std::vector<uint32_t> &result) const
+{
+    search([&](const double *box_min, const double *box_max)
+           {
+               for (int i = 0; i < 3; i++)
+                   if (box_min[i] > max[i] || box_max[i] < min[i])
+                       return false;
+
+               return true;
+           },
+           [&](const uint32_t t) { result.push_back(t); });
+}
+
+static bool point_in_polygon (const double x, const double y, const std::vector<std::pair<double, double>> &polygon)
+{
+    bool inside = false;
+
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+    {
+        const double xi = polygon.at(i).first, yi = polygon.at(i).second;
+        const double xj = polygon.at(j).first, yj = polygon.at(j).second;
+
+        if ((yi > y) != (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi)
+            inside = !inside;
+    }
+
+    return inside;
+}
+
+// segment (x0, y0) - (x1, y1) clipped by the rectangle (Liang-Barsky): true if something is left
+static bool segment_intersects_rectangle (const double x0, const double y0, const double x1, const double y1,
+                                          const double *min, const double *max)
+{
+    const double dx = x1 - x0, dy = y1 - y0;
+
+    const double p[4] = { -dx, dx, -dy, dy };
+    const double q[4] = { x0 - min[0], max[0] - x0, y0 - min[1], max[1] - y0 };
+
+    double t0 = 0, t1 = 1;
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (p[i] == 0)
+        {
+            if (q[i] < 0)
+                return false;
+
+            continue;
+        }
+
+        const double t = q[i] / p[i];
+
+        if (p[i] < 0)
+            t0 = std::max(t0, t);
+        else t1 = std::min(t1, t);
+
+        if (t0 > t1)
+            return false;
+    }
+
+    return true;
+}
+
+static bool rectangle_intersects_polygon (const double *min, const double *max, const std::vector<std::pair<double, double>> &polygon)
+{
+    // an edge of the polygon crossing (or inside) the rectangle, or the rectangle inside the polygon
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        if (segment_intersects_rectangle(polygon.at(j).first, polygon.at(j).second, polygon.at(i).first, polygon.at(i).second, min, max))
+            return true;
+
+    return point_in_polygon(min[0], min[1], polygon);
+}
+
+void TileCatalog::query_polygon (const std::vector<std::pair<double, double>> &polygon, std::vector<uint32_t> &result) const
+{
+    if (polygon.empty())
+        return;
+
+    double polygon_min[2] = { DBL_MAX, DBL_MAX }, polygon_max[2] = { -DBL_MAX, -DBL_MAX };
+
+    for (const auto &vertex : polygon)
+    {
+        polygon_min[0] = std::min(polygon_min[0], vertex.first);
+        polygon_min[1] = std::min(polygon_min[1], vertex.second);
+        polygon_max[0] = std::max(polygon_max[0], vertex.first);
+        polygon_max[1] = std::max(polygon_max[1], vertex.second);
+    }
+
+    // nodes by the bounding box of the polygon, tiles by the polygon itself
+    search([&](const double *box_min, const double *box_max)
+           {
+               for (int i = 0; i < 2; i++)
+                   if (box_min[i] > polygon_max[i] || box_max[i] < polygon_min[i])
+                       return false;
+
+               return true;
+           },
+           [&](const uint32_t t)
+           {
+               if (rectangle_intersects_polygon(tiles.at(t).min, tiles.at(t).max, polygon))
+                   result.push_back(t);
+           });
+}
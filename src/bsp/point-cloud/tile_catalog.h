@@ -0,0 +1,86 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#ifndef TILE_CATALOG_H
+#define TILE_CATALOG_H
+
+#include "tile_manifest.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// In memory spatial index of the tiles of a manifest: a static R-tree, bulk loaded by Sort-Tile-Recursive
+// (x, then y), so that a query visits a few nodes and opens no tile. Queries return positions in get_tiles().
+#define TILE_CATALOG_NODE_SIZE 16
+
+class TileCatalog
+{
+    struct Node
+    {
+        double   min[3], max[3];
+        uint32_t first = 0;         // first child: a node or, for leaf nodes, a position in order
+        uint32_t count = 0;
+        bool     is_leaf = true;
+    };
+
+    std::vector<TileEntry> tiles;
+    std::string            directory;       // of the manifest: tile filenames are relative to it
+
+    std::vector<uint32_t>  order;           // tiles in R-tree order
+    std::vector<Node>      nodes;           // children of a node are contiguous, the root is the last one
+    std::vector<int32_t>   position_of_id;  // tile id --> position in tiles (-1 if none)
+
+    template <typename Visit, typename Accept>
+    void search (const Accept &accept, const Visit &visit) const;
+
+public:
+
+    bool load  (const std::string &manifest_filename);
+    void build (const std::vector<TileEntry> &tiles, const std::string &directory = "");
+
+    const std::vector<TileEntry> &get_tiles () const { return tiles; }
+
+    std::string get_path (const TileEntry &tile) const { return directory + tile.filename; }
+
+    const TileEntry *find (const int32_t id) const;     // by tile id (nullptr if none)
+
+    // tiles whose bounding box intersects the box
+    void query_box (const double min[3], const double max[3], std::vector<uint32_t> &result) const;
+
+    // tiles whose bounding box (in x, y) intersects the polygon (e.g. a building footprint), at any z
+    void query_polygon (const std::vector<std::pair<double, double>> &polygon, std::vector<uint32_t> &result) const;
+};
+
+#ifndef OOCTRITILELIB_STATIC
+#include "tile_catalog.cpp"
+#endif
+
+#endif // TILE_CATALOG_H
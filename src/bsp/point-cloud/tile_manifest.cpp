@@ -0,0 +1,137 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "tile_manifest.h"
+#include "binary_io.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char     TILE_MANIFEST_MAGIC[8] = {'B', 'S', 'P', 'T', 'I', 'L', 'E', 'S'};
+static const uint32_t TILE_MANIFEST_VERSION  = 1;
+
+bool save_tile_manifest (const std::string &filename, const std::vector<TileEntry> &tiles)
+{
+    std::ofstream os (filename.c_str(), std::ios::out | std::ios::binary);
+
+    if (!os.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << filename << std::endl;
+        return false;
+    }
+
+    os.write(TILE_MANIFEST_MAGIC, sizeof(TILE_MANIFEST_MAGIC));
+    write_value(os, TILE_MANIFEST_VERSION);
+
+    write_value(os, static_cast<uint32_t>(tiles.size()));
+
+    for (const TileEntry &tile : tiles)
+    {
+        write_value(os, tile.id);
+        write_value(os, tile.n_points);
+
+        for (int i = 0; i < 3; i++) write_value(os, tile.min[i]);
+        for (int i = 0; i < 3; i++) write_value(os, tile.max[i]);
+
+        write_string(os, tile.filename);
+
+        write_value(os, static_cast<uint32_t>(tile.neighbors.size()));
+
+        for (const int32_t neighbor : tile.neighbors)
+            write_value(os, neighbor);
+    }
+
+    os.close();
+
+    if (os.fail())
+    {
+        std::cerr << "[ERROR] Writing file " << filename << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool load_tile_manifest (const std::string &filename, std::vector<TileEntry> &tiles)
+{
+    std::ifstream is (filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!is.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << filename << std::endl;
+        return false;
+    }
+
+    char magic[8];
+    uint32_t version = 0, n_tiles = 0;
+
+    is.read(magic, sizeof(magic));
+
+    if (is.fail() || std::memcmp(magic, TILE_MANIFEST_MAGIC, sizeof(magic)) != 0 ||
+        !read_value(is, version) || version != TILE_MANIFEST_VERSION)
+    {
+        std::cerr << "[ERROR] " << filename << " is not a tile manifest (or has an unsupported version)" << std::endl;
+        return false;
+    }
+
+    read_value(is, n_tiles);
+
+    tiles.clear();
+    tiles.resize(n_tiles);
+
+    for (TileEntry &tile : tiles)
+    {
+        uint32_t n_neighbors = 0;
+
+        read_value(is, tile.id);
+        read_value(is, tile.n_points);
+
+        for (int i = 0; i < 3; i++) read_value(is, tile.min[i]);
+        for (int i = 0; i < 3; i++) read_value(is, tile.max[i]);
+
+        read_string(is, tile.filename);
+
+        if (!read_value(is, n_neighbors))
+            break;
+
+        tile.neighbors.resize(n_neighbors);
+
+        for (int32_t &neighbor : tile.neighbors)
+            read_value(is, neighbor);
+    }
+
+    if (is.fail())
+    {
+        std::cerr << "[ERROR] Reading file " << filename << std::endl;
+        return false;
+    }
+
+    return true;
+}
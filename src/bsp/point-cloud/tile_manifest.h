@@ -0,0 +1,59 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#ifndef TILE_MANIFEST_H
+#define TILE_MANIFEST_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary manifest of the tiles of a tiling (<out>/tiles.manifest): all a catalog needs to find the tiles of
+// a region without opening them. Only tiles with points are listed.
+struct TileEntry
+{
+    int32_t  id = 0;                    // position of the leaf in the bsp (cell_<id> files)
+    uint64_t n_points = 0;
+
+    double min[3] = {0, 0, 0};          // tight bounding box of the points of the tile
+    double max[3] = {0, 0, 0};
+
+    std::string filename;               // relative to the directory of the manifest
+
+    std::vector<int32_t> neighbors;     // tiles whose bsp cells touch this one (meshes: also sharing vertices)
+};
+
+bool save_tile_manifest (const std::string &filename, const std::vector<TileEntry> &tiles);
+bool load_tile_manifest (const std::string &filename, std::vector<TileEntry> &tiles);
+
+#ifndef OOCTRITILELIB_STATIC
+#include "tile_manifest.cpp"
+#endif
+
+#endif // TILE_MANIFEST_H
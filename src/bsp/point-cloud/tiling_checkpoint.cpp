@@ -0,0 +1,273 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "tiling_checkpoint.h"
+#include "binary_io.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace OOC3DTileLib {
+
+static const char     TILING_CHECKPOINT_MAGIC[8] = {'B', 'S', 'P', 'C', 'K', 'P', 'N', 'T'};
+static const uint32_t TILING_CHECKPOINT_VERSION  = 1;
+
+template <typename T>
+inline void write_vector (std::ostream &os, const std::vector<T> &v)
+{
+    write_value(os, static_cast<uint64_t>(v.size()));
+
+    for (unsigned int i = 0; i < v.size(); i++)
+        write_value(os, v.at(i));
+}
+
+template <typename T>
+inline bool read_vector (std::istream &is, std::vector<T> &v)
+{
+    uint64_t size = 0;
+
+    if (!read_value(is, size))
+        return false;
+
+    v.resize(size);
+
+    for (unsigned int i = 0; i < size; i++)
+        read_value(is, v.at(i));
+
+    return !is.fail();
+}
+
+inline
+bool save_tiling_checkpoint (const std::string &filename, const TilingCheckpoint &checkpoint)
+{
+    const std::string tmp_filename = filename + ".tmp";
+
+    std::ofstream os (tmp_filename.c_str(), std::ios::out | std::ios::binary);
+
+    if (!os.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << tmp_filename << std::endl;
+        return false;
+    }
+
+    os.write(TILING_CHECKPOINT_MAGIC, sizeof(TILING_CHECKPOINT_MAGIC));
+    write_value(os, TILING_CHECKPOINT_VERSION);
+
+    write_value(os, static_cast<int32_t>(checkpoint.stage));
+
+    write_value(os, static_cast<uint32_t>(checkpoint.input_filenames.size()));
+
+    for (unsigned int f = 0; f < checkpoint.input_filenames.size(); f++)
+        write_string(os, checkpoint.input_filenames.at(f));
+
+    write_string(os, checkpoint.out_ext);
+    write_value(os, static_cast<int32_t>(checkpoint.max_vtx_per_tile));
+    write_value(os, static_cast<uint8_t>(checkpoint.two_pass));
+    write_value(os, checkpoint.resolution);
+    write_value(os, checkpoint.attribute_mask);
+    write_value(os, static_cast<uint64_t>(checkpoint.lod_points));
+
+    write_value(os, static_cast<uint32_t>(checkpoint.scratch_directories.size()));
+
+    for (unsigned int d = 0; d < checkpoint.scratch_directories.size(); d++)
+        write_string(os, checkpoint.scratch_directories.at(d));
+
+    write_value(os, static_cast<uint64_t>(checkpoint.n_vertices));
+    write_value(os, static_cast<int32_t>(checkpoint.n_sample_vertices));
+
+    write_value(os, checkpoint.bb_min.x); write_value(os, checkpoint.bb_min.y); write_value(os, checkpoint.bb_min.z);
+    write_value(os, checkpoint.bb_max.x); write_value(os, checkpoint.bb_max.y); write_value(os, checkpoint.bb_max.z);
+
+    write_vector(os, checkpoint.infile2lastv);
+
+    const FillProgress &progress = checkpoint.fill_progress;
+
+    write_value(os, static_cast<uint64_t>(progress.binary_offset));
+    write_value(os, static_cast<uint32_t>(progress.file));
+    write_value(os, static_cast<uint64_t>(progress.file_vertex));
+    write_value(os, static_cast<uint64_t>(progress.file_n_vertices_total));
+    write_value(os, static_cast<uint64_t>(progress.file_n_triangles_total));
+    write_value(os, static_cast<uint64_t>(progress.counter));
+
+    write_vector(os, progress.leaf_bytes);
+    write_vector(os, progress.leaf_n_vertices);
+
+    write_value(os, static_cast<uint64_t>(progress.leaf_statistics.size()));
+
+    for (unsigned int l = 0; l < progress.leaf_statistics.size(); l++)
+        write_statistics(os, progress.leaf_statistics.at(l));
+
+    write_vector(os, progress.file_n_vertices);
+
+    write_value(os, static_cast<uint64_t>(progress.file_leaves.size()));
+
+    for (unsigned int f = 0; f < progress.file_leaves.size(); f++)
+        write_vector(os, progress.file_leaves.at(f));
+
+    write_vector(os, progress.current_file_leaves);
+
+    os.close();
+
+    if (os.fail())
+    {
+        std::cerr << "[ERROR] Writing file " << tmp_filename << std::endl;
+        return false;
+    }
+
+    // replace the previous checkpoint only once the new one is complete
+    remove(filename.c_str());
+
+    if (rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        std::cerr << "[ERROR] Renaming " << tmp_filename << " to " << filename << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+inline
+bool load_tiling_checkpoint (const std::string &filename, TilingCheckpoint &checkpoint)
+{
+    std::ifstream is (filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!is.is_open())
+        return false;
+
+    char magic[8];
+    uint32_t version = 0;
+
+    is.read(magic, sizeof(magic));
+
+    if (is.fail() || std::memcmp(magic, TILING_CHECKPOINT_MAGIC, sizeof(magic)) != 0 ||
+        !read_value(is, version) || version != TILING_CHECKPOINT_VERSION)
+    {
+        std::cerr << "[WARNING] " << filename << " is not a tiling checkpoint (or has an unsupported version)" << std::endl;
+        return false;
+    }
+
+    int32_t stage = 0, max_vtx_per_tile = 0, n_sample_vertices = 0;
+    uint32_t n_files = 0, file = 0;
+    uint8_t two_pass = 0;
+    uint64_t n_vertices = 0;
+
+    read_value(is, stage);
+    read_value(is, n_files);
+
+    checkpoint.input_filenames.resize(n_files);
+
+    for (unsigned int f = 0; f < n_files; f++)
+        read_string(is, checkpoint.input_filenames.at(f));
+
+    read_string(is, checkpoint.out_ext);
+    read_value(is, max_vtx_per_tile);
+    read_value(is, two_pass);
+    read_value(is, checkpoint.resolution);
+    read_value(is, checkpoint.attribute_mask);
+
+    uint64_t lod_points = 0;
+
+    read_value(is, lod_points);
+
+    checkpoint.lod_points = lod_points;
+
+    uint32_t n_scratch_directories = 0;
+
+    read_value(is, n_scratch_directories);
+
+    checkpoint.scratch_directories.resize(n_scratch_directories);
+
+    for (unsigned int d = 0; d < n_scratch_directories; d++)
+        read_string(is, checkpoint.scratch_directories.at(d));
+
+    read_value(is, n_vertices);
+    read_value(is, n_sample_vertices);
+
+    read_value(is, checkpoint.bb_min.x); read_value(is, checkpoint.bb_min.y); read_value(is, checkpoint.bb_min.z);
+    read_value(is, checkpoint.bb_max.x); read_value(is, checkpoint.bb_max.y); read_value(is, checkpoint.bb_max.z);
+
+    read_vector(is, checkpoint.infile2lastv);
+
+    FillProgress &progress = checkpoint.fill_progress;
+
+    uint64_t binary_offset = 0, file_vertex = 0, file_n_vertices_total = 0, file_n_triangles_total = 0, counter = 0, n_file_leaves = 0;
+
+    read_value(is, binary_offset);
+    read_value(is, file);
+    read_value(is, file_vertex);
+    read_value(is, file_n_vertices_total);
+    read_value(is, file_n_triangles_total);
+    read_value(is, counter);
+
+    read_vector(is, progress.leaf_bytes);
+    read_vector(is, progress.leaf_n_vertices);
+
+    uint64_t n_leaf_statistics = 0;
+
+    read_value(is, n_leaf_statistics);
+
+    progress.leaf_statistics.resize(n_leaf_statistics);
+
+    for (unsigned int l = 0; l < n_leaf_statistics; l++)
+        read_statistics(is, progress.leaf_statistics.at(l));
+
+    read_vector(is, progress.file_n_vertices);
+
+    read_value(is, n_file_leaves);
+
+    progress.file_leaves.resize(n_file_leaves);
+
+    for (unsigned int f = 0; f < n_file_leaves; f++)
+        read_vector(is, progress.file_leaves.at(f));
+
+    if (!read_vector(is, progress.current_file_leaves))
+    {
+        std::cerr << "[WARNING] Reading file " << filename << std::endl;
+        return false;
+    }
+
+    checkpoint.stage             = stage;
+    checkpoint.max_vtx_per_tile  = max_vtx_per_tile;
+    checkpoint.two_pass          = (two_pass != 0);
+    checkpoint.n_vertices        = n_vertices;
+    checkpoint.n_sample_vertices = n_sample_vertices;
+
+    progress.binary_offset          = binary_offset;
+    progress.file                   = file;
+    progress.file_vertex            = file_vertex;
+    progress.file_n_vertices_total  = file_n_vertices_total;
+    progress.file_n_triangles_total = file_n_triangles_total;
+    progress.counter                = counter;
+
+    return true;
+}
+
+}
@@ -0,0 +1,84 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+
+#ifndef TILING_CHECKPOINT_H
+#define TILING_CHECKPOINT_H
+
+#include "bsp.h"
+
+#include <string>
+#include <vector>
+
+namespace OOC3DTileLib {
+
+enum TilingStage
+{
+    STAGE_NONE       = 0,
+    STAGE_INGESTED   = 1,     // V_downsample (and V_binary, unless two pass) written
+    STAGE_TREE_BUILT = 2,     // bsp created and saved as checkpoint index
+    STAGE_FILLING    = 3,     // fill in progress (see fill_progress)
+    STAGE_FILLED     = 4      // leaf files complete: writing tiles
+};
+
+// Everything a rerun needs to resume a tiling from its last consistent point.
+struct TilingCheckpoint
+{
+    int stage = STAGE_NONE;
+
+    // the run the checkpoint belongs to
+    std::vector<std::string> input_filenames;
+    std::string out_ext;
+    int max_vtx_per_tile = 0;
+    bool two_pass = false;      // fill positions refer to the input files instead of V_binary
+    double resolution = 0;      // encoding of V_binary and of the leaf files
+    uint8_t attribute_mask = 0;     // point attributes in V_binary and in the leaf files
+    stxxl::uint64 lod_points = 0;   // LOD sample of the inner cells (0: none)
+    std::vector<std::string> scratch_directories;     // where the intermediate files are
+
+    // ingest
+    stxxl::uint64 n_vertices = 0;
+    int n_sample_vertices = 0;
+    Vtx bb_min, bb_max;
+    std::vector<stxxl::uint64> infile2lastv;
+
+    // fill
+    FillProgress fill_progress;
+};
+
+bool save_tiling_checkpoint (const std::string &filename, const TilingCheckpoint &checkpoint);     // atomic (write + rename)
+bool load_tiling_checkpoint (const std::string &filename, TilingCheckpoint &checkpoint);
+
+}
+
+#ifndef OOC3DTileLib_STATIC
+#include "tiling_checkpoint.cpp"
+#endif
+
+#endif // TILING_CHECKPOINT_H
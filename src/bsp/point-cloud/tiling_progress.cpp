@@ -0,0 +1,119 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "tiling_progress.h"
+
+#include <iostream>
+#include <sstream>
+
+void console_progress (const ProgressEvent &event)
+{
+    static std::mutex console_mutex;
+
+    std::stringstream line;
+
+    line << " --- --- " << event.description << " .. ";
+
+    if (event.completed)
+        line << event.total << " \\ " << event.total << " -- COMPLETED";
+    else
+    {
+        line << event.processed << " \\ " << event.total << " ( " << (event.processed * 100 / event.total) << "% )";
+
+        if (event.eta >= 0)
+            line << " -- ETA " << (uint64_t) (event.eta + 0.5) << " s";
+    }
+
+    std::lock_guard<std::mutex> lock (console_mutex);
+
+    std::cout << line.str() << std::endl;
+}
+
+ProgressReporter::ProgressReporter (const ProgressCallback &callback, const std::string &stage, const std::string &description,
+                                    const uint64_t total, const unsigned int file, const unsigned int n_files, const uint64_t first)
+    : processed(first), completed(false)
+{
+    this->callback = callback;
+    this->start    = std::chrono::steady_clock::now();
+    this->first    = first;
+    this->step     = (total + 9) / 10;         // 10 reports, the first one at 0
+
+    event.stage       = stage;
+    event.description = description;
+    event.file        = file;
+    event.n_files     = n_files;
+    event.total       = total;
+
+    // nothing to report: the loops never get there
+    next_report = (callback && total > 0) ? 0 : UINT64_MAX;
+}
+
+void ProgressReporter::report_due (const uint64_t processed)
+{
+    uint64_t due = next_report.load(std::memory_order_relaxed);
+
+    // the thread moving next_report past processed reports it
+    while (processed >= due && processed < event.total)
+    {
+        if (next_report.compare_exchange_weak(due, (processed / step + 1) * step, std::memory_order_relaxed))
+        {
+            report(processed, false);
+            return;
+        }
+    }
+}
+
+void ProgressReporter::report (const uint64_t processed, const bool completed)
+{
+    std::lock_guard<std::mutex> lock (report_mutex);
+
+    ProgressEvent e = event;
+
+    e.processed = completed ? event.total : processed;
+    e.completed = completed;
+    e.seconds   = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (e.seconds > 0 && e.processed > first)
+    {
+        e.throughput = (e.processed - first) / e.seconds;
+        e.eta        = (e.total - e.processed) / e.throughput;
+    }
+
+    callback(e);
+}
+
+void ProgressReporter::complete ()
+{
+    if (!callback || event.total == 0 || completed.exchange(true))
+        return;
+
+    next_report = UINT64_MAX;
+
+    report(event.total, true);
+}
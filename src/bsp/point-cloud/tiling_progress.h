@@ -0,0 +1,119 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#ifndef TILING_PROGRESS_H
+#define TILING_PROGRESS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+// Progress of the long loops of a tiling (ingest, fill, triangle classification, tile writing): reported to a
+// callback every 10% of the items of the loop and once completed. An empty callback reports nothing (quiet).
+
+struct ProgressEvent
+{
+    std::string stage;          // ingest, sample, fill, triangles, write
+    std::string description;    // of the console line, e.g. "Reading Vertices"
+
+    unsigned int file    = 0;   // per input file loops (n_files > 0): the current file
+    unsigned int n_files = 0;
+
+    uint64_t processed = 0;     // items of the loop (points, triangles or tiles)
+    uint64_t total     = 0;
+
+    double seconds    = 0;      // since the loop started
+    double throughput = 0;      // items per second
+    double eta        = -1;     // seconds to the end of the loop, at the current throughput (-1: not known yet)
+
+    bool completed = false;
+};
+
+typedef std::function<void(const ProgressEvent &)> ProgressCallback;
+
+void console_progress (const ProgressEvent &event);     // " --- --- Reading Vertices .. i \ n ( 10% )" lines
+
+// Reports the progress of a loop. The counts are atomic: a call costs a load and a comparison unless a report is
+// due, and only one of the threads crossing a 10% step reports it.
+class ProgressReporter
+{
+private:
+
+    ProgressCallback callback;
+
+    ProgressEvent event;
+
+    std::chrono::steady_clock::time_point start;
+
+    uint64_t first;     // items already processed when the loop started (resumed loops)
+    uint64_t step;
+
+    std::atomic<uint64_t> processed;
+    std::atomic<uint64_t> next_report;      // items of the next report
+
+    std::atomic<bool> completed;
+
+    std::mutex report_mutex;    // one callback at a time
+
+    void report (const uint64_t processed, const bool completed);
+
+    void report_due (const uint64_t processed);
+
+public:
+
+    ProgressReporter (const ProgressCallback &callback, const std::string &stage, const std::string &description, const uint64_t total,
+                      const unsigned int file = 0, const unsigned int n_files = 0, const uint64_t first = 0);
+
+    // Items processed so far, by the (single) thread of the loop
+    void update (const uint64_t processed)
+    {
+        if (processed >= next_report.load(std::memory_order_relaxed))
+            report_due(processed);
+    }
+
+    // More items processed, by any thread
+    void advance (const uint64_t n = 1)
+    {
+        const uint64_t p = processed.fetch_add(n, std::memory_order_relaxed) + n;
+
+        if (p >= next_report.load(std::memory_order_relaxed))
+            report_due(p);
+    }
+
+    void complete ();   // once, and only for loops with items
+};
+
+#ifndef OOCTRITILELIB_STATIC
+#include "tiling_progress.cpp"
+#endif
+
+#endif // TILING_PROGRESS_H
@@ -0,0 +1,195 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "tiling_state.h"
+#include "binary_io.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <sys/stat.h>
+
+namespace OOC3DTileLib {
+
+static const char     TILING_STATE_MAGIC[8] = {'B', 'S', 'P', 'S', 'T', 'A', 'T', 'E'};
+static const uint32_t TILING_STATE_VERSION  = 1;
+
+inline
+bool get_file_fingerprint (const std::string &filename, InputFileState &file, const bool with_hash)
+{
+    struct stat info;
+
+    if (stat(filename.c_str(), &info) != 0)
+    {
+        std::cerr << "[ERROR] Reading attributes of " << filename << std::endl;
+        return false;
+    }
+
+    file.filename = filename;
+    file.size     = info.st_size;
+    file.mtime    = info.st_mtime;
+    file.hash     = 0;
+
+    if (!with_hash)
+        return true;
+
+    std::ifstream is (filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!is.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << filename << std::endl;
+        return false;
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+
+    std::vector<char> buffer (1 << 20);
+
+    while (is.read(buffer.data(), buffer.size()) || is.gcount() > 0)
+    {
+        std::streamsize n = is.gcount();
+
+        for (std::streamsize i = 0; i < n; i++)
+        {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    file.hash = hash;
+
+    return true;
+}
+
+inline
+bool save_tiling_state (const std::string &filename, const TilingState &state)
+{
+    std::ofstream os (filename.c_str(), std::ios::out | std::ios::binary);
+
+    if (!os.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << filename << std::endl;
+        return false;
+    }
+
+    os.write(TILING_STATE_MAGIC, sizeof(TILING_STATE_MAGIC));
+    write_value(os, TILING_STATE_VERSION);
+
+    write_string(os, state.out_ext);
+    write_value(os, static_cast<uint32_t>(state.files.size()));
+
+    for (unsigned int f = 0; f < state.files.size(); f++)
+    {
+        const InputFileState &file = state.files.at(f);
+
+        write_string(os, file.filename);
+        write_value(os, file.size);
+        write_value(os, file.mtime);
+        write_value(os, file.hash);
+        write_value(os, file.first_id);
+        write_value(os, file.n_points);
+
+        write_value(os, static_cast<uint32_t>(file.leaves.size()));
+
+        for (unsigned int l = 0; l < file.leaves.size(); l++)
+            write_value(os, static_cast<int32_t>(file.leaves.at(l)));
+    }
+
+    os.close();
+
+    if (os.fail())
+    {
+        std::cerr << "[ERROR] Writing file " << filename << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+inline
+bool load_tiling_state (const std::string &filename, TilingState &state)
+{
+    std::ifstream is (filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!is.is_open())
+        return false;
+
+    char magic[8];
+    uint32_t version = 0;
+    uint32_t n_files = 0;
+
+    is.read(magic, sizeof(magic));
+
+    if (is.fail() || std::memcmp(magic, TILING_STATE_MAGIC, sizeof(magic)) != 0 ||
+        !read_value(is, version) || version != TILING_STATE_VERSION)
+    {
+        std::cerr << "[ERROR] " << filename << " is not a tiling state (or has an unsupported version)" << std::endl;
+        return false;
+    }
+
+    read_string(is, state.out_ext);
+    read_value(is, n_files);
+
+    state.files.resize(n_files);
+
+    for (unsigned int f = 0; f < n_files; f++)
+    {
+        InputFileState &file = state.files.at(f);
+
+        uint32_t n_leaves = 0;
+
+        read_string(is, file.filename);
+        read_value(is, file.size);
+        read_value(is, file.mtime);
+        read_value(is, file.hash);
+        read_value(is, file.first_id);
+        read_value(is, file.n_points);
+        read_value(is, n_leaves);
+
+        file.leaves.resize(n_leaves);
+
+        for (unsigned int l = 0; l < n_leaves; l++)
+        {
+            int32_t leaf = 0;
+            read_value(is, leaf);
+            file.leaves.at(l) = leaf;
+        }
+    }
+
+    if (is.fail())
+    {
+        std::cerr << "[ERROR] Reading file " << filename << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,73 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+
+#ifndef TILING_STATE_H
+#define TILING_STATE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OOC3DTileLib {
+
+// What a tiling run knows about one of its input files.
+struct InputFileState
+{
+    std::string filename;
+
+    uint64_t size  = 0;     // fingerprint: size in bytes,
+    int64_t  mtime = 0;     // last modification time,
+    uint64_t hash  = 0;     // and 64-bit FNV-1a hash of the content
+
+    uint64_t first_id = 0;  // global id of the first point of the file
+    uint64_t n_points = 0;
+
+    std::vector<int> leaves;    // leaves receiving at least one point of the file
+};
+
+struct TilingState
+{
+    std::string out_ext;
+
+    std::vector<InputFileState> files;      // in global id order
+};
+
+bool get_file_fingerprint (const std::string &filename, InputFileState &file, const bool with_hash);
+
+bool save_tiling_state (const std::string &filename, const TilingState &state);
+bool load_tiling_state (const std::string &filename, TilingState &state);
+
+}
+
+#ifndef OOC3DTileLib_STATIC
+#include "tiling_state.cpp"
+#endif
+
+#endif // TILING_STATE_H
@@ -0,0 +1,146 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "tiling_stats.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <sys/stat.h>
+
+namespace OOC3DTileLib {
+
+StageTimer::StageTimer (TilingStats *stats, const std::string &name)
+{
+    this->stats = stats;
+    this->start = std::chrono::steady_clock::now();
+
+    stage.name = name;
+}
+
+void StageTimer::stop ()
+{
+    if (stopped || stats == nullptr)
+        return;
+
+    stopped = true;
+
+    stage.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    stats->stages.push_back(stage);
+
+    std::cout << "[STATS] " << stage.name << ": " << stage.seconds << " s";
+
+    if (stage.points > 0 && stage.seconds > 0)
+        std::cout << " (" << stage.points << " points, " << stage.points / stage.seconds << " points/s)";
+
+    std::cout << std::endl;
+}
+
+stxxl::uint64 get_file_size (const std::string &filename)
+{
+    struct stat info;
+
+    if (stat(filename.c_str(), &info) != 0)
+        return 0;
+
+    return info.st_size;
+}
+
+void TilingStats::set_input (const std::vector<std::string> &input_filenames)
+{
+    n_input_files = input_filenames.size();
+    input_bytes   = 0;
+
+    for (unsigned int f = 0; f < input_filenames.size(); f++)
+        input_bytes += get_file_size(input_filenames.at(f));
+}
+
+static void json_rate (std::ostream &os, const char *key, const stxxl::uint64 count, const double seconds)
+{
+    os << "\"" << key << "\": " << ((seconds > 0) ? count / seconds : 0);
+}
+
+bool TilingStats::save_json (const std::string &filename) const
+{
+    std::ofstream os (filename.c_str(), std::ios::out);
+
+    if (!os.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << filename << std::endl;
+        return false;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    os << std::setprecision(15);
+
+    os << "{" << std::endl;
+    os << "  \"version\": 1," << std::endl;
+    os << "  \"seconds\": " << seconds << "," << std::endl;
+    os << "  \"peak_rss_bytes\": " << get_peak_rss() << "," << std::endl;
+    os << "  \"input\": { \"files\": " << n_input_files << ", \"bytes\": " << input_bytes << ", \"points\": " << n_points << " }," << std::endl;
+    os << "  \"tiles\": " << n_tiles << "," << std::endl;
+
+    os << "  \"stages\": [" << std::endl;
+
+    for (unsigned int s = 0; s < stages.size(); s++)
+    {
+        const StageStats &stage = stages.at(s);
+
+        os << "    { \"name\": \"" << stage.name << "\", \"seconds\": " << stage.seconds
+           << ", \"points\": " << stage.points << ", \"bytes_read\": " << stage.bytes_read << ", \"bytes_written\": " << stage.bytes_written << ", ";
+        json_rate(os, "points_per_second", stage.points, stage.seconds);
+        os << ", ";
+        json_rate(os, "bytes_per_second", stage.bytes_read + stage.bytes_written, stage.seconds);
+        os << " }" << ((s + 1 < stages.size()) ? "," : "") << std::endl;
+    }
+
+    os << "  ]," << std::endl;
+
+    os << "  \"file_manager\": { \"points_written\": " << file_manager.points_written << ", \"bytes_written\": " << file_manager.bytes_written
+       << ", \"files_opened\": " << file_manager.files_opened << ", \"evictions\": " << file_manager.evictions << " }" << std::endl;
+
+    os << "}" << std::endl;
+
+    os.close();
+
+    if (os.fail())
+    {
+        std::cerr << "[ERROR] Writing file " << filename << std::endl;
+        return false;
+    }
+
+    std::cout << "[OUTPUT] Statistics saved: " << filename << std::endl;
+
+    return true;
+}
+
+}
@@ -0,0 +1,105 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#ifndef TILING_STATS_H
+#define TILING_STATS_H
+
+#include "bsp.h"
+#include "peak_rss.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace OOC3DTileLib {
+
+// Instrumentation of a tiling run: time, points and bytes of each stage, I/O of the fill, peak memory.
+// Saved as JSON (--stats) to size hardware and compare runs.
+
+struct StageStats
+{
+    std::string name;
+
+    double seconds = 0;
+
+    stxxl::uint64 points        = 0;    // points processed by the stage
+    stxxl::uint64 bytes_read    = 0;
+    stxxl::uint64 bytes_written = 0;
+};
+
+struct TilingStats
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<StageStats> stages;     // in run order (stages resumed from a checkpoint are not there)
+
+    stxxl::uint64 n_input_files = 0;
+    stxxl::uint64 input_bytes   = 0;
+    stxxl::uint64 n_points      = 0;
+    stxxl::uint64 n_tiles       = 0;    // non empty leaves
+
+    FileManagerCounters file_manager;   // of the fill
+
+    void set_input (const std::vector<std::string> &input_filenames);
+
+    bool save_json (const std::string &filename) const;
+};
+
+// Times a stage, from construction to stop (or destruction), and adds it to the stats with the counts set meanwhile.
+// No stats: the stage is not recorded (e.g. restored from a checkpoint).
+class StageTimer
+{
+private:
+
+    TilingStats *stats;
+
+    std::chrono::steady_clock::time_point start;
+
+    bool stopped = false;
+
+public:
+
+    StageStats stage;
+
+    StageTimer (TilingStats *stats, const std::string &name);
+
+    ~StageTimer () { stop(); }
+
+    void stop ();
+};
+
+stxxl::uint64 get_file_size (const std::string &filename);      // 0 if missing
+
+}
+
+#ifndef OOC3DTileLib_STATIC
+#include "tiling_stats.cpp"
+#endif
+
+#endif // TILING_STATS_H
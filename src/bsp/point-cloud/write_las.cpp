@@ -27,175 +27,273 @@
 *                                                                               *
 *********************************************************************************/
 #include "write_las.h"
+#include "write_tiles.h"
+#include "point_codec.h"
 #include "liblas/writer.hpp"
 #include <liblas/reader.hpp>
 
+#include <map>
+#include <memory>
+#include <numeric>
+
 void write_bsp_LAS( BinarySpacePartition &bsp,
                    const std::vector<std::string> &input_filenames,
                    const std::vector<stxxl::uint64> &infile2lastv,
                    const std::string out_directory)
 {
-    liblas::Header header;
+    std::vector<int> leaves (bsp.get_n_cells());
+    std::iota(leaves.begin(), leaves.end(), 0);
 
-    // if the input is a las colection of files
-    if (input_filenames.at(0).substr(input_filenames.at(0).find_last_of(".")).compare(".las") == 0)
-    {
-        // read the header from the input
-        std::ifstream infile;
-        infile.open(input_filenames.at(0));
+    write_bsp_LAS(bsp, input_filenames, infile2lastv, out_directory, leaves);
+}
 
-        liblas::Reader reader (infile);
-        header = reader.GetHeader();
+static liblas::VariableRecord classification_histogram_record (const PointStatistics &statistics)
+{
+    std::vector<uint8_t> data;
 
-        infile.close();
+    for (int c = 0; c < N_CLASSES; c++)
+        for (int b = 0; b < 8; b++)
+            data.push_back(static_cast<uint8_t>(statistics.n_points_by_class[c] >> (8 * b)));
+
+    liblas::VariableRecord record;
+
+    record.SetUserId(LAS_TILING_USER_ID);
+    record.SetRecordId(LAS_CLASSIFICATION_HISTOGRAM_RECORD);
+    record.SetDescription("Classification histogram");
+    record.SetRecordLength(data.size());
+    record.SetData(data);
+
+    return record;
+}
+
+static void set_las_attributes (liblas::Point &point, const uint8_t mask, const PointAttributes &attributes)
+{
+    if (mask & ATTRIBUTE_INTENSITY)
+        point.SetIntensity(attributes.intensity);
+
+    if (mask & ATTRIBUTE_RETURNS)
+    {
+        point.SetReturnNumber(attributes.return_number);
+        point.SetNumberOfReturns(attributes.number_of_returns);
     }
 
-    for (int leaf=0; leaf < bsp.get_n_leaves(); leaf++)
+    if (mask & ATTRIBUTE_CLASSIFICATION)
+        point.SetClassification(attributes.classification);
+
+    if (mask & ATTRIBUTE_RGB)
+        point.SetColor(liblas::Color(attributes.red, attributes.green, attributes.blue));
+
+    if (mask & ATTRIBUTE_GPS_TIME)
+        point.SetTime(attributes.gps_time);
+}
+
+static void write_leaf_LAS (BinarySpacePartition &bsp,
+                           const std::vector<std::string> &input_filenames,
+                           const std::vector<stxxl::uint64> &infile2lastv,
+                           const std::string out_directory,
+                           const liblas::Header &input_header,
+                           const int leaf)
+{
+    liblas::Header header = input_header;     // own copy: the point count is per tile
+
+    BspCell *cell = bsp.get_cell(leaf);      // a leaf or a LOD cell
+
+    if (cell->n_inner_vertices == 0)   
     {
-        BspCell *cell = bsp.get_leaf(leaf);
+        remove (cell->filename_inner_v.c_str());
 
-        if (cell->n_inner_vertices == 0)   
+        if (bsp.has_polys())
         {
-            remove (cell->filename_inner_v.c_str());
             remove (cell->filename_boundary_v.c_str());
             remove (cell->filename_inner_t.c_str());
-
-            continue;   
         }
 
-        // read boundary vertices
-        std::set<stxxl::uint64> added_vertices;
+        return;
+    }
 
-        std::ifstream cell_stream (cell->filename_boundary_v.c_str(), std::fstream::in | std::fstream::binary);
+    // read boundary vertices (meshes only): id and coordinates, by id (a vertex may be added more than once)
+    std::map<stxxl::uint64, Point> added_vertices;
 
-        if (!cell_stream.is_open())
+    std::ifstream cell_stream;
+
+    if (bsp.has_polys())
+        cell_stream.open(cell->filename_boundary_v.c_str(), std::fstream::in | std::fstream::binary);
+
+    if (!cell_stream.is_open())
+    {
+        if (bsp.has_polys())
+            log_tile("[WARNING] No additional vertices.");
+    }
+    else
+    {
+        stxxl::uint64 vertex;
+        Point point;
+
+        while (cell_stream.read (reinterpret_cast<char *>(&vertex),sizeof(vertex)) &&
+               cell_stream.read (reinterpret_cast<char *>(&point.x),sizeof(point.x)) &&
+               cell_stream.read (reinterpret_cast<char *>(&point.y),sizeof(point.y)) &&
+               cell_stream.read (reinterpret_cast<char *>(&point.z),sizeof(point.z)))
         {
-            std::cout << "[WARNING] No additional vertices." << std::endl;
+            added_vertices[vertex] = point;
         }
-        else
-        {
-            stxxl::uint64 vertex;
 
-            while (cell_stream.read (reinterpret_cast<char *>(&vertex),sizeof(vertex)) && !cell_stream.fail())
-            {
-                added_vertices.insert(vertex);
-            }
+        cell_stream.close();
+    }
 
-            cell_stream.close();
-        }
+    cell_stream.open(cell->filename_inner_v.c_str(), std::fstream::in | std::fstream::binary);
 
-        cell_stream.open(cell->filename_inner_v.c_str());
+    if (!cell_stream.is_open())
+    {
+        std::cout << "[ERROR] Opening file " << cell->filename_inner_v << std::endl;
+        exit(1);
+    }
 
-        if (!cell_stream.is_open())
-        {
-            std::cout << "[ERROR] Opening file " << cell->filename_inner_v << std::endl;
-            exit(1);
-        }
+    std::string out_filename = out_directory + bsp.get_cell_name(leaf) + (header.Compressed() ? ".laz" : ".las");
+    std::string local2global_filename = out_directory + bsp.get_cell_name(leaf) + "_v_loc2glob";
 
-        std::string out_filename = out_directory + "cell_" + std::to_string(leaf) + ".las";
-        std::string local2global_filename = out_directory + "cell_" + std::to_string(leaf) + "_v_loc2glob";
+    cell->filename_mesh = out_filename;
+    cell->filename_local2global = local2global_filename;
 
-        cell->filename_mesh = out_filename;
-        cell->filename_local2global = local2global_filename;
+    header.SetPointRecordsCount(cell->n_inner_vertices + added_vertices.size());
 
-        header.SetPointRecordsCount(cell->n_inner_vertices);
+    // header of the tile from the statistics of the fill (plus the boundary vertices): no pass over the points
+    PointStatistics &statistics = cell->statistics;
 
-        std::cout << "[OUTPUT] Writing " << out_filename << " (" << cell->n_inner_vertices << " points)" << std::endl;
+    // boundary vertices: single returns, with no other attribute
+    PointAttributes boundary_attributes;
+    boundary_attributes.return_number = boundary_attributes.number_of_returns = 1;
 
-        std::map <stxxl::uint64, int> global_local_vertices;
+    for (const auto &v : added_vertices)
+        statistics.add(v.second.x, v.second.y, v.second.z, boundary_attributes, bsp.get_attribute_mask());
 
-        std::ofstream pc_out_stream;
-        pc_out_stream.open(out_filename.c_str());
+    if (!statistics.is_empty())
+    {
+        header.SetMin(statistics.min[0], statistics.min[1], statistics.min[2]);
+        header.SetMax(statistics.max[0], statistics.max[1], statistics.max[2]);
+    }
 
-        liblas::Writer writer (pc_out_stream, header);
+    for (int r = 0; r < N_RETURN_COUNTS; r++)
+        header.SetPointRecordsByReturnCount(r, statistics.n_points_by_return[r]);
 
-        std::ofstream local2global_out_stream (local2global_filename.c_str(), std::fstream::out);
+    if (bsp.get_attribute_mask() & ATTRIBUTE_CLASSIFICATION)
+        header.AddVLR(classification_histogram_record(statistics));
 
-        if (!pc_out_stream.is_open() || !local2global_out_stream.is_open())
-        {
-            std::cout << "[ERROR] Opening file " << out_filename <<  " or " << local2global_filename << std::endl;
-            exit(1);
-        }
+    log_tile("[OUTPUT] Writing " + out_filename + " (" + std::to_string(cell->n_inner_vertices) + " points)");
 
-        stxxl::uint64 id;
-        double x,y,z;
+    std::ofstream pc_out_stream;
+    pc_out_stream.open(out_filename.c_str(), std::ios::out | std::ios::binary);
 
-        int vid = 0;
-        uint curr_infile_id = 0;
+    // destroyed before the stream is closed: it completes the file (LAZ chunks, header)
+    std::unique_ptr<liblas::Writer> writer (new liblas::Writer (pc_out_stream, header));
 
-        std::ifstream infile;
-        infile.open(input_filenames.at(0));
+    std::ofstream local2global_out_stream (local2global_filename.c_str(), std::fstream::out);
 
-        liblas::Reader *reader = new liblas::Reader (infile);
+    if (!pc_out_stream.is_open() || !local2global_out_stream.is_open())
+    {
+        std::cout << "[ERROR] Opening file " << out_filename <<  " or " << local2global_filename << std::endl;
+        exit(1);
+    }
 
-        for (; vid < cell->n_inner_vertices; vid++)
-        {
-            cell_stream.read (reinterpret_cast<char *>(&id),sizeof(id));
+    stxxl::uint64 id;
+    double x,y,z;
+    PointAttributes attributes;
 
-            cell_stream.read (reinterpret_cast<char *>(&x),sizeof(x));
-            cell_stream.read (reinterpret_cast<char *>(&y),sizeof(y));
-            cell_stream.read (reinterpret_cast<char *>(&z),sizeof(z));
+    int vid = 0;
 
-            liblas::Point point (&header);
-            point.SetCoordinates(x,y,z);
+    // attributes carried by the leaf files; without them (e.g. incremental updates), LAS points are read again from the input
+    const uint8_t attribute_mask = bsp.get_attribute_mask();
+    const bool    reread_input   = attribute_mask == 0 && is_las_file(input_filenames.at(0));
 
-            // if the input is a las colection of files
-            if (input_filenames.at(0).substr(input_filenames.at(0).find_last_of(".")).compare(".las") == 0)
-            {
-                uint file_id;
-                for (uint i=0; i < infile2lastv.size(); i++)
-                    if (id <= infile2lastv.at(i))
-                    {
-                        file_id=i;
-                        break;
-                    }
-
-                if (file_id != curr_infile_id)
-                {
-                    infile.close();
-                    infile.open(input_filenames.at(file_id));
-                    curr_infile_id = file_id;
-                    delete reader;
-                    reader = new liblas::Reader(infile);
-                }
+    PointDecoder decoder (bsp.get_resolution(), true, attribute_mask);
+    uint curr_infile_id = 0;
 
-                stxxl::uint64 last_prev = (curr_infile_id==0) ? 0 : infile2lastv.at(curr_infile_id-1)+1;
-                uint nv = reader->GetHeader().GetPointRecordsCount();
+    std::ifstream infile;
+    liblas::Reader *reader = nullptr;
 
-                reader->ReadPointAt(id-last_prev);
-                point = reader->GetPoint();
+    if (reread_input)
+    {
+        infile.open(input_filenames.at(0), std::ios::in | std::ios::binary);
+        reader = new liblas::Reader (liblas::ReaderFactory().CreateWithStream(infile));
+    }
 
-//                std::cout << point.GetX() << " " << point.GetY() << " " << point.GetZ() << std::endl;
-//                std::cout << x << " " << y << " " << z << std::endl ;
-//                std::cout << std::endl;
-            }
+    // a write failure is fatal, as in the other writers: no partial tile is left behind
+    auto write_error = [&]()
+    {
+        std::cout << "[ERROR] Writing file " << out_filename << std::endl;
+
+        pc_out_stream.close();
+        local2global_out_stream.close();
+
+        remove (out_filename.c_str());
+        remove (local2global_filename.c_str());
+
+        exit(1);
+    };
+
+    for (; vid < cell->n_inner_vertices; vid++)
+    {
+        if (!decoder.read(cell_stream, id, x, y, z, &attributes))
+        {
+            std::cout << "[ERROR] Reading file " << cell->filename_inner_v << std::endl;
+            exit(1);
+        }
 
-            bool success = writer.WritePoint(point);
+        liblas::Point point (&header);
+        point.SetCoordinates(x,y,z);
 
-            if (!success)
+        set_las_attributes(point, attribute_mask, attributes);
+
+        if (reread_input)
+        {
+            uint file_id;
+            for (uint i=0; i < infile2lastv.size(); i++)
+                if (id <= infile2lastv.at(i))
+                {
+                    file_id=i;
+                    break;
+                }
+
+            if (file_id != curr_infile_id)
             {
-                std::cerr << "Error writing " << out_filename << std::endl;
-                return;
+                infile.close();
+                infile.open(input_filenames.at(file_id), std::ios::in | std::ios::binary);
+                curr_infile_id = file_id;
+                delete reader;
+                reader = new liblas::Reader (liblas::ReaderFactory().CreateWithStream(infile));
             }
 
-//            pc_out_stream << std::setprecision(10) << x << " " << y << " " << z << std::endl;
+            stxxl::uint64 last_prev = (curr_infile_id==0) ? 0 : infile2lastv.at(curr_infile_id-1)+1;
 
-            global_local_vertices[id] = vid;
+            reader->ReadPointAt(id-last_prev);
+            point = reader->GetPoint();
 
-            local2global_out_stream << id << std::endl;
+            // the coordinates of the statistics (i.e. of the header): quantized to the resolution, if any
+            point.SetCoordinates(x,y,z);
         }
 
-        cell_stream.close();
+        if (!writer->WritePoint(point))
+            write_error();
 
-        for (int v : added_vertices)
-        {
-            pc_out_stream << std::setprecision(10) << bsp.get_point(v).x << " " << bsp.get_point(v).y << " " << bsp.get_point(v).z << std::endl;
+        local2global_out_stream << id << std::endl;
+    }
 
-            global_local_vertices[v] = vid++;
+    cell_stream.close();
 
-            local2global_out_stream << v << std::endl;
-        }
+    for (const auto &v : added_vertices)
+    {
+        liblas::Point point (&header);
+        point.SetCoordinates(v.second.x, v.second.y, v.second.z);
+
+        set_las_attributes(point, attribute_mask, boundary_attributes);
+
+        if (!writer->WritePoint(point))
+            write_error();
+
+        local2global_out_stream << v.first << std::endl;
+    }
 
+    if (bsp.has_polys())
+    {
         cell_stream.open(cell->filename_inner_t.c_str(), std::fstream::in | std::fstream::binary);
 
         if (!cell_stream.is_open())
@@ -205,16 +303,62 @@ void write_bsp_LAS( BinarySpacePartition &bsp,
         }
 
         cell_stream.close();
+    }
 
-        pc_out_stream.close();
-        local2global_out_stream.close();
+    writer.reset();
 
-        remove (cell->filename_inner_v.c_str());
+    pc_out_stream.close();
+    local2global_out_stream.close();
+
+    remove (cell->filename_inner_v.c_str());
+
+    if (bsp.has_polys())
+    {
         remove (cell->filename_boundary_v.c_str());
         remove (cell->filename_inner_t.c_str());
+    }
+
+    delete reader;
+
+    infile.close();
+}
+
+void write_bsp_LAS( BinarySpacePartition &bsp,
+                   const std::vector<std::string> &input_filenames,
+                   const std::vector<stxxl::uint64> &infile2lastv,
+                   const std::string out_directory,
+                   const std::vector<int> &leaves,
+                   const unsigned int n_threads,
+                   const bool compressed)
+{
+#ifndef USE_LASZIP
+    if (compressed)
+    {
+        std::cerr << "[ERROR] LAZ output needs libLAS with LASzip (build with USE_LASZIP)" << std::endl;
+        exit(1);
+    }
+#endif
+
+    liblas::Header header;
+
+    // if the input is a las colection of files
+    if (is_las_file(input_filenames.at(0)))
+    {
+        // read the header from the input
+        std::ifstream infile;
+        infile.open(input_filenames.at(0), std::ios::in | std::ios::binary);
+
+        liblas::Reader reader = liblas::ReaderFactory().CreateWithStream(infile);
+        header = reader.GetHeader();
 
         infile.close();
     }
+    else
+    if (bsp.get_attribute_mask() & ATTRIBUTE_RGB)
+        header.SetDataFormatId(liblas::ePointFormat2);      // color of XYZ inputs (LAS inputs keep their point format)
 
+    header.SetCompressed(compressed);     // LAZ chunks are compressed by the writer of each tile, in parallel
 
+    write_tiles(leaves, n_threads, [&](const int leaf) { write_leaf_LAS(bsp, input_filenames, infile2lastv, out_directory, header, leaf); },
+                bsp.get_progress());
 }
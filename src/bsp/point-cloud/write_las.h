@@ -31,11 +31,26 @@
 
 #include "bsp.h"
 
+// Variable length record of each tile with its classification histogram (written if the points carry a classification):
+// N_CLASSES counts, little endian uint64
+#define LAS_TILING_USER_ID                  "OOCTriTile"
+#define LAS_CLASSIFICATION_HISTOGRAM_RECORD 1
+
 void write_bsp_LAS (    BinarySpacePartition &bsp,
                         const std::vector<std::string> &input_filenames,
                         const std::vector<stxxl::uint64> &infile2lastv,
                         const std::string out_directory);
 
+// Writes only the given cells (positions in the bsp: leaves, then LOD cells), n_threads tiles at a time.
+// Compressed: LAZ tiles (USE_LASZIP builds only), each one compressed by the thread writing it.
+void write_bsp_LAS (    BinarySpacePartition &bsp,
+                        const std::vector<std::string> &input_filenames,
+                        const std::vector<stxxl::uint64> &infile2lastv,
+                        const std::string out_directory,
+                        const std::vector<int> &leaves,
+                        const unsigned int n_threads = 1,
+                        const bool compressed = false);
+
 #ifndef OOC3DTileLib_STATIC
 #include "write_las.cpp"
 #endif
@@ -0,0 +1,109 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "write_manifest.h"
+
+#include <algorithm>
+
+std::string relative_tile_filename (const std::string &filename, const std::string &out_directory)
+{
+    std::string relative = filename;
+
+    if (relative.compare(0, out_directory.size(), out_directory) == 0)
+        relative = relative.substr(out_directory.size());
+
+    while (!relative.empty() && relative.at(0) == '/')
+        relative.erase(0, 1);
+
+    return relative;
+}
+
+bool write_bsp_manifest (BinarySpacePartition &bsp, const std::string out_directory)
+{
+    std::vector<TileEntry> tiles;
+    std::vector<bool> is_tile (bsp.get_n_leaves(), false);
+
+    for (unsigned int leaf = 0; leaf < bsp.get_n_leaves(); leaf++)
+    {
+        const BspCell *cell = bsp.get_leaf(leaf);
+
+        is_tile.at(leaf) = cell->n_inner_vertices > 0 && !cell->filename_mesh.empty();
+    }
+
+    for (unsigned int leaf = 0; leaf < bsp.get_n_leaves(); leaf++)
+    {
+        if (!is_tile.at(leaf))
+            continue;
+
+        const BspCell *cell = bsp.get_leaf(leaf);
+
+        TileEntry tile;
+
+        tile.id       = leaf;
+        tile.n_points = cell->n_inner_vertices;
+
+        // statistics of the fill (and of the writers, for boundary vertices); the cell itself if missing (older index)
+        const PointStatistics &statistics = cell->statistics;
+
+        const double cell_min[3] = { cell->bbox_min.x, cell->bbox_min.y, cell->bbox_min.z };
+        const double cell_max[3] = { cell->bbox_max.x, cell->bbox_max.y, cell->bbox_max.z };
+
+        for (int i = 0; i < 3; i++)
+        {
+            tile.min[i] = statistics.is_empty() ? cell_min[i] : statistics.min[i];
+            tile.max[i] = statistics.is_empty() ? cell_max[i] : statistics.max[i];
+        }
+
+        tile.filename = relative_tile_filename(cell->filename_mesh, out_directory);
+
+        // cells touching this one, by the bsp, and (meshes) cells sharing vertices with it
+        std::vector<int> neighbors;
+
+        bsp.find_leaves(cell->bbox_min, cell->bbox_max, neighbors);
+        neighbors.insert(neighbors.end(), cell->neighbor_bsp_cells.begin(), cell->neighbor_bsp_cells.end());
+
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+        for (const int neighbor : neighbors)
+            if (neighbor != (int) leaf && neighbor >= 0 && neighbor < (int) is_tile.size() && is_tile.at(neighbor))
+                tile.neighbors.push_back(neighbor);
+
+        tiles.push_back(tile);
+    }
+
+    const std::string filename = out_directory + "/tiles.manifest";
+
+    if (!save_tile_manifest(filename, tiles))
+        return false;
+
+    std::cout << "[OUTPUT] Tile manifest saved: " << filename << " (" << tiles.size() << " tiles)" << std::endl;
+
+    return true;
+}
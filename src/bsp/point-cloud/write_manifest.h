@@ -0,0 +1,46 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#ifndef WRITE_MANIFEST_H
+#define WRITE_MANIFEST_H
+
+#include "bsp.h"
+#include "tile_manifest.h"
+
+// Writes <out_directory>/tiles.manifest (see tile_manifest.h) for the tiles of the bsp, once written.
+bool write_bsp_manifest (BinarySpacePartition &bsp, const std::string out_directory);
+
+// Filename of a tile relative to the out directory (the tiles are written there)
+std::string relative_tile_filename (const std::string &filename, const std::string &out_directory);
+
+#ifndef OOCTRITILELIB_STATIC
+#include "write_manifest.cpp"
+#endif
+
+#endif // WRITE_MANIFEST_H
@@ -0,0 +1,277 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "write_ply.h"
+#include "write_tiles.h"
+#include "binary_io.h"
+#include "point_codec.h"
+
+#include <algorithm>
+#include <numeric>
+
+struct TileVertex
+{
+    stxxl::uint64 vid;
+    double x, y, z;
+
+    bool operator< (const TileVertex &v) const { return vid < v.vid; }
+    bool operator== (const TileVertex &v) const { return vid == v.vid; }
+};
+
+void write_bsp_PLY( BinarySpacePartition &bsp, const std::string out_directory)
+{
+    std::vector<int> leaves (bsp.get_n_cells());
+    std::iota(leaves.begin(), leaves.end(), 0);
+
+    write_bsp_PLY(bsp, out_directory, leaves);
+}
+
+static void write_leaf_PLY (BinarySpacePartition &bsp, const std::string out_directory, const int leaf)
+{
+
+    BspCell *cell = bsp.get_cell(leaf);      // a leaf or a LOD cell
+
+    if (cell->n_inner_vertices == 0)
+    {
+        remove (cell->filename_inner_v.c_str());
+
+        if (bsp.has_polys())
+        {
+            remove (cell->filename_boundary_v.c_str());
+            remove (cell->filename_inner_t.c_str());
+        }
+
+        return;
+    }
+
+    // tile vertices: inner vertices (in file order), then boundary vertices (by id, once each)
+    std::vector<TileVertex> vertices;
+    vertices.reserve(cell->n_inner_vertices);
+
+    std::ifstream cell_stream (cell->filename_inner_v.c_str(), std::fstream::in | std::fstream::binary);
+
+    if (!cell_stream.is_open())
+    {
+        std::cout << "[ERROR] Opening file " << cell->filename_inner_v << std::endl;
+        exit(1);
+    }
+
+    const uint8_t attribute_mask = bsp.get_attribute_mask();
+
+    std::vector<PointAttributes> attributes;     // of the inner vertices (boundary vertices have none)
+
+    PointDecoder decoder (bsp.get_resolution(), true, attribute_mask);
+
+    for (stxxl::uint64 v = 0; v < cell->n_inner_vertices; v++)
+    {
+        TileVertex vertex;
+        PointAttributes vertex_attributes;
+
+        if (!decoder.read(cell_stream, vertex.vid, vertex.x, vertex.y, vertex.z, &vertex_attributes))
+        {
+            std::cout << "[ERROR] Reading file " << cell->filename_inner_v << std::endl;
+            exit(1);
+        }
+
+        vertices.push_back(vertex);
+
+        if (attribute_mask != 0)
+            attributes.push_back(vertex_attributes);
+    }
+
+    cell_stream.close();
+
+    const stxxl::uint64 n_inner_vertices = vertices.size();
+
+    if (bsp.has_polys())
+    {
+        cell_stream.open(cell->filename_boundary_v.c_str(), std::fstream::in | std::fstream::binary);
+
+        TileVertex vertex;
+
+        while (cell_stream.read (reinterpret_cast<char *>(&vertex.vid),sizeof(vertex.vid)) &&
+               cell_stream.read (reinterpret_cast<char *>(&vertex.x),sizeof(vertex.x)) &&
+               cell_stream.read (reinterpret_cast<char *>(&vertex.y),sizeof(vertex.y)) &&
+               cell_stream.read (reinterpret_cast<char *>(&vertex.z),sizeof(vertex.z)))
+        {
+            vertices.push_back(vertex);
+        }
+
+        cell_stream.close();
+
+        std::sort(vertices.begin() + n_inner_vertices, vertices.end());
+        vertices.erase(std::unique(vertices.begin() + n_inner_vertices, vertices.end()), vertices.end());
+
+        for (stxxl::uint64 v = n_inner_vertices; v < vertices.size(); v++)
+            cell->statistics.add(vertices.at(v).x, vertices.at(v).y, vertices.at(v).z);     // the bounding box of the tile
+    }
+
+    // global id --> local id, as a sorted array (binary search)
+    std::vector<std::pair<stxxl::uint64, uint32_t>> global_local_vertices (vertices.size());
+
+    for (uint32_t v = 0; v < vertices.size(); v++)
+        global_local_vertices.at(v) = std::make_pair(vertices.at(v).vid, v);
+
+    std::sort(global_local_vertices.begin(), global_local_vertices.end());
+
+    std::string out_filename = out_directory + bsp.get_cell_name(leaf) + ".ply";
+    std::string local2global_filename = out_directory + bsp.get_cell_name(leaf) + "_v_loc2glob";
+
+    cell->filename_mesh = out_filename;
+    cell->filename_local2global = local2global_filename;
+
+    const stxxl::uint64 n_triangles = bsp.has_polys() ? cell->n_inner_triangles : 0;
+
+    log_tile("[OUTPUT] Writing " + out_filename + " (" + std::to_string(vertices.size()) + " vertices, " + std::to_string(n_triangles) + " triangles)");
+
+    std::ofstream mesh_out_stream (out_filename.c_str(), std::fstream::out | std::fstream::binary);
+    std::ofstream local2global_out_stream (local2global_filename.c_str(), std::fstream::out);
+
+    if (!mesh_out_stream.is_open() || !local2global_out_stream.is_open())
+    {
+        std::cout << "[ERROR] Opening file " << out_filename <<  " or " << local2global_filename << std::endl;
+        exit(1);
+    }
+
+    // native byte order
+    mesh_out_stream << "ply" << "\n"
+                    << "format " << (host_is_little_endian() ? "binary_little_endian" : "binary_big_endian") << " 1.0" << "\n"
+                    << "element vertex " << vertices.size() << "\n"
+                    << "property double x" << "\n"
+                    << "property double y" << "\n"
+                    << "property double z" << "\n";
+
+    if (attribute_mask & ATTRIBUTE_INTENSITY)
+        mesh_out_stream << "property ushort intensity" << "\n";
+
+    if (attribute_mask & ATTRIBUTE_RETURNS)
+        mesh_out_stream << "property uchar return_number" << "\n"
+                        << "property uchar number_of_returns" << "\n";
+
+    if (attribute_mask & ATTRIBUTE_CLASSIFICATION)
+        mesh_out_stream << "property uchar classification" << "\n";
+
+    if (attribute_mask & ATTRIBUTE_RGB)
+        mesh_out_stream << "property ushort red" << "\n"
+                        << "property ushort green" << "\n"
+                        << "property ushort blue" << "\n";
+
+    if (attribute_mask & ATTRIBUTE_GPS_TIME)
+        mesh_out_stream << "property double gps_time" << "\n";
+
+    mesh_out_stream << "element face " << n_triangles << "\n"
+                    << "property list uchar uint vertex_indices" << "\n"
+                    << "end_header" << "\n";
+
+    std::string record;     // attributes, in the order of the properties (that of encode_attributes)
+
+    for (stxxl::uint64 v = 0; v < vertices.size(); v++)
+    {
+        const TileVertex &vertex = vertices.at(v);
+
+        write_value(mesh_out_stream, vertex.x);
+        write_value(mesh_out_stream, vertex.y);
+        write_value(mesh_out_stream, vertex.z);
+
+        if (attribute_mask != 0)
+        {
+            record.clear();
+            encode_attributes(record, attribute_mask, (v < n_inner_vertices) ? attributes.at(v) : PointAttributes());
+
+            mesh_out_stream.write(record.data(), record.size());
+        }
+
+        local2global_out_stream << vertex.vid << "\n";
+    }
+
+    if (n_triangles > 0)
+    {
+        cell_stream.open(cell->filename_inner_t.c_str(), std::fstream::in | std::fstream::binary);
+
+        if (!cell_stream.is_open())
+        {
+            std::cout << "[ERROR] Opening file " << cell->filename_inner_t << std::endl;
+            exit(1);
+        }
+
+        const uint8_t n_corners = 3;
+
+        stxxl::uint64 t[3];
+        uint32_t local_t[3];
+
+        for (stxxl::uint64 tid = 0; tid < n_triangles; tid++)
+        {
+            if (!cell_stream.read (reinterpret_cast<char *>(t),sizeof(t)))
+            {
+                std::cout << "[ERROR] Reading file " << cell->filename_inner_t << std::endl;
+                exit(1);
+            }
+
+            for (int k = 0; k < 3; k++)
+            {
+                auto it = std::lower_bound(global_local_vertices.begin(), global_local_vertices.end(), std::make_pair(t[k], (uint32_t) 0));
+
+                if (it == global_local_vertices.end() || it->first != t[k])
+                {
+                    std::cout << "[ERROR] Vertex " << t[k] << " of a triangle of cell " << cell->ID << " is not in the tile" << std::endl;
+                    exit(1);
+                }
+
+                local_t[k] = it->second;
+            }
+
+            write_value(mesh_out_stream, n_corners);
+            mesh_out_stream.write(reinterpret_cast<const char *>(local_t), sizeof(local_t));
+        }
+
+        cell_stream.close();
+    }
+
+    mesh_out_stream.close();
+    local2global_out_stream.close();
+
+    if (mesh_out_stream.fail())
+    {
+        std::cout << "[ERROR] Writing file " << out_filename << std::endl;
+        exit(1);
+    }
+
+    remove (cell->filename_inner_v.c_str());
+
+    if (bsp.has_polys())
+    {
+        remove (cell->filename_boundary_v.c_str());
+        remove (cell->filename_inner_t.c_str());
+    }
+}
+
+void write_bsp_PLY( BinarySpacePartition &bsp, const std::string out_directory, const std::vector<int> &leaves, const unsigned int n_threads)
+{
+    write_tiles(leaves, n_threads, [&](const int leaf) { write_leaf_PLY(bsp, out_directory, leaf); }, bsp.get_progress());
+}
@@ -0,0 +1,45 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+#ifndef WRITE_PLY_H
+#define WRITE_PLY_H
+
+#include "bsp.h"
+
+// Binary PLY tiles. A mesh tile is self-contained: its inner vertices, then the boundary vertices of its
+// triangles lying in other cells, and its triangles on local vertex ids. Point cloud tiles have no faces.
+void write_bsp_PLY (BinarySpacePartition &bsp, const std::string out_directory);
+
+// Writes only the given cells (positions in the bsp: leaves, then LOD cells), n_threads tiles at a time
+void write_bsp_PLY (BinarySpacePartition &bsp, const std::string out_directory, const std::vector<int> &leaves, const unsigned int n_threads = 1);
+
+#ifndef OOCTRITILELIB_STATIC
+#include "write_ply.cpp"
+#endif
+
+#endif // WRITE_PLY_H
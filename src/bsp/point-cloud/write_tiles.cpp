@@ -0,0 +1,88 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "write_tiles.h"
+#include "task_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+
+static std::mutex tile_log_mutex;
+
+void log_tile (const std::string &line)
+{
+    std::lock_guard<std::mutex> lock (tile_log_mutex);
+
+    std::cout << line << std::endl;
+}
+
+void write_tiles (const std::vector<int> &leaves, const unsigned int n_threads, const std::function<void(const int)> &write_leaf,
+                  const ProgressCallback &progress)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const unsigned int n_tiles = leaves.size();
+
+    ProgressReporter reporter (progress, "write", "Written tiles", n_tiles);
+
+    reporter.update(0);
+
+    auto write = [&](const int leaf)
+    {
+        write_leaf(leaf);
+
+        reporter.advance();
+    };
+
+    if (n_threads <= 1 || n_tiles <= 1)
+    {
+        for (unsigned int i = 0; i < n_tiles; i++)
+            write(leaves.at(i));
+    }
+    else
+    {
+        TaskPool pool (std::min(n_threads, n_tiles));
+
+        for (unsigned int i = 0; i < n_tiles; i++)
+        {
+            const int leaf = leaves.at(i);
+            pool.submit([&write, leaf]() { write(leaf); });
+        }
+
+        pool.wait();
+    }
+
+    reporter.complete();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[OUTPUT] " << n_tiles << " tiles written (" << elapsed << " s)" << std::endl;
+}
@@ -0,0 +1,49 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+#ifndef WRITE_TILES_H
+#define WRITE_TILES_H
+
+#include "tiling_progress.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Leaves are independent once the bsp is filled: the tile writers write n_threads of them at a time
+// (one task per leaf, any thread). Progress is reported every 10% of the tiles.
+void write_tiles (const std::vector<int> &leaves, const unsigned int n_threads, const std::function<void(const int)> &write_leaf,
+                  const ProgressCallback &progress = console_progress);
+
+void log_tile (const std::string &line);      // one whole line, whatever the writing thread
+
+#ifndef OOCTRITILELIB_STATIC
+#include "write_tiles.cpp"
+#endif
+
+#endif // WRITE_TILES_H
@@ -0,0 +1,195 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#include "write_tileset.h"
+#include "write_manifest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+static std::string json_string (const std::string &s)
+{
+    std::string escaped = "\"";
+
+    for (const char c : s)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+
+        escaped += c;
+    }
+
+    return escaped + "\"";
+}
+
+// Tile of a cell and of its subtree (false if none has points): bounding box of the subtree and geometric error,
+// i.e. the spacing of the points of the cell (0 for leaves), never below the error of the children
+static bool tileset_node (const BspCell &cell, const std::string &out_directory, const std::string &indent,
+                          std::string &json, double min[3], double max[3], double &geometric_error)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        min[i] =  DBL_MAX;
+        max[i] = -DBL_MAX;
+    }
+
+    geometric_error = 0;
+
+    std::vector<std::string> children;
+
+    if (cell.left != NULL)
+    {
+        const BspCell *child_cells[2] = { cell.left, cell.right };
+
+        for (const BspCell *child : child_cells)
+        {
+            std::string child_json;
+            double child_min[3], child_max[3], child_error = 0;
+
+            if (!tileset_node(*child, out_directory, indent + "    ", child_json, child_min, child_max, child_error))
+                continue;
+
+            children.push_back(child_json);
+
+            for (int i = 0; i < 3; i++)
+            {
+                min[i] = std::min(min[i], child_min[i]);
+                max[i] = std::max(max[i], child_max[i]);
+            }
+
+            geometric_error = std::max(geometric_error, child_error);
+        }
+    }
+
+    const bool has_content = cell.n_inner_vertices > 0 && !cell.filename_mesh.empty();
+
+    if (!has_content && children.empty())
+        return false;
+
+    if (has_content)
+    {
+        const double cell_min[3] = { cell.bbox_min.x, cell.bbox_min.y, cell.bbox_min.z };
+        const double cell_max[3] = { cell.bbox_max.x, cell.bbox_max.y, cell.bbox_max.z };
+
+        for (int i = 0; i < 3; i++)
+        {
+            min[i] = std::min(min[i], cell.statistics.is_empty() ? cell_min[i] : cell.statistics.min[i]);
+            max[i] = std::max(max[i], cell.statistics.is_empty() ? cell_max[i] : cell.statistics.max[i]);
+        }
+    }
+
+    if (has_content && cell.left != NULL)
+    {
+        // spacing of a sample of (mostly) surfaces: on the xy footprint, or along the longest side if flat
+        const double dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+
+        const double spacing = (dx * dy > 0) ? std::sqrt(dx * dy / cell.n_inner_vertices)
+                                             : std::max(dx, std::max(dy, dz)) / cell.n_inner_vertices;
+
+        geometric_error = std::max(geometric_error, spacing);
+    }
+
+    std::ostringstream os;
+    os << std::setprecision(15);
+
+    os << indent << "{" << std::endl;
+    os << indent << "  \"boundingVolume\": { \"box\": ["
+       << (min[0] + max[0]) / 2 << ", " << (min[1] + max[1]) / 2 << ", " << (min[2] + max[2]) / 2 << ", "
+       << (max[0] - min[0]) / 2 << ", 0, 0, 0, " << (max[1] - min[1]) / 2 << ", 0, 0, 0, " << (max[2] - min[2]) / 2 << "] }," << std::endl;
+    os << indent << "  \"geometricError\": " << geometric_error;
+
+    if (has_content)
+        os << "," << std::endl << indent << "  \"content\": { \"uri\": " << json_string(relative_tile_filename(cell.filename_mesh, out_directory)) << " }";
+
+    if (!children.empty())
+    {
+        os << "," << std::endl << indent << "  \"children\": [" << std::endl;
+
+        for (unsigned int c = 0; c < children.size(); c++)
+            os << children.at(c) << ((c + 1 < children.size()) ? "," : "") << std::endl;
+
+        os << indent << "  ]";
+    }
+
+    os << std::endl << indent << "}";
+
+    json = os.str();
+
+    return true;
+}
+
+bool write_bsp_tileset (BinarySpacePartition &bsp, const std::string out_directory)
+{
+    std::string root_json;
+    double min[3], max[3], geometric_error = 0;
+
+    if (!tileset_node(bsp.get_root(), out_directory, "    ", root_json, min, max, geometric_error))
+    {
+        std::cerr << "[WARNING] No tiles: no tileset written" << std::endl;
+        return true;
+    }
+
+    // the root takes the refinement of the whole tileset
+    const size_t first_line = root_json.find('\n');
+    root_json.insert(first_line + 1, "      \"refine\": \"REPLACE\",\n");
+
+    const std::string filename = out_directory + "/tileset.json";
+
+    std::ofstream os (filename.c_str(), std::ios::out);
+
+    if (!os.is_open())
+    {
+        std::cerr << "[ERROR] Opening file " << filename << std::endl;
+        return false;
+    }
+
+    os << std::setprecision(15);
+
+    os << "{" << std::endl;
+    os << "  \"asset\": { \"version\": \"1.0\", \"generator\": \"OOCTriTile\" }," << std::endl;
+    os << "  \"geometricError\": " << 2 * geometric_error << "," << std::endl;
+    os << "  \"root\":" << std::endl;
+    os << root_json << std::endl;
+    os << "}" << std::endl;
+
+    os.close();
+
+    if (os.fail())
+    {
+        std::cerr << "[ERROR] Writing file " << filename << std::endl;
+        return false;
+    }
+
+    std::cout << "[OUTPUT] Tileset saved: " << filename << " (" << bsp.get_n_lod_nodes() << " LOD cells)" << std::endl;
+
+    return true;
+}
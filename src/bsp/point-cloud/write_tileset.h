@@ -0,0 +1,44 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+
+#ifndef WRITE_TILESET_H
+#define WRITE_TILESET_H
+
+#include "bsp.h"
+
+// Writes <out_directory>/tileset.json: the bsp as a 3D Tiles like hierarchy for streaming viewers. Inner cells point
+// to their LOD sample (lod_<cell ID>), leaves to their tile; children replace their parent ("refine": "REPLACE").
+// Coordinates are those of the input (no transform), contents are in the output format of the tiling.
+bool write_bsp_tileset (BinarySpacePartition &bsp, const std::string out_directory);
+
+#ifndef OOCTRITILELIB_STATIC
+#include "write_tileset.cpp"
+#endif
+
+#endif // WRITE_TILESET_H
@@ -27,101 +27,137 @@
 *                                                                               *
 *********************************************************************************/
 #include "write_xyz.h"
+#include "write_tiles.h"
+#include "point_codec.h"
+
+#include <map>
+#include <numeric>
 
 void write_bsp_XYZ( BinarySpacePartition &bsp, const std::string out_directory)
 {
-    for (int leaf=0; leaf < bsp.get_n_leaves(); leaf++)
+    std::vector<int> leaves (bsp.get_n_cells());
+    std::iota(leaves.begin(), leaves.end(), 0);
+
+    write_bsp_XYZ(bsp, out_directory, leaves);
+}
+
+static void write_leaf_XYZ (BinarySpacePartition &bsp, const std::string out_directory, const int leaf)
+{
+
+    BspCell *cell = bsp.get_cell(leaf);      // a leaf or a LOD cell
+
+    if (cell->n_inner_vertices == 0)   
     {
-        BspCell *cell = bsp.get_leaf(leaf);
+        remove (cell->filename_inner_v.c_str());
 
-        if (cell->n_inner_vertices == 0)   
+        if (bsp.has_polys())
         {
-            remove (cell->filename_inner_v.c_str());
             remove (cell->filename_boundary_v.c_str());
             remove (cell->filename_inner_t.c_str());
-
-            continue;   
         }
 
-        // read boundary vertices
-        std::set<stxxl::uint64> added_vertices;
+        return;
+    }
+
+    // read boundary vertices (meshes only): id and coordinates, by id (a vertex may be added more than once)
+    std::map<stxxl::uint64, Point> added_vertices;
 
-        std::ifstream cell_stream (cell->filename_boundary_v.c_str(), std::fstream::in | std::fstream::binary);
+    std::ifstream cell_stream;
 
-        if (!cell_stream.is_open())
+    if (bsp.has_polys())
+        cell_stream.open(cell->filename_boundary_v.c_str(), std::fstream::in | std::fstream::binary);
+
+    if (!cell_stream.is_open())
+    {
+        if (bsp.has_polys())
+            log_tile("[WARNING] No additional vertices.");
+    }
+    else
+    {
+        stxxl::uint64 vertex;
+        Point point;
+
+        while (cell_stream.read (reinterpret_cast<char *>(&vertex),sizeof(vertex)) &&
+               cell_stream.read (reinterpret_cast<char *>(&point.x),sizeof(point.x)) &&
+               cell_stream.read (reinterpret_cast<char *>(&point.y),sizeof(point.y)) &&
+               cell_stream.read (reinterpret_cast<char *>(&point.z),sizeof(point.z)))
         {
-            std::cout << "[WARNING] No additional vertices." << std::endl;
+            added_vertices[vertex] = point;
         }
-        else
-        {
-            stxxl::uint64 vertex;
 
-            while (cell_stream.read (reinterpret_cast<char *>(&vertex),sizeof(vertex)) && !cell_stream.fail())
-            {
-                added_vertices.insert(vertex);
-            }
+        cell_stream.close();
+    }
 
-            cell_stream.close();
-        }
+    cell_stream.open(cell->filename_inner_v.c_str(), std::fstream::in | std::fstream::binary);
 
-        cell_stream.open(cell->filename_inner_v.c_str());
+    if (!cell_stream.is_open())
+    {
+        std::cout << "[ERROR] Opening file " << cell->filename_inner_v << std::endl;
+        exit(1);
+    }
 
-        if (!cell_stream.is_open())
-        {
-            std::cout << "[ERROR] Opening file " << cell->filename_inner_v << std::endl;
-            exit(1);
-        }
+    std::string out_filename = out_directory + bsp.get_cell_name(leaf) + ".xyz";
+    std::string local2global_filename = out_directory + bsp.get_cell_name(leaf) + "_v_loc2glob";
 
-        std::string out_filename = out_directory + "cell_" + std::to_string(leaf) + ".xyz";
-        std::string local2global_filename = out_directory + "cell_" + std::to_string(leaf) + "_v_loc2glob";
+    cell->filename_mesh = out_filename;
+    cell->filename_local2global = local2global_filename;
 
-        cell->filename_mesh = out_filename;
-        cell->filename_local2global = local2global_filename;
+    log_tile("[OUTPUT] Writing " + out_filename);
 
-        std::cout << "[OUTPUT] Writing " << out_filename << std::endl;
+    std::ofstream pc_out_stream (out_filename.c_str(), std::fstream::out);
+    std::ofstream local2global_out_stream (local2global_filename.c_str(), std::fstream::out);
 
-        std::map <stxxl::uint64, int> global_local_vertices;
+    if (!pc_out_stream.is_open() || !local2global_out_stream.is_open())
+    {
+        std::cout << "[ERROR] Opening file " << out_filename <<  " or " << local2global_filename << std::endl;
+        exit(1);
+    }
 
-        std::ofstream pc_out_stream (out_filename.c_str(), std::fstream::out);
-        std::ofstream local2global_out_stream (local2global_filename.c_str(), std::fstream::out);
+    stxxl::uint64 id;
+    double x,y,z;
+    PointAttributes attributes;
 
-        if (!pc_out_stream.is_open() || !local2global_out_stream.is_open())
-        {
-            std::cout << "[ERROR] Opening file " << out_filename <<  " or " << local2global_filename << std::endl;
-            exit(1);
-        }
+    int vid = 0;
 
-        stxxl::uint64 id;
-        double x,y,z;
+    // the attribute columns of the XYZ format (see xyz_attribute_mask): intensity and color
+    const uint8_t attribute_mask = bsp.get_attribute_mask();
 
-        int vid = 0;
+    PointDecoder decoder (bsp.get_resolution(), true, attribute_mask);
 
-        for (; vid < cell->n_inner_vertices; vid++)
+    for (; vid < cell->n_inner_vertices; vid++)
+    {
+        if (!decoder.read(cell_stream, id, x, y, z, &attributes))
         {
-            cell_stream.read (reinterpret_cast<char *>(&id),sizeof(id));
+            std::cout << "[ERROR] Reading file " << cell->filename_inner_v << std::endl;
+            exit(1);
+        }
 
-            cell_stream.read (reinterpret_cast<char *>(&x),sizeof(x));
-            cell_stream.read (reinterpret_cast<char *>(&y),sizeof(y));
-            cell_stream.read (reinterpret_cast<char *>(&z),sizeof(z));
+        pc_out_stream << std::setprecision(10) << x << " " << y << " " << z;
 
-            pc_out_stream << std::setprecision(10) << x << " " << y << " " << z << std::endl;
+        if (attribute_mask & ATTRIBUTE_INTENSITY)
+            pc_out_stream << " " << attributes.intensity;
 
-            global_local_vertices[id] = vid;
+        if (attribute_mask & ATTRIBUTE_RGB)
+            pc_out_stream << " " << attributes.red << " " << attributes.green << " " << attributes.blue;
 
-            local2global_out_stream << id << std::endl;
-        }
+        pc_out_stream << std::endl;
 
-        cell_stream.close();
+        local2global_out_stream << id << std::endl;
+    }
 
-        for (int v : added_vertices)
-        {
-            pc_out_stream << std::setprecision(10) << bsp.get_point(v).x << " " << bsp.get_point(v).y << " " << bsp.get_point(v).z << std::endl;
+    cell_stream.close();
 
-            global_local_vertices[v] = vid++;
+    for (const auto &v : added_vertices)
+    {
+        pc_out_stream << std::setprecision(10) << v.second.x << " " << v.second.y << " " << v.second.z << std::endl;
 
-            local2global_out_stream << v << std::endl;
-        }
+        cell->statistics.add(v.second.x, v.second.y, v.second.z);     // the bounding box of the tile
+
+        local2global_out_stream << v.first << std::endl;
+    }
 
+    if (bsp.has_polys())
+    {
         cell_stream.open(cell->filename_inner_t.c_str(), std::fstream::in | std::fstream::binary);
 
         if (!cell_stream.is_open())
@@ -131,12 +167,21 @@ void write_bsp_XYZ( BinarySpacePartition &bsp, const std::string out_directory)
         }
 
         cell_stream.close();
+    }
 
-        pc_out_stream.close();
-        local2global_out_stream.close();
+    pc_out_stream.close();
+    local2global_out_stream.close();
 
-        remove (cell->filename_inner_v.c_str());
+    remove (cell->filename_inner_v.c_str());
+
+    if (bsp.has_polys())
+    {
         remove (cell->filename_boundary_v.c_str());
         remove (cell->filename_inner_t.c_str());
     }
 }
+
+void write_bsp_XYZ( BinarySpacePartition &bsp, const std::string out_directory, const std::vector<int> &leaves, const unsigned int n_threads)
+{
+    write_tiles(leaves, n_threads, [&](const int leaf) { write_leaf_XYZ(bsp, out_directory, leaf); }, bsp.get_progress());
+}
@@ -33,6 +33,9 @@
 
 void write_bsp_XYZ (BinarySpacePartition &bsp, const std::string out_directory);
 
+// Writes only the given cells (positions in the bsp: leaves, then LOD cells), n_threads tiles at a time
+void write_bsp_XYZ (BinarySpacePartition &bsp, const std::string out_directory, const std::vector<int> &leaves, const unsigned int n_threads = 1);
+
 #ifndef OOC3DTileLib_STATIC
 #include "write_xyz.cpp"
 #endif
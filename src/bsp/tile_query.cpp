@@ -0,0 +1,191 @@
+/********************************************************************************
+*  This file is part of OOCTriTile                                              *
+*  Copyright(C) 2023: Daniela Cabiddu                                           *
+*                                                                               *
+*  Author(s):                                                                   *
+*                                                                               *
+*     Daniela Cabiddu (daniela.cabiddu@cnr.it)                                  *
+*                                                                               *
+*     Italian National Research Council (CNR)                                   *
+*     Institute for Applied Mathematics and Information Technologies (IMATI)    *
+*     Via de Marini, 6                                                          *
+*     16149 Genoa,                                                              *
+*     Italy                                                                     *
+*                                                                               *
+*  This program is free software: you can redistribute it and/or modify it      *
+*  under the terms of the GNU General Public License as published by the        *
+*  Free Software Foundation, either version 3 of the License, or (at your       *
+*  option) any later version.                                                   *
+*                                                                               *
+*  This program is distributed in the hope that it will be useful, but          *
+*  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY   *
+*  or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for  *
+*  more details.                                                                *
+*                                                                               *
+*  You should have received a copy of the GNU General Public License along      *
+*  with this program. If not, see <https://www.gnu.org/licenses/>.              *
+*                                                                               *
+*********************************************************************************/
+#include <cfloat>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "tile_catalog.h"
+#include "tclap/CmdLine.h"
+
+// comma (or blank) separated numbers
+static std::vector<double> parse_numbers (std::string text)
+{
+    for (char &c : text)
+        if (c == ',')
+            c = ' ';
+
+    std::vector<double> numbers;
+    std::istringstream is (text);
+    double v;
+
+    while (is >> v)
+        numbers.push_back(v);
+
+    return numbers;
+}
+
+static void print_tiles (const TileCatalog &catalog, const std::vector<uint32_t> &result)
+{
+    for (const uint32_t t : result)
+    {
+        const TileEntry &tile = catalog.get_tiles().at(t);
+        std::cout << catalog.get_path(tile) << " " << tile.id << " " << tile.n_points << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    TCLAP::CmdLine cmd("Usage: tile_query --manifest <tiles.manifest> [--box <minx,miny[,minz],maxx,maxy[,maxz]> | --polygon <x1,y1,x2,y2,...> | --polygon-file <filename> | --neighbors <tile id>]", ' ', "0.9");
+
+    TCLAP::ValueArg<std::string> manifestArg("m","manifest","tile manifest (tiles.manifest in the output directory of a tiling)",true,"","string");
+    cmd.add( manifestArg );
+
+    TCLAP::ValueArg<std::string> boxArg("b","box","query box: minx,miny,maxx,maxy (any z) or minx,miny,minz,maxx,maxy,maxz",false,"","string");
+    cmd.add( boxArg );
+
+    TCLAP::ValueArg<std::string> polygonArg("p","polygon","query polygon (e.g. a footprint): x1,y1,x2,y2,... (any z)",false,"","string");
+    cmd.add( polygonArg );
+
+    TCLAP::ValueArg<std::string> polygonFileArg("","polygon-file","query polygon from a file: one \"x y\" vertex per line",false,"","string");
+    cmd.add( polygonFileArg );
+
+    TCLAP::ValueArg<std::string> neighborsArg("n","neighbors","tiles adjacent to the given tile id",false,"","int");
+    cmd.add( neighborsArg );
+
+    cmd.parse( argc, argv );
+
+    if (boxArg.isSet() + polygonArg.isSet() + polygonFileArg.isSet() + neighborsArg.isSet() != 1)
+    {
+        std::cerr << "Exactly one inbetween --box, --polygon, --polygon-file and --neighbors MUST be provided" << std::endl;
+        return 1;
+    }
+
+    TileCatalog catalog;
+
+    if (!catalog.load(manifestArg.getValue()))
+    {
+        std::cerr << "[ERROR] Loading the tile manifest " << manifestArg.getValue() << std::endl;
+        return 1;
+    }
+
+    std::vector<uint32_t> result;
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (boxArg.isSet())
+    {
+        const std::vector<double> v = parse_numbers(boxArg.getValue());
+
+        double min[3], max[3];
+
+        if (v.size() == 4)
+        {
+            min[0] = v.at(0); min[1] = v.at(1); min[2] = -DBL_MAX;
+            max[0] = v.at(2); max[1] = v.at(3); max[2] =  DBL_MAX;
+        }
+        else
+        if (v.size() == 6)
+        {
+            min[0] = v.at(0); min[1] = v.at(1); min[2] = v.at(2);
+            max[0] = v.at(3); max[1] = v.at(4); max[2] = v.at(5);
+        }
+        else
+        {
+            std::cerr << "The box needs 4 or 6 values" << std::endl;
+            return 1;
+        }
+
+        catalog.query_box(min, max, result);
+    }
+    else
+    if (polygonArg.isSet() || polygonFileArg.isSet())
+    {
+        std::string text = polygonArg.getValue();
+
+        if (polygonFileArg.isSet())
+        {
+            std::ifstream is (polygonFileArg.getValue().c_str());
+
+            if (!is.is_open())
+            {
+                std::cerr << "[ERROR] Opening file " << polygonFileArg.getValue() << std::endl;
+                return 1;
+            }
+
+            std::stringstream ss;
+            ss << is.rdbuf();
+            text = ss.str();
+        }
+
+        const std::vector<double> v = parse_numbers(text);
+
+        if (v.size() < 6 || v.size() % 2 != 0)
+        {
+            std::cerr << "The polygon needs at least 3 vertices (x y pairs)" << std::endl;
+            return 1;
+        }
+
+        std::vector<std::pair<double, double>> polygon;
+
+        for (size_t i = 0; i < v.size(); i += 2)
+            polygon.push_back(std::make_pair(v.at(i), v.at(i+1)));
+
+        catalog.query_polygon(polygon, result);
+    }
+    else
+    {
+        const int id = std::atoi(neighborsArg.getValue().c_str());
+        const TileEntry *tile = catalog.find(id);
+
+        if (tile == nullptr)
+        {
+            std::cerr << "[ERROR] No tile " << id << " in the manifest" << std::endl;
+            return 1;
+        }
+
+        for (const int32_t n : tile->neighbors)
+        {
+            const TileEntry *neighbor = catalog.find(n);
+
+            if (neighbor != nullptr)
+                result.push_back(neighbor - catalog.get_tiles().data());
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    print_tiles(catalog, result);
+
+    std::cerr << "[QUERY] " << result.size() << " of " << catalog.get_tiles().size() << " tiles ("
+              << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << " us)" << std::endl;
+
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "pc_reader.h"
+#include "peak_rss.h"
 
 #include <PointCloud.h>
 #include <RansacShapeDetector.h>
@@ -8,15 +9,85 @@
 #include <ConePrimitiveShapeConstructor.h>
 #include <TorusPrimitiveShapeConstructor.h>
 
+#include <algorithm>
 #include <cfloat>
+#include <chrono>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <tclap/CmdLine.h>
 
+// Per tile record of a run (a line of the --metrics file, see ransac_summary)
+struct TileMetrics
+{
+    size_t points = 0;
+
+    double load_seconds = 0;
+    double normals_seconds = 0;
+    double detection_seconds = 0;
+    double output_seconds = 0;
+
+    size_t shapes = 0;
+    size_t planes = 0, cylinders = 0, spheres = 0, cones = 0, tori = 0;
+
+    size_t support = 0;         // points assigned to a shape
+    size_t max_support = 0;     // of the largest shape
+    size_t unassigned = 0;
+};
+
+static double seconds_since (const std::chrono::steady_clock::time_point &start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string json_string (const std::string &s)
+{
+    std::string escaped = "\"";
+
+    for (const char c : s)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+
+        escaped += c;
+    }
+
+    return escaped + "\"";
+}
+
+// Appends the record of the tile: several runs (e.g. one per tile) share the file
+static bool append_metrics (const std::string &filename, const std::string &tile, const TileMetrics &m, const float min_support)
+{
+    std::ofstream ofile (filename, std::ios::out | std::ios::app);
+
+    if (!ofile.is_open())
+    {
+        std::cerr << "Error opening " << filename << std::endl;
+        return false;
+    }
+
+    const double total = m.load_seconds + m.normals_seconds + m.detection_seconds + m.output_seconds;
+
+    ofile << std::setprecision(9)
+          << "{\"tile\": " << json_string(tile) << ", \"points\": " << m.points
+          << ", \"load_seconds\": " << m.load_seconds << ", \"normals_seconds\": " << m.normals_seconds
+          << ", \"detection_seconds\": " << m.detection_seconds << ", \"output_seconds\": " << m.output_seconds
+          << ", \"total_seconds\": " << total
+          << ", \"min_support\": " << min_support
+          << ", \"shapes\": " << m.shapes << ", \"planes\": " << m.planes << ", \"cylinders\": " << m.cylinders
+          << ", \"spheres\": " << m.spheres << ", \"cones\": " << m.cones << ", \"tori\": " << m.tori
+          << ", \"support\": " << m.support << ", \"max_support\": " << m.max_support << ", \"unassigned\": " << m.unassigned
+          << ", \"peak_rss_bytes\": " << get_peak_rss() << "}" << std::endl;
+
+    return !ofile.fail();
+}
+
 int main(int argc, char **argv)
 {
     std::string input_filename;
     std::string output_directory;
+    std::string metrics_filename;
+    unsigned int feature_mask = 0;      // FEATURE_* columns of the input (--xyz-columns)
 
     bool detect_plane = false;
     bool detect_cylinder = false;
@@ -55,6 +126,10 @@ int main(int argc, char **argv)
         TCLAP::ValueArg<std::string> supportArg ("s","support","",false,"","float");
         TCLAP::ValueArg<std::string> probabilityArg ("p","probability","",false,"","float");
 
+        TCLAP::ValueArg<std::string> columnsArg ("","xyz-columns","Columns of the input [xyz (default) |xyzi |xyzrgb |xyzirgb] (i: intensity, rgb: color, kept with the points of the shapes)",false,"","string");
+
+        TCLAP::ValueArg<std::string> metricsArg ("m","metrics","Append the timings and results of the tile to this file (a JSON record per line)",false,"","string");
+
 
         cmd.add( inputFileArg );
         cmd.add( outputDirArg );
@@ -70,11 +145,21 @@ int main(int argc, char **argv)
         cmd.add(supportArg);
         cmd.add(probabilityArg);
 
+        cmd.add(columnsArg);
+        cmd.add(metricsArg);
+
         // Parse the argv array.
         cmd.parse( argc, argv );
 
         input_filename = inputFileArg.getValue();
         output_directory = outputDirArg.getValue();
+        metrics_filename = metricsArg.getValue();
+
+        if (columnsArg.isSet() && !xyz_feature_mask(columnsArg.getValue(), feature_mask))
+        {
+            std::cerr << "Error. Unsupported columns: " << columnsArg.getValue() << std::endl;
+            return 2;
+        }
 
         detect_plane = planeSwitch.isSet();
         detect_cylinder = cylinderSwitch.isSet();
@@ -109,11 +194,19 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    TileMetrics metrics;
+
+    std::chrono::steady_clock::time_point stage_start = std::chrono::steady_clock::now();
+
     MiscLib::Vector<Point> points;
     double minx, miny, minz;
     double maxx, maxy, maxz;
 
-    read_input_pc(input_filename, points, minx, miny, minz, maxx, maxy, maxz);
+    // intensity and color of the tiles, if any: kept with the points of the shapes
+    std::vector<PointFeatures> features;
+
+    if (!read_input_pc(input_filename, points, features, feature_mask, minx, miny, minz, maxx, maxy, maxz))
+        return 1;
 
     PointCloud pc;
 
@@ -139,9 +232,17 @@ int main(int argc, char **argv)
 
     // set the bbox in pc
     pc.setBBox(bbmin, bbmax);
+
+    metrics.points = pc.size();
+    metrics.load_seconds = seconds_since(stage_start);
+
+    stage_start = std::chrono::steady_clock::now();
+
     //void calcNormals( float radius, unsigned int kNN = 20, unsigned int maxTries = 100 );
     pc.calcNormals(3);
 
+    metrics.normals_seconds = seconds_since(stage_start);
+
     if (!(m_minSupport < FLT_MAX))
         m_minSupport = 0.005 * points.size();
 
@@ -183,6 +284,8 @@ int main(int argc, char **argv)
 
     std::cout << "Running RANSAC Detection ..." << std::endl;
 
+    stage_start = std::chrono::steady_clock::now();
+
     MiscLib::Vector< std::pair< MiscLib::RefCountPtr< PrimitiveShape >, size_t > > shapes; // stores the detected shapes
     size_t remaining = detector.Detect(pc, 0, pc.size(), &shapes); // run detection
         // returns number of unassigned points
@@ -193,11 +296,19 @@ int main(int argc, char **argv)
         // the points of shape i are found in the range
         // [ pc.size() - \sum_{j=0..i} shapes[j].second, pc.size() - \sum_{j=0..i-1} shapes[j].second )
 
+    metrics.detection_seconds = seconds_since(stage_start);
+
     std::cout << "Running RANSAC Detection ... COMPLETED" << std::endl;
 
     std::cout << "Remaining Unassigned Points " << remaining << std::endl;
 
-    uint start = pc.size() - shapes[0].second;
+    metrics.shapes = shapes.size();
+    metrics.unassigned = remaining;
+
+    stage_start = std::chrono::steady_clock::now();
+
+    // tiles where nothing is detected have no shapes at all
+    uint start = shapes.empty() ? pc.size() : pc.size() - shapes[0].second;
     uint end = pc.size();
 
     for(uint i=0; i<shapes.size(); i++)
@@ -205,9 +316,37 @@ int main(int argc, char **argv)
         std::string desc;
         shapes[i].first->Description(&desc);
 
+        metrics.support += shapes[i].second;
+        metrics.max_support = std::max(metrics.max_support, (size_t) shapes[i].second);
+
+        if (desc.compare("Plane") == 0)    metrics.planes++;
+        if (desc.compare("Cylinder") == 0) metrics.cylinders++;
+        if (desc.compare("Sphere") == 0)   metrics.spheres++;
+        if (desc.compare("Cone") == 0)     metrics.cones++;
+        if (desc.compare("Torus") == 0)    metrics.tori++;
+
         std::cout << "shape " << i << " consists of " << shapes[i].second << " points, it is a " << desc
                   << " [" << start << ", " << end << "] " << std::endl;
 
+        if (feature_mask != 0 && shapes[i].second > 0)
+        {
+            PointFeatures mean;
+
+            for (uint p=0; p < shapes[i].second; p++)
+            {
+                const PointFeatures &f = features.at(pc.at(start+p).index);
+
+                mean.intensity += f.intensity;
+                mean.red += f.red; mean.green += f.green; mean.blue += f.blue;
+            }
+
+            if (feature_mask & FEATURE_INTENSITY)
+                std::cout << "      mean intensity " << mean.intensity / shapes[i].second << std::endl;
+
+            if (feature_mask & FEATURE_RGB)
+                std::cout << "      mean color " << mean.red / shapes[i].second << " " << mean.green / shapes[i].second << " " << mean.blue / shapes[i].second << std::endl;
+        }
+
         std::string filename = output_directory + "/" + desc + "_" + std::to_string(i) + ".txt";
         std::ofstream ofile;
         ofile.open(filename);
@@ -219,15 +358,37 @@ int main(int argc, char **argv)
         else
         {
             for (uint p=0; p < shapes[i].second; p++)
+            {
                 ofile << std::setprecision(8)
                       << pc.at(start+p).pos[0] + minx << " "
                       << pc.at(start+p).pos[1] + miny << " "
-                      << pc.at(start+p).pos[2] + minz << std::endl;
+                      << pc.at(start+p).pos[2] + minz;
+
+                if (feature_mask != 0)
+                {
+                    const PointFeatures &f = features.at(pc.at(start+p).index);
+
+                    if (feature_mask & FEATURE_INTENSITY)
+                        ofile << " " << f.intensity;
+
+                    if (feature_mask & FEATURE_RGB)
+                        ofile << " " << f.red << " " << f.green << " " << f.blue;
+                }
+
+                ofile << std::endl;
+            }
 
             ofile.close();
         }
 
         end = start;
-        start = end - shapes[i+1].second;
+
+        if (i + 1 < shapes.size())
+            start = end - shapes[i+1].second;
     }
+
+    metrics.output_seconds = seconds_since(stage_start);
+
+    if (!metrics_filename.empty() && !append_metrics(metrics_filename, input_filename, metrics, m_minSupport))
+        std::cerr << "Error writing " << metrics_filename << std::endl;
 }
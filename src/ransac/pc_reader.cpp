@@ -1,21 +1,54 @@
 #include "pc_reader.h"
 
 #include <cfloat>
+#include <cstdlib>
 #include <fstream>
 #include <vector>
 
+bool xyz_feature_mask (const std::string &columns, unsigned int &feature_mask)
+{
+    if (columns.compare("xyz") == 0)
+        feature_mask = 0;
+    else
+    if (columns.compare("xyzi") == 0)
+        feature_mask = FEATURE_INTENSITY;
+    else
+    if (columns.compare("xyzrgb") == 0)
+        feature_mask = FEATURE_RGB;
+    else
+    if (columns.compare("xyzirgb") == 0)
+        feature_mask = FEATURE_INTENSITY | FEATURE_RGB;
+    else
+        return false;
+
+    return true;
+}
+
 bool read_input_pc (const std::string filename, MiscLib::Vector<Point> &points,
                    double &minx, double &miny, double &minz,
                    double &maxx, double &maxy, double &maxz)
 {
-    if (filename.substr(filename.find_first_of(".")).compare(".xyz") == 0)
-        return read_input_xyz (filename, points, minx, miny, minz, maxx, maxy, maxz);
+    std::vector<PointFeatures> features;
+
+    return read_input_pc (filename, points, features, 0, minx, miny, minz, maxx, maxy, maxz);
+}
+
+bool read_input_pc (const std::string filename, MiscLib::Vector<Point> &points,
+                   std::vector<PointFeatures> &features, const unsigned int feature_mask,
+                   double &minx, double &miny, double &minz,
+                   double &maxx, double &maxy, double &maxz)
+{
+    const size_t ext_pos = filename.find_last_of(".");
+
+    if (ext_pos != std::string::npos && filename.substr(ext_pos).compare(".xyz") == 0)
+        return read_input_xyz (filename, points, features, feature_mask, minx, miny, minz, maxx, maxy, maxz);
 
     std::cerr << "Unsupport file format: " << filename << std::endl;
     return false;
 }
 
 bool read_input_xyz (const std::string filename, MiscLib::Vector<Point> &points,
+                    std::vector<PointFeatures> &features, const unsigned int feature_mask,
                     double &minx, double &miny, double &minz,
                     double &maxx, double &maxy, double &maxz)
 {
@@ -42,8 +75,55 @@ bool read_input_xyz (const std::string filename, MiscLib::Vector<Point> &points,
     std::vector<double> yy;
     std::vector<double> zz;
 
-    while (file >> x >> y >> z)
+    features.clear();
+
+    std::string line;
+    unsigned int n_line = 0;
+
+    // a feature column: a number, not the end of the line
+    auto read_feature = [&](const char *&ptr, float &value) -> bool
+    {
+        char *end;
+
+        value = strtof(ptr, &end);
+
+        if (end == ptr)
+            return false;
+
+        ptr = end;
+        return true;
+    };
+
+    while (std::getline(file, line))
     {
+        n_line++;
+
+        const char *ptr = line.c_str();
+        char *end;
+
+        x = strtod(ptr, &end); ptr = end;
+        y = strtod(ptr, &end); ptr = end;
+        z = strtod(ptr, &end);
+
+        if (end == ptr)
+            continue;
+
+        ptr = end;
+
+        PointFeatures point_features;
+
+        if (((feature_mask & FEATURE_INTENSITY) && !read_feature(ptr, point_features.intensity)) ||
+            ((feature_mask & FEATURE_RGB) && (!read_feature(ptr, point_features.red) ||
+                                              !read_feature(ptr, point_features.green) ||
+                                              !read_feature(ptr, point_features.blue))))
+        {
+            std::cerr << "Error reading " << filename << ": line " << n_line << " has fewer columns than declared" << std::endl;
+            return false;
+        }
+
+        if (feature_mask != 0)
+            features.push_back(point_features);
+
         //points.push_back(Point(Vec3f(x,y,z)));
         xx.push_back(x);
         yy.push_back(y);
@@ -62,7 +142,10 @@ bool read_input_xyz (const std::string filename, MiscLib::Vector<Point> &points,
 
     for (uint i=0; i < xx.size(); i++)
     {
-        points.push_back(Point(Vec3f(xx[i]-minx,yy[i]-miny,zz[i]-minz)));
+        Point point (Vec3f(xx[i]-minx,yy[i]-miny,zz[i]-minz));
+        point.index = i;
+
+        points.push_back(point);
     }
 
     std::cout << "Loaded " << points.size() << " points" << std::endl;
@@ -2,9 +2,31 @@
 #define PC_READER_H
 
 #include "PointCloud.h"
+
+#include <vector>
+
+// Attribute columns of the tiles, after x y z: [intensity] [r g b]. The layout is given (as --xyz-columns of the
+// tiler: "xyz", "xyzi", "xyzrgb" or "xyzirgb"), never guessed; further columns are ignored.
+#define FEATURE_INTENSITY   0x01
+#define FEATURE_RGB         0x02
+
+struct PointFeatures
+{
+    float intensity = 0;
+    float red = 0, green = 0, blue = 0;
+};
+
+// FEATURE_* columns of a layout. Returns false on an unknown layout.
+bool xyz_feature_mask(const std::string &columns, unsigned int &feature_mask);
+
 bool read_input_pc(const std::string filename, MiscLib::Vector<Point> &points, double &minx, double &miny, double &minz, double &maxx, double &maxy, double &maxz);
 
-bool read_input_xyz(const std::string filename, MiscLib::Vector<Point> &points,
+// features: per point, by Point::index (the line of the point in the file), of the FEATURE_* columns of feature_mask.
+// Fails on a point with fewer columns than the mask.
+bool read_input_pc(const std::string filename, MiscLib::Vector<Point> &points, std::vector<PointFeatures> &features, const unsigned int feature_mask,
+                   double &minx, double &miny, double &minz, double &maxx, double &maxy, double &maxz);
+
+bool read_input_xyz(const std::string filename, MiscLib::Vector<Point> &points, std::vector<PointFeatures> &features, const unsigned int feature_mask,
                     double &minx, double &miny, double &minz,
                     double &maxx, double &maxy, double &maxz);
 
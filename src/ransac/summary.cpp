@@ -0,0 +1,245 @@
+// Summary of the per tile records of ransac (--metrics): totals, distribution of the stage times, slowest tiles.
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <tclap/CmdLine.h>
+
+struct TileRecord
+{
+    std::string tile;
+
+    double points = 0;
+
+    double load_seconds = 0;
+    double normals_seconds = 0;
+    double detection_seconds = 0;
+    double output_seconds = 0;
+    double total_seconds = 0;
+
+    double shapes = 0;
+    double planes = 0, cylinders = 0, spheres = 0, cones = 0, tori = 0;
+
+    double support = 0;
+    double unassigned = 0;
+    double peak_rss_bytes = 0;
+};
+
+// Records are flat, as ransac writes them: "key": number or "key": "string"
+static bool find_value (const std::string &line, const std::string &key, size_t &pos)
+{
+    pos = line.find("\"" + key + "\":");
+
+    if (pos == std::string::npos)
+        return false;
+
+    pos += key.size() + 3;
+
+    while (pos < line.size() && line[pos] == ' ')
+        pos++;
+
+    return pos < line.size();
+}
+
+static double number_value (const std::string &line, const std::string &key)
+{
+    size_t pos;
+
+    if (!find_value(line, key, pos))
+        return 0;
+
+    return std::atof(line.c_str() + pos);
+}
+
+static std::string string_value (const std::string &line, const std::string &key)
+{
+    size_t pos;
+    std::string value;
+
+    if (!find_value(line, key, pos) || line[pos] != '"')
+        return value;
+
+    for (pos++; pos < line.size() && line[pos] != '"'; pos++)
+    {
+        if (line[pos] == '\\' && pos + 1 < line.size())
+            pos++;
+
+        value += line[pos];
+    }
+
+    return value;
+}
+
+static bool read_records (const std::string &filename, std::vector<TileRecord> &records)
+{
+    std::ifstream file (filename);
+
+    if (!file.is_open())
+    {
+        std::cerr << "Error opening " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        if (line.find('{') == std::string::npos)
+            continue;
+
+        TileRecord r;
+
+        r.tile              = string_value(line, "tile");
+        r.points            = number_value(line, "points");
+        r.load_seconds      = number_value(line, "load_seconds");
+        r.normals_seconds   = number_value(line, "normals_seconds");
+        r.detection_seconds = number_value(line, "detection_seconds");
+        r.output_seconds    = number_value(line, "output_seconds");
+        r.total_seconds     = number_value(line, "total_seconds");
+        r.shapes            = number_value(line, "shapes");
+        r.planes            = number_value(line, "planes");
+        r.cylinders         = number_value(line, "cylinders");
+        r.spheres           = number_value(line, "spheres");
+        r.cones             = number_value(line, "cones");
+        r.tori              = number_value(line, "tori");
+        r.support           = number_value(line, "support");
+        r.unassigned        = number_value(line, "unassigned");
+        r.peak_rss_bytes    = number_value(line, "peak_rss_bytes");
+
+        records.push_back(r);
+    }
+
+    return true;
+}
+
+static double percentile (std::vector<double> values, const double p)
+{
+    if (values.empty())
+        return 0;
+
+    std::sort(values.begin(), values.end());
+
+    return values.at(std::min(values.size() - 1, (size_t) (p * (values.size() - 1) + 0.5)));
+}
+
+static void print_stage (const std::string &name, const std::vector<TileRecord> &records, double TileRecord::*field)
+{
+    std::vector<double> values;
+    double total = 0;
+
+    for (const TileRecord &r : records)
+    {
+        values.push_back(r.*field);
+        total += r.*field;
+    }
+
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(12) << total
+              << std::setw(10) << total / records.size()
+              << std::setw(10) << percentile(values, 0.5)
+              << std::setw(10) << percentile(values, 0.95)
+              << std::setw(10) << percentile(values, 1.0) << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::string input_filename;
+    unsigned int n_slowest = 10;
+
+    try {
+
+        TCLAP::CmdLine cmd("Summary of the tile records of ransac --metrics", ' ', "0.9");
+
+        TCLAP::ValueArg<std::string> inputFileArg ("i","input","Metrics file (a JSON record per tile and line)",true,"","string");
+        TCLAP::ValueArg<std::string> slowestArg ("n","slowest","Number of slowest tiles listed (default: 10)",false,"","int");
+
+        cmd.add( inputFileArg );
+        cmd.add( slowestArg );
+
+        cmd.parse( argc, argv );
+
+        input_filename = inputFileArg.getValue();
+
+        if (slowestArg.isSet())
+            n_slowest = std::atoi(slowestArg.getValue().c_str());
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<TileRecord> records;
+
+    if (!read_records(input_filename, records))
+        return 1;
+
+    if (records.empty())
+    {
+        std::cerr << "No tile records in " << input_filename << std::endl;
+        return 1;
+    }
+
+    TileRecord sum;
+    double max_rss = 0;
+
+    for (const TileRecord &r : records)
+    {
+        sum.points += r.points;
+        sum.total_seconds += r.total_seconds;
+        sum.shapes += r.shapes;
+        sum.planes += r.planes; sum.cylinders += r.cylinders; sum.spheres += r.spheres; sum.cones += r.cones; sum.tori += r.tori;
+        sum.support += r.support;
+        sum.unassigned += r.unassigned;
+
+        max_rss = std::max(max_rss, r.peak_rss_bytes);
+    }
+
+    std::cout << std::fixed << std::setprecision(0);
+
+    std::cout << "Tiles: " << records.size() << ", points: " << sum.points << std::endl;
+    std::cout << "Shapes: " << sum.shapes << " (" << sum.planes << " planes, " << sum.cylinders << " cylinders, "
+              << sum.spheres << " spheres, " << sum.cones << " cones, " << sum.tori << " tori)" << std::endl;
+    std::cout << "Assigned points: " << sum.support << ", unassigned: " << sum.unassigned << std::setprecision(1)
+              << " (" << ((sum.points > 0) ? 100 * sum.unassigned / sum.points : 0) << "%)" << std::endl;
+    std::cout << "Peak memory of a tile: " << max_rss / (1024 * 1024) << " MB" << std::endl;
+    std::cout << std::endl;
+
+    std::cout << std::left << std::setw(12) << "seconds" << std::right
+              << std::setw(12) << "total" << std::setw(10) << "mean" << std::setw(10) << "p50"
+              << std::setw(10) << "p95" << std::setw(10) << "max" << std::endl;
+
+    print_stage("load", records, &TileRecord::load_seconds);
+    print_stage("normals", records, &TileRecord::normals_seconds);
+    print_stage("detection", records, &TileRecord::detection_seconds);
+    print_stage("output", records, &TileRecord::output_seconds);
+    print_stage("total", records, &TileRecord::total_seconds);
+
+    // the tiles dominating the wall time, and their share of it
+    std::vector<TileRecord> slowest = records;
+
+    std::sort(slowest.begin(), slowest.end(), [](const TileRecord &a, const TileRecord &b) { return a.total_seconds > b.total_seconds; });
+
+    slowest.resize(std::min((size_t) n_slowest, slowest.size()));
+
+    std::cout << std::endl << "Slowest tiles:" << std::endl;
+
+    double cumulated = 0;
+
+    for (const TileRecord &r : slowest)
+    {
+        cumulated += r.total_seconds;
+
+        std::cout << std::setprecision(3) << std::setw(10) << r.total_seconds << " s"
+                  << std::setprecision(1) << std::setw(7) << ((sum.total_seconds > 0) ? 100 * cumulated / sum.total_seconds : 0) << "%"
+                  << std::setprecision(0) << std::setw(10) << r.points << " points"
+                  << std::setw(5) << r.shapes << " shapes"
+                  << std::setprecision(3) << "  (detection " << r.detection_seconds << " s)  " << r.tile << std::endl;
+    }
+
+    return 0;
+}